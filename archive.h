@@ -0,0 +1,340 @@
+// archive.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <fstream>
+#include <ostream>
+#include <unordered_map>
+#include "sales.h"
+#include "report.h"
+#include "mmap_file.h"
+using namespace std;
+
+// Columnar sales archive, one file per closed day.
+// Layout: ArchiveHeader, then every column as a plain array (8-byte aligned)
+// at the offset stored in header.col[]. Strings (sale ids, customer ids,
+// cashier ids, barcodes) live once in a shared dictionary and rows refer to
+// them by index. Readers mmap the file and use the arrays in place.
+const char ARCHIVE_MAGIC[4] = {'S','M','S','A'};
+const uint32_t ARCHIVE_VERSION = 1;
+
+enum ArchiveColumn {
+    COL_SALE_ID,      // uint32  string id per row
+    COL_CUSTOMER,     // uint32  string id per row
+    COL_CASHIER,      // uint32  string id per row
+    COL_ONLINE,       // uint8   per row
+    COL_TOTAL,        // int64   piasters per row
+    COL_TIME,         // int64   YYYYMMDDhhmmss per row
+    COL_ITEM_START,   // uint64  rows+1 offsets into the item columns
+    COL_ITEM_BARCODE, // uint32  string id per item
+    COL_ITEM_QTY,     // int32   per item
+    COL_STR_OFFSET,   // uint64  strings+1 offsets into the blob
+    COL_STR_BLOB,     // char    concatenated string bytes
+    ARCHIVE_COLUMNS
+};
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t rows;
+    uint64_t items;
+    uint64_t strings;
+    uint64_t col[ARCHIVE_COLUMNS];
+};
+
+// "2025-12-01 14:05:09" -> 20251201140509
+inline long long pack_time(const string& t) {
+    long long v = 0;
+    for (char ch : t) if (ch >= '0' && ch <= '9') v = v * 10 + (ch - '0');
+    return v;
+}
+
+// writes the ledger oldest sale first; returns false if the file can't be written.
+// Goes through path + ".tmp" and a rename, so path is either whole or absent.
+inline bool write_sales_archive(const string& path, const vector<const SaleRecord*>& ledger) {
+    vector<string_view> strs;
+    unordered_map<string_view, uint32_t> dict;
+    auto intern = [&](const string& s) -> uint32_t {
+        auto it = dict.find(s);
+        if (it != dict.end()) return it->second;
+        uint32_t id = (uint32_t)strs.size();
+        strs.push_back(s);
+        dict.emplace(s, id);
+        return id;
+    };
+
+    size_t rows = ledger.size();
+    vector<uint32_t> saleId(rows), customer(rows), cashier(rows);
+    vector<uint8_t> online(rows);
+    vector<int64_t> total(rows), when(rows);
+    vector<uint64_t> itemStart(rows + 1, 0);
+    vector<uint32_t> itemBarcode;
+    vector<int32_t> itemQty;
+    for (size_t r = 0; r < rows; ++r) {
+        const SaleRecord* s = ledger[rows - 1 - r]; // ledger is newest first
+        saleId[r] = intern(s->saleId);
+        customer[r] = intern(s->customerId);
+        cashier[r] = intern(s->cashierId);
+        online[r] = s->online ? 1 : 0;
+        total[r] = to_piasters(s->total);
+        when[r] = pack_time(s->time);
+        itemStart[r] = itemBarcode.size();
+        for (auto &it : s->items) {
+            itemBarcode.push_back(intern(it.first));
+            itemQty.push_back(it.second);
+        }
+    }
+    itemStart[rows] = itemBarcode.size();
+    vector<uint64_t> strOffset(strs.size() + 1, 0);
+    for (size_t i = 0; i < strs.size(); ++i) strOffset[i + 1] = strOffset[i] + strs[i].size();
+
+    string tmp = path + ".tmp";
+    ofstream out(tmp, ios::binary | ios::trunc);
+    if (!out) return false;
+    ArchiveHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ARCHIVE_MAGIC, 4);
+    h.version = ARCHIVE_VERSION;
+    h.rows = rows;
+    h.items = itemBarcode.size();
+    h.strings = strs.size();
+
+    uint64_t pos = sizeof(ArchiveHeader);
+    out.write((const char*)&h, sizeof(h)); // rewritten once the offsets are known
+    auto column = [&](ArchiveColumn c, const void* p, size_t bytes) {
+        static const char pad[8] = {0};
+        uint64_t aligned = (pos + 7) & ~uint64_t(7);
+        out.write(pad, (streamsize)(aligned - pos));
+        h.col[c] = aligned;
+        out.write((const char*)p, (streamsize)bytes);
+        pos = aligned + bytes;
+    };
+    column(COL_SALE_ID, saleId.data(), rows * sizeof(uint32_t));
+    column(COL_CUSTOMER, customer.data(), rows * sizeof(uint32_t));
+    column(COL_CASHIER, cashier.data(), rows * sizeof(uint32_t));
+    column(COL_ONLINE, online.data(), rows);
+    column(COL_TOTAL, total.data(), rows * sizeof(int64_t));
+    column(COL_TIME, when.data(), rows * sizeof(int64_t));
+    column(COL_ITEM_START, itemStart.data(), itemStart.size() * sizeof(uint64_t));
+    column(COL_ITEM_BARCODE, itemBarcode.data(), itemBarcode.size() * sizeof(uint32_t));
+    column(COL_ITEM_QTY, itemQty.data(), itemQty.size() * sizeof(int32_t));
+    column(COL_STR_OFFSET, strOffset.data(), strOffset.size() * sizeof(uint64_t));
+    h.col[COL_STR_BLOB] = pos;
+    for (auto &s : strs) out.write(s.data(), (streamsize)s.size());
+    out.seekp(0);
+    out.write((const char*)&h, sizeof(h));
+    out.close();
+    if (!out) { remove(tmp.c_str()); return false; }
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    int fd = ::open(tmp.c_str(), O_RDONLY);
+    if (fd >= 0) { fsync(fd); ::close(fd); }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+#endif
+}
+
+// Bounded-memory text output: rows are formatted into a fixed buffer that is
+// handed to the stream whenever it fills up.
+class ChunkWriter {
+private:
+    ostream& os;
+    char buf[64 * 1024];
+    size_t used = 0;
+
+public:
+    explicit ChunkWriter(ostream& o) : os(o) {}
+    ~ChunkWriter() { flush(); }
+
+    void flush() {
+        if (used) os.write(buf, (streamsize)used);
+        used = 0;
+    }
+    void put(string_view s) {
+        if (used + s.size() > sizeof(buf)) flush();
+        if (s.size() > sizeof(buf)) { os.write(s.data(), (streamsize)s.size()); return; }
+        memcpy(buf + used, s.data(), s.size());
+        used += s.size();
+    }
+    void put(char c) {
+        if (used == sizeof(buf)) flush();
+        buf[used++] = c;
+    }
+    void put_int(long long v) {
+        if (used + 24 > sizeof(buf)) flush();
+        used = (size_t)(to_chars(buf + used, buf + sizeof(buf), v).ptr - buf);
+    }
+    // piasters -> "123.45"
+    void put_money(long long piasters) {
+        if (piasters < 0) { put('-'); piasters = -piasters; }
+        put_int(piasters / 100);
+        put('.');
+        put(char('0' + piasters / 10 % 10));
+        put(char('0' + piasters % 10));
+    }
+    // packed YYYYMMDDhhmmss -> "YYYY-MM-DD hh:mm:ss" without going through printf
+    void put_time(long long v) {
+        char t[19];
+        static const int digitAt[14] = {0,1,2,3, 5,6, 8,9, 11,12, 14,15, 17,18};
+        for (int i = 13; i >= 0; --i) { t[digitAt[i]] = char('0' + v % 10); v /= 10; }
+        t[4] = t[7] = '-'; t[10] = ' '; t[13] = t[16] = ':';
+        put(string_view(t, 19));
+    }
+    void put_csv(string_view s) {
+        if (s.find_first_of(",\"\n") == string_view::npos) { put(s); return; }
+        put('"');
+        for (char c : s) { if (c == '"') put('"'); put(c); }
+        put('"');
+    }
+    void put_json(string_view s) {
+        put('"');
+        for (char c : s) {
+            if (c == '"' || c == '\\') { put('\\'); put(c); }
+            else if ((unsigned char)c < 0x20) { char esc[8]; snprintf(esc, sizeof(esc), "\\u%04x", c); put(string_view(esc)); }
+            else put(c);
+        }
+        put('"');
+    }
+};
+
+class SalesArchive {
+private:
+    MappedFile file;
+    const ArchiveHeader* h = nullptr;
+    const uint32_t* saleId = nullptr;
+    const uint32_t* customer = nullptr;
+    const uint32_t* cashier = nullptr;
+    const uint8_t* onlineCol = nullptr;
+    const int64_t* totalCol = nullptr;
+    const int64_t* timeCol = nullptr;
+    const uint64_t* itemStart = nullptr;
+    const uint32_t* itemBarcode = nullptr;
+    const int32_t* itemQtyCol = nullptr;
+    const uint64_t* strOffset = nullptr;
+    const char* strBlob = nullptr;
+
+    // count values of width bytes at the column's offset, without overflowing
+    bool fits(ArchiveColumn c, uint64_t count, uint64_t width) const {
+        return h->col[c] % 8 == 0 && h->col[c] <= file.size() && count <= (file.size() - h->col[c]) / width;
+    }
+
+public:
+    // maps the file and checks it: the header, every dictionary id and both
+    // offset columns, so the accessors below can index without checks
+    bool open(const string& path, string* err = nullptr) {
+        auto fail = [&](const char* why) { if (err) *err = why; file.close(); h = nullptr; return false; };
+        if (!file.open(path)) return fail("cannot open archive");
+        if (file.size() < sizeof(ArchiveHeader)) return fail("archive too short");
+        h = (const ArchiveHeader*)file.data();
+        if (memcmp(h->magic, ARCHIVE_MAGIC, 4) != 0) return fail("not a sales archive");
+        if (h->version != ARCHIVE_VERSION) return fail("unsupported archive version");
+        uint64_t r = h->rows, n = h->items, s = h->strings;
+        if (r >= file.size() || n >= file.size() || s >= file.size()) return fail("archive truncated");
+        if (!fits(COL_SALE_ID, r, 4) || !fits(COL_CUSTOMER, r, 4) || !fits(COL_CASHIER, r, 4)
+            || !fits(COL_ONLINE, r, 1) || !fits(COL_TOTAL, r, 8) || !fits(COL_TIME, r, 8)
+            || !fits(COL_ITEM_START, r + 1, 8) || !fits(COL_ITEM_BARCODE, n, 4)
+            || !fits(COL_ITEM_QTY, n, 4) || !fits(COL_STR_OFFSET, s + 1, 8)
+            || h->col[COL_STR_BLOB] > file.size())
+            return fail("archive truncated");
+        const char* b = file.data();
+        saleId = (const uint32_t*)(b + h->col[COL_SALE_ID]);
+        customer = (const uint32_t*)(b + h->col[COL_CUSTOMER]);
+        cashier = (const uint32_t*)(b + h->col[COL_CASHIER]);
+        onlineCol = (const uint8_t*)(b + h->col[COL_ONLINE]);
+        totalCol = (const int64_t*)(b + h->col[COL_TOTAL]);
+        timeCol = (const int64_t*)(b + h->col[COL_TIME]);
+        itemStart = (const uint64_t*)(b + h->col[COL_ITEM_START]);
+        itemBarcode = (const uint32_t*)(b + h->col[COL_ITEM_BARCODE]);
+        itemQtyCol = (const int32_t*)(b + h->col[COL_ITEM_QTY]);
+        strOffset = (const uint64_t*)(b + h->col[COL_STR_OFFSET]);
+        strBlob = b + h->col[COL_STR_BLOB];
+        uint64_t blob = file.size() - h->col[COL_STR_BLOB];
+        if (strOffset[0] != 0 || strOffset[s] > blob || itemStart[0] != 0 || itemStart[r] != n) return fail("archive corrupt");
+        for (uint64_t i = 0; i < s; ++i) if (strOffset[i] > strOffset[i + 1]) return fail("archive corrupt");
+        for (uint64_t i = 0; i < r; ++i) {
+            if (itemStart[i] > itemStart[i + 1] || saleId[i] >= s || customer[i] >= s || cashier[i] >= s)
+                return fail("archive corrupt");
+        }
+        for (uint64_t k = 0; k < n; ++k) if (itemBarcode[k] >= s) return fail("archive corrupt");
+        return true;
+    }
+
+    size_t size() const { return h ? (size_t)h->rows : 0; }
+    size_t string_count() const { return h ? (size_t)h->strings : 0; }
+    string_view str(uint32_t id) const { return string_view(strBlob + strOffset[id], (size_t)(strOffset[id + 1] - strOffset[id])); }
+
+    string_view sale_id(size_t r) const { return str(saleId[r]); }
+    string_view customer_id(size_t r) const { return str(customer[r]); }
+    string_view cashier_id(size_t r) const { return str(cashier[r]); }
+    bool online(size_t r) const { return onlineCol[r] != 0; }
+    long long total_piasters(size_t r) const { return totalCol[r]; }
+    long long time_packed(size_t r) const { return timeCol[r]; }
+    size_t item_begin(size_t r) const { return (size_t)itemStart[r]; }
+    size_t item_end(size_t r) const { return (size_t)itemStart[r + 1]; }
+    string_view item_barcode(size_t k) const { return str(itemBarcode[k]); }
+    int item_qty(size_t k) const { return itemQtyCol[k]; }
+
+    long long revenue() const {
+        long long t = 0;
+        for (size_t r = 0; r < size(); ++r) t += totalCol[r];
+        return t;
+    }
+
+    // counts straight off the item columns, indexed by dictionary id
+    vector<pair<string,long long>> tally_products() const {
+        vector<long long> units(string_count(), 0);
+        for (size_t k = 0; k < (size_t)h->items; ++k) units[itemBarcode[k]] += itemQtyCol[k];
+        vector<pair<string,long long>> v;
+        for (uint32_t id = 0; id < units.size(); ++id) if (units[id] != 0) v.push_back({string(str(id)), units[id]});
+        sort(v.begin(), v.end(), [](const pair<string,long long>& a, const pair<string,long long>& b) {
+            if (a.second != b.second) return a.second > b.second;
+            return a.first < b.first;
+        });
+        return v;
+    }
+
+    // same columns as gui.py's export, plus the lane
+    void export_csv(ostream& os) const {
+        ChunkWriter w(os);
+        w.put("Sale ID,Customer ID,Type,Total (LE),Timestamp,Items,Cashier\n");
+        for (size_t r = 0; r < size(); ++r) {
+            w.put_csv(sale_id(r)); w.put(',');
+            w.put_csv(customer_id(r)); w.put(',');
+            w.put(online(r) ? "Online," : "Walk-in,");
+            w.put_money(total_piasters(r)); w.put(',');
+            w.put_time(time_packed(r)); w.put(',');
+            for (size_t k = item_begin(r); k < item_end(r); ++k) {
+                if (k != item_begin(r)) w.put(';');
+                w.put_csv(item_barcode(k)); w.put('x'); w.put_int(item_qty(k));
+            }
+            w.put(',');
+            w.put_csv(cashier_id(r)); w.put('\n');
+        }
+    }
+
+    void export_json(ostream& os) const {
+        ChunkWriter w(os);
+        w.put("[\n");
+        for (size_t r = 0; r < size(); ++r) {
+            w.put(r ? ",\n  {\"saleId\":" : "  {\"saleId\":"); w.put_json(sale_id(r));
+            w.put(",\"customerId\":"); w.put_json(customer_id(r));
+            w.put(",\"cashierId\":"); w.put_json(cashier_id(r));
+            w.put(online(r) ? ",\"online\":true" : ",\"online\":false");
+            w.put(",\"total\":"); w.put_money(total_piasters(r));
+            w.put(",\"time\":\""); w.put_time(time_packed(r));
+            w.put("\",\"items\":[");
+            for (size_t k = item_begin(r); k < item_end(r); ++k) {
+                if (k != item_begin(r)) w.put(',');
+                w.put("{\"barcode\":"); w.put_json(item_barcode(k));
+                w.put(",\"qty\":"); w.put_int(item_qty(k)); w.put('}');
+            }
+            w.put("]}");
+        }
+        w.put("\n]\n");
+    }
+};
@@ -0,0 +1,129 @@
+// arena.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+using namespace std;
+
+// Bump allocator for everything one customer visit creates (cart lines, undo
+// actions, the text they point at). Nothing is freed one by one: release()
+// hands the whole chain of blocks back to a per-thread pool in O(1), so the
+// next visit on that thread starts on warm memory. Objects placed here must
+// not need their destructors run.
+class SessionArena {
+public:
+    static const size_t BLOCK = 4096;   // usable bytes per pooled block
+    static const size_t POOL_MAX = 4096; // pooled blocks kept per thread (16 MB)
+
+private:
+    struct Block { Block* next; };
+    static const size_t HEADER = alignof(max_align_t);
+
+    struct Pool {
+        Block* free = nullptr;
+        size_t count = 0;
+        ~Pool() { while (free) { Block* b = free; free = b->next; ::free(b); } }
+    };
+    static Pool& pool() {
+        static thread_local Pool p;
+        return p;
+    }
+
+    Block* head = nullptr;  // newest pooled block, where bumping happens
+    Block* tail = nullptr;  // oldest pooled block
+    Block* large = nullptr; // requests too big for a block, freed one by one
+    size_t blocks = 0;
+    size_t largeBytes = 0;  // malloc'd for the large list
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t used = 0;
+
+    static Block* alloc_block(size_t bytes) {
+        Block* b = (Block*)::malloc(HEADER + bytes);
+        if (!b) throw bad_alloc();
+        return b;
+    }
+
+    void next_block() {
+        Pool& p = pool();
+        Block* b = p.free;
+        if (b) { p.free = b->next; p.count--; }
+        else b = alloc_block(BLOCK);
+        b->next = head;
+        head = b;
+        if (!tail) tail = b;
+        blocks++;
+        cur = (char*)b + HEADER;
+        end = cur + BLOCK;
+    }
+
+    static char* align_up(char* p, size_t align) {
+        return (char*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+public:
+    SessionArena() = default;
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+    ~SessionArena() { release(); }
+
+    void* allocate(size_t size, size_t align = alignof(max_align_t)) {
+        used += size;
+        if (size > BLOCK / 4) { // own block, so a pooled one is never mostly wasted
+            Block* b = alloc_block(size + align);
+            largeBytes += HEADER + size + align;
+            b->next = large;
+            large = b;
+            return align_up((char*)b + HEADER, align);
+        }
+        char* p = align_up(cur, align);
+        if (cur == nullptr || p + size > end) {
+            next_block();
+            p = align_up(cur, align);
+        }
+        cur = p + size;
+        return p;
+    }
+
+    template<typename T, typename... Args> T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(static_cast<Args&&>(args)...);
+    }
+
+    // a copy of s that lives until release()
+    string_view copy(string_view s) {
+        if (s.empty()) return string_view();
+        char* p = (char*)allocate(s.size(), 1);
+        memcpy(p, s.data(), s.size());
+        return string_view(p, s.size());
+    }
+
+    // drops everything at once; the arena can be used again afterwards
+    void release() {
+        while (large) { Block* b = large; large = b->next; ::free(b); }
+        if (head) {
+            Pool& p = pool();
+            if (p.count + blocks <= POOL_MAX) { // splice the whole chain in
+                tail->next = p.free;
+                p.free = head;
+                p.count += blocks;
+            } else {
+                while (head) { Block* b = head; head = b->next; ::free(b); }
+            }
+        }
+        head = tail = nullptr;
+        blocks = 0;
+        largeBytes = 0;
+        cur = end = nullptr;
+        used = 0;
+    }
+
+    size_t bytes_used() const { return used; }
+    size_t blocks_held() const { return blocks; }
+    // malloc'd and not yet released: pooled blocks in use plus large requests
+    size_t bytes_reserved() const { return blocks * (HEADER + BLOCK) + largeBytes; }
+    static size_t block_bytes() { return HEADER + BLOCK; }
+    static size_t pooled_blocks() { return pool().count; }
+};
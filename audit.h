@@ -0,0 +1,278 @@
+// audit.h
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include "inventory.h"
+#include "sales.h"
+using namespace std;
+
+// Stock reconciliation. For every SKU that moved since the audit period
+// opened, the books must balance:
+//
+//   opening + adjusted - sold + voided  ==  shelf stock + units held in open carts
+//
+// and the ledger must still hold exactly sold - voided units of it. The
+// engine keeps the left-hand side in a StockBook as it goes; the auditor
+// reads the right-hand side off the inventory and the carts, and re-counts
+// the ledger.
+//
+// A period opens with the engine, and again whenever the catalog or the
+// ledger is replaced (catalog import, recovery, close of day). Carts open at
+// that moment are carried into the opening figures.
+
+// "S123" -> 123
+inline uint64_t sale_number(const string& saleId) {
+    return saleId.size() > 1 ? strtoull(saleId.c_str() + 1, nullptr, 10) : 0;
+}
+
+// one line of an open cart
+struct CartHold {
+    string customerId;
+    string barcode;
+    int qty = 0;
+};
+
+// What the engine recorded per SKU, one column per figure. A row is added the
+// first time a SKU moves in the period, with its shelf stock at that moment.
+class StockBook {
+private:
+    unordered_map<string, uint32_t> index; // barcode : row
+    uint64_t firstSale = 1;                // sales numbered from here belong to the period
+
+    uint32_t row(const Product& p) {
+        auto slot = index.try_emplace(p.barcode, (uint32_t)barcode.size());
+        if (slot.second) add_row(p.barcode, p.stock);
+        return slot.first->second;
+    }
+    void add_row(const string& bc, int stock) {
+        barcode.push_back(bc);
+        opening.push_back(stock);
+        adjusted.push_back(0); sold.push_back(0); voided.push_back(0);
+        cartMoves.push_back(0); adjustments.push_back(0); voids.push_back(0);
+        lastVoid.emplace_back();
+    }
+
+public:
+    vector<string> barcode;
+    vector<long long> opening, adjusted, sold, voided;   // units
+    vector<uint32_t> cartMoves, adjustments, voids;      // operations behind them
+    vector<string> lastVoid;                             // sale id of the latest void
+
+    // forgets every row; sales numbered nextSale and up make the new period
+    void open_period(uint64_t nextSale) {
+        index.clear();
+        barcode.clear(); opening.clear(); adjusted.clear(); sold.clear(); voided.clear();
+        cartMoves.clear(); adjustments.clear(); voids.clear(); lastVoid.clear();
+        firstSale = nextSale;
+    }
+    // a cart line already open when the period starts: its units count as opening stock
+    void carry_hold(const Product& p, int qty) { opening[row(p)] += qty; }
+
+    // The hooks below run just before the shelf stock of p changes.
+    // open_row: p may be about to move; its row opens at the stock as it is
+    void open_row(const Product& p) { row(p); }
+    void cart_move(const Product& p) { cartMoves[row(p)]++; }
+    void adjust(const Product& p, int delta) {
+        uint32_t r = row(p);
+        adjusted[r] += delta;
+        adjustments[r]++;
+    }
+    // a bill from before the period is restocked like a delivery
+    void void_line(const Product& p, int qty, const SaleRecord& s) {
+        uint32_t r = row(p);
+        if (!in_period(s)) { adjusted[r] += qty; adjustments[r]++; return; }
+        voided[r] += qty;
+        voids[r]++;
+        lastVoid[r] = s.saleId;
+    }
+
+    // a committed sale; the units left the shelf when they went into the cart
+    void sale(const SaleRecord& s, const Inventory& inv) {
+        for (auto &it : s.items) {
+            auto f = index.find(it.first);
+            uint32_t r;
+            if (f != index.end()) r = f->second;
+            else {
+                // sold without having moved in the period: opens at the shelf as it is
+                r = (uint32_t)barcode.size();
+                index.emplace(it.first, r);
+                add_row(it.first, max(0, inv.stock_of(it.first)));
+            }
+            sold[r] += it.second;
+        }
+    }
+
+    bool in_period(const SaleRecord& s) const { return sale_number(s.saleId) >= firstSale; }
+    int find(const string& bc) const {
+        auto it = index.find(bc);
+        return it == index.end() ? -1 : (int)it->second;
+    }
+    size_t size() const { return barcode.size(); }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("stock book");
+        m.elements = size();
+        account_hash(m, index);
+        for (auto &kv : index) account_string(m, kv.first);
+        account_vector(m, barcode);
+        for (auto &b : barcode) account_string(m, b);
+        for (auto c : {&opening, &adjusted, &sold, &voided}) account_vector(m, *c);
+        for (auto c : {&cartMoves, &adjustments, &voids}) account_vector(m, *c);
+        account_vector(m, lastVoid);
+        for (auto &v : lastVoid) account_string(m, v);
+        return m;
+    }
+};
+
+// one SKU whose books do not balance
+struct StockDiscrepancy {
+    string barcode;
+    bool untracked = false;      // sold or held without any recorded move in the period
+    long long opening = 0, adjusted = 0, sold = 0, voided = 0;
+    long long stock = 0;         // on the shelf now
+    long long held = 0;          // in open carts now
+    long long ledgerUnits = 0;   // on period sales still in the ledger
+
+    // contributing operations
+    uint32_t cartMoves = 0, adjustments = 0, voids = 0;
+    string lastVoid;
+    vector<string> saleIds;      // period sales in the ledger with this SKU, newest first (at most 8)
+    vector<string> holders;      // customers whose cart holds it
+
+    long long expected() const { return opening + adjusted - sold + voided; }
+    // units found (shelf + carts) minus units the books account for
+    long long drift() const { return stock + held - expected(); }
+    bool ledger_mismatch() const { return ledgerUnits != sold - voided; }
+};
+
+struct StockAudit {
+    size_t skus = 0;          // rows checked
+    size_t sales = 0;         // period sales scanned
+    size_t holds = 0;         // open cart lines
+    vector<StockDiscrepancy> discrepancies; // by barcode
+    uint64_t elapsedNs = 0;
+
+    bool clean() const { return discrepancies.empty(); }
+};
+
+// Checks a StockBook against the inventory, the open carts and the ledger.
+// The ledger and the book's rows are split into one chunk per worker, like
+// ReportEngine; only the SKUs that fail are looked at again for their
+// sales and holders. Nothing may write to the engine while it runs.
+class StockAuditor {
+private:
+    unsigned threads;
+    size_t minChunk;
+
+    // runs f(part, lo, hi) over [0, n) in contiguous chunks; returns the part count
+    template<typename F> size_t split(size_t n, F f) const {
+        size_t parts = max<size_t>(1, min<size_t>(threads, (n + minChunk - 1) / minChunk));
+        size_t chunk = (n + parts - 1) / max<size_t>(1, parts);
+        if (parts == 1) { f(0, 0, n); return 1; }
+        vector<thread> workers;
+        for (size_t p = 0; p < parts; ++p)
+            workers.emplace_back([&, p] { f(p, min(n, p * chunk), min(n, (p + 1) * chunk)); });
+        for (auto &w : workers) w.join();
+        return parts;
+    }
+
+public:
+    explicit StockAuditor(unsigned t = 0, size_t minChunkSize = 16384) {
+        threads = t != 0 ? t : max(1u, thread::hardware_concurrency());
+        minChunk = max<size_t>(1, minChunkSize);
+    }
+
+    StockAudit run(const StockBook& book, const Inventory& inv, const vector<const SaleRecord*>& ledger,
+                   const vector<CartHold>& holds) const {
+        auto t0 = chrono::steady_clock::now();
+        StockAudit a;
+        a.skus = book.size();
+        a.holds = holds.size();
+
+        // units per SKU on the period's sales
+        vector<unordered_map<string, long long>> partUnits(threads);
+        vector<size_t> partSales(threads, 0);
+        size_t parts = split(ledger.size(), [&](size_t p, size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                if (!book.in_period(*ledger[i])) continue;
+                partSales[p]++;
+                for (auto &it : ledger[i]->items) partUnits[p][it.first] += it.second;
+            }
+        });
+        unordered_map<string, long long>& units = partUnits[0];
+        for (size_t p = 1; p < parts; ++p) for (auto &kv : partUnits[p]) units[kv.first] += kv.second;
+        for (size_t p = 0; p < parts; ++p) a.sales += partSales[p];
+
+        unordered_map<string, long long> held;
+        for (auto &h : holds) held[h.barcode] += h.qty;
+        auto lookup = [](const unordered_map<string, long long>& m, const string& k) {
+            auto it = m.find(k);
+            return it == m.end() ? 0LL : it->second;
+        };
+
+        // the balance of every row
+        vector<vector<StockDiscrepancy>> partBad(threads);
+        parts = split(book.size(), [&](size_t p, size_t lo, size_t hi) {
+            for (size_t r = lo; r < hi; ++r) {
+                StockDiscrepancy d;
+                d.barcode = book.barcode[r];
+                d.opening = book.opening[r]; d.adjusted = book.adjusted[r];
+                d.sold = book.sold[r]; d.voided = book.voided[r];
+                d.stock = max(0, inv.stock_of(d.barcode));
+                d.held = lookup(held, d.barcode);
+                d.ledgerUnits = lookup(units, d.barcode);
+                if (d.drift() == 0 && !d.ledger_mismatch()) continue;
+                d.cartMoves = book.cartMoves[r]; d.adjustments = book.adjustments[r]; d.voids = book.voids[r];
+                d.lastVoid = book.lastVoid[r];
+                partBad[p].push_back(move(d));
+            }
+        });
+        for (size_t p = 0; p < parts; ++p)
+            for (auto &d : partBad[p]) a.discrepancies.push_back(move(d));
+
+        // held or sold, but never moved as far as the book knows; each SKU reported once
+        unordered_set<string> reported;
+        for (auto &d : a.discrepancies) reported.insert(d.barcode);
+        auto untracked = [&](const string& bc) {
+            if (book.find(bc) >= 0 || !reported.insert(bc).second) return;
+            StockDiscrepancy d;
+            d.barcode = bc;
+            d.untracked = true;
+            d.stock = max(0, inv.stock_of(bc));
+            d.held = lookup(held, bc);
+            d.ledgerUnits = lookup(units, bc);
+            d.opening = d.stock + d.held; // nothing recorded; the shelf as found
+            a.discrepancies.push_back(move(d));
+        };
+        for (auto &kv : held) untracked(kv.first);
+        for (auto &kv : units) if (kv.second != 0) untracked(kv.first);
+
+        if (!a.discrepancies.empty()) {
+            sort(a.discrepancies.begin(), a.discrepancies.end(),
+                 [](const StockDiscrepancy& x, const StockDiscrepancy& y) { return x.barcode < y.barcode; });
+            unordered_map<string, StockDiscrepancy*> bad;
+            for (auto &d : a.discrepancies) bad[d.barcode] = &d;
+            for (const SaleRecord* s : ledger) {
+                if (!book.in_period(*s)) continue;
+                for (auto &it : s->items) {
+                    auto f = bad.find(it.first);
+                    if (f != bad.end() && f->second->saleIds.size() < 8) f->second->saleIds.push_back(s->saleId);
+                }
+            }
+            for (auto &h : holds) {
+                auto f = bad.find(h.barcode);
+                if (f != bad.end()) f->second->holders.push_back(h.customerId);
+            }
+        }
+        a.elapsedNs = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        return a;
+    }
+};
@@ -0,0 +1,160 @@
+// basket.h
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <cstdint>
+#include "sales.h"
+using namespace std;
+
+// "customers who bought X also bought Y": how many sales contained both products.
+// Every product gets a dense id and a neighbour array (neighbour id, count) kept
+// sorted by id, so an update is a binary search and a top-k query scans one
+// small contiguous array.
+class BasketGraph {
+private:
+    typedef pair<uint32_t, uint32_t> Edge; // (neighbour id, baskets together)
+    unordered_map<string, uint32_t> idOf;
+    vector<string> barcodes;
+    vector<vector<Edge>> neighbors;
+    size_t pairs = 0;
+
+    uint32_t id_for(const string& barcode) {
+        auto it = idOf.find(barcode);
+        if (it != idOf.end()) return it->second;
+        uint32_t id = (uint32_t)barcodes.size();
+        idOf.emplace(barcode, id);
+        barcodes.push_back(barcode);
+        neighbors.emplace_back();
+        return id;
+    }
+
+    void bump(uint32_t a, uint32_t b, int delta) {
+        vector<Edge>& adj = neighbors[a];
+        auto it = lower_bound(adj.begin(), adj.end(), Edge(b, 0));
+        if (it != adj.end() && it->first == b) {
+            long long c = (long long)it->second + delta;
+            if (c <= 0) { adj.erase(it); if (a < b) --pairs; }
+            else it->second = (uint32_t)c;
+        }
+        else if (delta > 0) {
+            adj.insert(it, Edge(b, (uint32_t)delta));
+            if (a < b) ++pairs;
+        }
+    }
+
+    // distinct product ids in one sale, sorted
+    vector<uint32_t> basket_ids(const vector<pair<string,int>>& items) {
+        vector<uint32_t> ids;
+        for (auto &it : items) if (it.second > 0) ids.push_back(id_for(it.first));
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+
+public:
+    // called at sale commit (delta +1) and when a bill is undone (delta -1)
+    void record(const vector<pair<string,int>>& items, int delta = 1) {
+        vector<uint32_t> ids = basket_ids(items);
+        for (size_t i = 0; i < ids.size(); ++i)
+            for (size_t j = i + 1; j < ids.size(); ++j) {
+                bump(ids[i], ids[j], delta);
+                bump(ids[j], ids[i], delta);
+            }
+    }
+
+    // products most often bought together with barcode, highest count first
+    vector<pair<string,uint32_t>> top_k(const string& barcode, size_t k) const {
+        vector<pair<string,uint32_t>> out;
+        auto f = idOf.find(barcode);
+        if (f == idOf.end() || k == 0) return out;
+        // single pass keeping the k best in a small sorted buffer
+        auto better = [](const Edge& a, const Edge& b) {
+            if (a.second != b.second) return a.second > b.second;
+            return a.first < b.first;
+        };
+        vector<Edge> best;
+        best.reserve(k + 1);
+        for (const Edge& e : neighbors[f->second]) {
+            if (best.size() == k && !better(e, best.back())) continue;
+            best.insert(upper_bound(best.begin(), best.end(), e, better), e);
+            if (best.size() > k) best.pop_back();
+        }
+        k = best.size();
+        for (size_t i = 0; i < k; ++i) out.push_back({barcodes[best[i].first], best[i].second});
+        return out;
+    }
+
+    // batch recompute from the whole ledger: every worker lists the pairs of its
+    // chunk as (lowId << 32 | highId) keys, sorts and run-length counts them; the
+    // sorted runs are then merged and the neighbour arrays come out already sorted
+    void rebuild(const vector<const SaleRecord*>& ledger, unsigned threads = 0) {
+        typedef pair<uint64_t, uint32_t> Run;
+        idOf.clear(); barcodes.clear(); neighbors.clear(); pairs = 0;
+        vector<vector<uint32_t>> baskets(ledger.size());
+        for (size_t i = 0; i < ledger.size(); ++i) baskets[i] = basket_ids(ledger[i]->items);
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        size_t parts = max<size_t>(1, min<size_t>(threads, ledger.size() / 4096));
+        vector<vector<Run>> partial(parts);
+        vector<thread> workers;
+        size_t chunk = (ledger.size() + parts - 1) / parts;
+        for (size_t p = 0; p < parts; ++p) {
+            size_t lo = p * chunk, hi = min(ledger.size(), lo + chunk);
+            workers.emplace_back([&, p, lo, hi]() {
+                vector<uint64_t> keys;
+                for (size_t s = lo; s < hi; ++s) {
+                    const vector<uint32_t>& ids = baskets[s];
+                    for (size_t i = 0; i < ids.size(); ++i)
+                        for (size_t j = i + 1; j < ids.size(); ++j) keys.push_back((uint64_t)ids[i] << 32 | ids[j]);
+                }
+                sort(keys.begin(), keys.end());
+                vector<Run>& out = partial[p];
+                for (uint64_t k : keys) {
+                    if (!out.empty() && out.back().first == k) ++out.back().second;
+                    else out.push_back(Run(k, 1));
+                }
+            });
+        }
+        for (auto &w : workers) w.join();
+
+        vector<Run> all = move(partial[0]);
+        for (size_t p = 1; p < parts; ++p) {
+            vector<Run> merged;
+            merged.reserve(all.size() + partial[p].size());
+            size_t i = 0, j = 0;
+            while (i < all.size() || j < partial[p].size()) {
+                if (j == partial[p].size() || (i < all.size() && all[i].first < partial[p][j].first)) merged.push_back(all[i++]);
+                else if (i == all.size() || partial[p][j].first < all[i].first) merged.push_back(partial[p][j++]);
+                else { merged.push_back(Run(all[i].first, all[i].second + partial[p][j].second)); ++i; ++j; }
+            }
+            all.swap(merged);
+            vector<Run>().swap(partial[p]);
+        }
+
+        for (auto &r : all) {
+            uint32_t a = (uint32_t)(r.first >> 32), b = (uint32_t)r.first;
+            neighbors[a].push_back(Edge(b, r.second));
+            neighbors[b].push_back(Edge(a, r.second));
+        }
+        pairs = all.size();
+    }
+
+    size_t product_count() const { return barcodes.size(); }
+    size_t pair_count() const { return pairs; }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("basket pairs");
+        m.elements = pairs;
+        account_hash(m, idOf);
+        for (auto &kv : idOf) account_string(m, kv.first);
+        account_vector(m, barcodes);
+        for (auto &b : barcodes) account_string(m, b);
+        account_vector(m, neighbors);
+        for (auto &adj : neighbors) account_vector(m, adj);
+        return m;
+    }
+};
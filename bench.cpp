@@ -0,0 +1,1232 @@
+// bench.cpp - benchmark entrypoint, prints one CSV row per measurement
+//   g++ -std=c++17 -O2 -pthread -o bench.exe bench.cpp
+//   .\bench.exe [section] [size]
+#include "system.h"
+#include "chain.h"
+#include "latency.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <stack>
+#include <queue>
+#include <map>
+#include <thread>
+#include <mutex>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <csignal>
+#endif
+using namespace std;
+
+using BenchClock = chrono::steady_clock;
+
+static double ms_since(BenchClock::time_point t0) {
+    return chrono::duration<double, milli>(BenchClock::now() - t0).count();
+}
+
+// bench,case,n,value,unit
+static void emit(const string& bench, const string& name, size_t n, double value, const string& unit) {
+    cout << bench << ',' << name << ',' << n << ',' << value << ',' << unit << '\n';
+}
+
+// fake catalog barcodes "B000000".."B<skus>" spread over a handful of categories
+static unordered_map<string,string> synthetic_categories(int skus) {
+    static const char* cats[] = {"Dairy","Meat","Produce","Snacks","Beverages","Household","Bakery","Toys"};
+    unordered_map<string,string> m;
+    for (int i = 0; i < skus; ++i) m["B" + to_string(1000000 + i).substr(1)] = cats[i % 8];
+    return m;
+}
+
+static void synthetic_sales(SalesList& out, size_t n, int skus, unsigned seed = 42) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> sku(0, skus - 1), basket(1, 8), qty(1, 4), cust(1, 50000), lane(1, 4);
+    for (size_t i = 0; i < n; ++i) {
+        vector<pair<string,int>> items;
+        int k = basket(rng);
+        double tot = 0;
+        for (int j = 0; j < k; ++j) {
+            int q = qty(rng);
+            items.push_back({"B" + to_string(1000000 + sku(rng)).substr(1), q});
+            tot += q * 12.75;
+        }
+        out.add_sale(new SaleRecord("S" + to_string(i + 1), "C" + to_string(cust(rng)), i % 5 == 0, items, tot,
+                                    i % 5 == 0 ? "ONLINE" : "CASH" + to_string(lane(rng))));
+    }
+}
+
+static void bench_report(size_t n) {
+    SalesList sales;
+    auto cats = synthetic_categories(20000);
+    synthetic_sales(sales, n, 20000);
+    auto ledger = sales.ledger();
+
+    auto t0 = BenchClock::now();
+    SalesReport serial = ReportEngine(cats, 1).run_serial(ledger);
+    double base = ms_since(t0);
+    emit("report", "serial", n, base, "ms");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        t0 = BenchClock::now();
+        SalesReport r = ReportEngine(cats, t).run(ledger);
+        double ms = ms_since(t0);
+        emit("report", "threads=" + to_string(t), n, ms, "ms");
+        emit("report", "speedup threads=" + to_string(t), n, base / ms, "x");
+        if (!(r == serial)) { cerr << "report mismatch at " << t << " threads\n"; exit(1); }
+        if (t < maxThreads && t * 2 > maxThreads) t = maxThreads / 2; // always finish on maxThreads
+    }
+}
+
+// write throughput, then open + full scan after asking the OS to drop the file's pages
+static void bench_archive(size_t n) {
+    SalesList sales;
+    synthetic_sales(sales, n, 20000);
+    auto ledger = sales.ledger();
+    string path = "bench_archive.sma";
+
+    auto t0 = BenchClock::now();
+    if (!write_sales_archive(path, ledger)) { cerr << "cannot write " << path << '\n'; exit(1); }
+    double ms = ms_since(t0);
+    ifstream sz(path, ios::binary | ios::ate);
+    double mb = (double)sz.tellg() / (1024.0 * 1024.0);
+    emit("archive", "write", n, ms, "ms");
+    emit("archive", "write rows/s", n, n / (ms / 1000.0), "rows/s");
+    emit("archive", "write MB/s", n, mb / (ms / 1000.0), "MB/s");
+    emit("archive", "file size", n, mb, "MB");
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) { fdatasync(fd); posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED); close(fd); }
+#endif
+    t0 = BenchClock::now();
+    SalesArchive a;
+    a.open(path);
+    long long revenue = a.revenue();
+    auto top = a.tally_products();
+    emit("archive", "cold open+revenue+tally", n, ms_since(t0), "ms");
+    t0 = BenchClock::now();
+    revenue += a.revenue();
+    top = a.tally_products();
+    emit("archive", "warm revenue+tally", n, ms_since(t0), "ms");
+
+    ofstream csv("bench_archive.csv", ios::binary | ios::trunc);
+    t0 = BenchClock::now();
+    a.export_csv(csv);
+    emit("archive", "export csv", n, ms_since(t0), "ms");
+    remove("bench_archive.csv");
+    remove(path.c_str());
+    if (revenue == 0 || top.empty()) cerr << "archive query returned nothing\n";
+}
+
+static void bench_basket(size_t n) {
+    SalesList sales;
+    synthetic_sales(sales, n, 20000);
+    auto ledger = sales.ledger();
+
+    BasketGraph g;
+    auto t0 = BenchClock::now();
+    for (const SaleRecord* s : ledger) g.record(s->items);
+    double ms = ms_since(t0);
+    emit("basket", "incremental record", n, ms, "ms");
+    emit("basket", "incremental sales/s", n, n / (ms / 1000.0), "sales/s");
+    emit("basket", "pairs", n, (double)g.pair_count(), "pairs");
+
+    const int queries = 100000;
+    t0 = BenchClock::now();
+    size_t found = 0;
+    for (int q = 0; q < queries; ++q) found += g.top_k("B" + to_string(1000000 + q % 20000).substr(1), 5).size();
+    emit("basket", "top5 query", queries, ms_since(t0) * 1e6 / queries, "ns/query");
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        BasketGraph r;
+        t0 = BenchClock::now();
+        r.rebuild(ledger, t);
+        emit("basket", "rebuild threads=" + to_string(t), n, ms_since(t0), "ms");
+        if (r.pair_count() != g.pair_count()) { cerr << "basket rebuild mismatch\n"; exit(1); }
+        if (t < maxThreads && t * 2 > maxThreads) t = maxThreads / 2;
+    }
+    if (found == 0) cerr << "basket queries found nothing\n";
+}
+
+// sketch estimates against the exact answers, plus update cost
+static void bench_sketch(size_t n) {
+    mt19937 rng(7);
+    uniform_int_distribution<int> cust(1, (int)max<size_t>(1, n / 3));
+    lognormal_distribution<double> basketValue(5.0, 0.8);
+    HyperLogLog hll[4];
+    QuantileSketch qs[4];
+    unordered_map<string,int> exactSet;
+    vector<double> values;
+    auto t0 = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        string id = "C" + to_string(cust(rng));
+        double v = basketValue(rng);
+        hll[i % 4].add(id);   // four lanes, merged below
+        qs[i % 4].add(v);
+        exactSet[id]++;
+        values.push_back(v);
+    }
+    emit("sketch", "update (incl. exact bookkeeping)", n, ms_since(t0) * 1e6 / n, "ns/sale");
+    for (int l = 1; l < 4; ++l) { hll[0].merge(hll[l]); qs[0].merge(qs[l]); }
+    sort(values.begin(), values.end());
+    double distinctErr = fabs(hll[0].estimate() - (double)exactSet.size()) / (double)exactSet.size();
+    emit("sketch", "hll distinct rel.error", n, distinctErr * 100, "%");
+    for (double q : {0.5, 0.95, 0.99}) {
+        double exact = values[(size_t)(q * (double)(values.size() - 1))];
+        emit("sketch", "quantile " + to_string(q).substr(0, 4) + " rel.error", n, fabs(qs[0].quantile(q) - exact) / exact * 100, "%");
+    }
+}
+
+// log append throughput per commit mode, then recovery time against log length
+// (plain log replay vs. the same state loaded from a checkpoint snapshot). Last,
+// the disk fills up mid-day (POSIX only: a file size limit cuts a group short):
+// the checkout caught by it must say so, later ones must be refused, and every
+// sale acknowledged before it must come back on recovery.
+static void bench_wal(size_t n) {
+    const int skus = 20000;
+    string dir = "bench_wal";
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    string logPath = dir + "/wal.log", snapPath = dir + "/snapshot.bin";
+    auto barcode = [](int i) { return "B" + to_string(1000000 + i).substr(1); };
+
+    struct Mode { const char* name; bool durable; bool syncCommit; size_t records; };
+    Mode modes[] = {{"group commit fsync", true, false, n},
+                    {"group commit no fsync", false, false, n},
+                    {"fsync every record", true, true, min(n, (size_t)2000)}};
+    for (const Mode& m : modes) {
+        WalOptions o;
+        o.durable = m.durable;
+        o.syncCommit = m.syncCommit;
+        WriteAheadLog log;
+        if (!log.open(logPath, 0, CartHolds(), o)) { cerr << "cannot open " << logPath << '\n'; exit(1); }
+        auto t0 = BenchClock::now();
+        for (size_t i = 0; i < m.records; ++i) {
+            log.log_stock(barcode((int)(i % skus)), -1, "C" + to_string(i % 500));
+            log.commit(log.last_lsn());
+        }
+        log.sync();
+        double ms = ms_since(t0);
+        emit("wal", string(m.name) + " records/s", m.records, m.records / (ms / 1000.0), "records/s");
+        emit("wal", string(m.name) + " groups", m.records, (double)log.group_count(), "flushes");
+    }
+
+    Inventory inv;
+    for (int i = 0; i < skus; ++i) inv.add_product(Product(barcode(i), "Item", 10.0 + i % 90, 1000000, "2030-01-01", "Cat"));
+    for (size_t len : {n / 100, n / 10, n}) {
+        if (len == 0) continue;
+        // a day of traffic: four cart moves, then the sale that takes them
+        write_wal_snapshot(snapPath, 0, 1, inv, CartHolds(), {});
+        {
+            WalOptions o;
+            o.durable = false;
+            WriteAheadLog log;
+            log.open(logPath, 0, CartHolds(), o);
+            SaleRecord sale("S0", "C0", false, {}, 0.0, "CASH1");
+            for (size_t i = 0; i < len;) {
+                sale.customerId = "C" + to_string(i % 500);
+                sale.items.clear();
+                for (int k = 0; k < 4 && i < len; ++k, ++i) {
+                    sale.items.push_back({barcode((int)((i * 7919) % skus)), 1});
+                    log.log_stock(sale.items.back().first, -1, sale.customerId);
+                }
+                if (i < len) { sale.saleId = "S" + to_string(i); sale.total = 40.0; log.log_sale(sale); ++i; }
+            }
+        }
+        Inventory rinv; SalesList rsales; int next = 1; RecoveryStats st;
+        auto t0 = BenchClock::now();
+        if (!recover_wal_state(dir, rinv, rsales, next, st)) { cerr << "recovery failed\n"; exit(1); }
+        emit("wal", "recover from log", len, ms_since(t0), "ms");
+
+        write_wal_snapshot(snapPath, st.lastLsn, next, rinv, CartHolds(), rsales.ledger());
+        WalFile empty;
+        empty.open(logPath, true);
+        empty.close();
+        Inventory sinv; SalesList ssales; next = 1; st = RecoveryStats();
+        t0 = BenchClock::now();
+        recover_wal_state(dir, sinv, ssales, next, st);
+        emit("wal", "recover from snapshot", len, ms_since(t0), "ms");
+        emit("wal", "sales recovered", len, (double)st.sales, "sales");
+    }
+
+#ifndef _WIN32
+    remove(logPath.c_str());
+    remove(snapPath.c_str());
+    size_t acked = 0;
+    {
+        SupermarketSystem sys(1);
+        WalOptions o;
+        o.syncCommit = true;
+        if (!sys.open_wal(dir, o)) { cerr << "cannot open log in " << dir << '\n'; exit(1); }
+        auto shopper = [&](const string& id) {
+            sys.add_walkin_customer(id, "Shopper");
+            sys.customer_add_to_cart(id, "0001", 1);
+            sys.enqueue_walkin_to_cashier(id);
+        };
+        shopper("W0");
+        if (sys.process_checkout_at_cashier(0).status != Status::Ok) { cerr << "first checkout failed\n"; exit(1); }
+        acked++;
+        struct stat fs;
+        stat(logPath.c_str(), &fs);
+        rlimit was, cap;
+        getrlimit(RLIMIT_FSIZE, &was);
+        cap = was;
+        cap.rlim_cur = (rlim_t)fs.st_size + 4000; // not a whole number of groups
+        signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &cap);
+        CheckoutResult r;
+        for (int i = 1; i < 100000; ++i) {
+            shopper("W" + to_string(i));
+            r = sys.process_checkout_at_cashier(0);
+            if (r.status != Status::Ok) break;
+            acked++;
+        }
+        shopper("LATE");
+        CheckoutResult late = sys.process_checkout_at_cashier(0);
+        setrlimit(RLIMIT_FSIZE, &was);
+        if (r.status != Status::LogFailed || r.saleId.empty() || !sys.log_failed() ||
+            late.status != Status::LogFailed || sys.cashier_queue_length(0) != 1) {
+            cerr << "log failure not reported: " << status_message(r.status) << ", then " << status_message(late.status) << '\n';
+            exit(1);
+        }
+    }
+    Inventory finv; SalesList fsales; int fnext = 1; RecoveryStats fst;
+    if (!recover_wal_state(dir, finv, fsales, fnext, fst) || fsales.ledger().size() != acked) {
+        cerr << "after a failed write " << fsales.ledger().size() << " sales recovered, " << acked << " acknowledged\n";
+        exit(1);
+    }
+    emit("wal", "acknowledged sales kept after a failed write", acked, (double)fsales.ledger().size(), "sales");
+    emit("wal", "torn tail dropped", acked, (double)fst.tornBytes, "bytes");
+#endif
+    remove(logPath.c_str());
+    remove(snapPath.c_str());
+#ifdef _WIN32
+    _rmdir(dir.c_str());
+#else
+    rmdir(dir.c_str());
+#endif
+}
+
+// ---- containers: hand-rolled structures against their standard-library counterparts
+
+static volatile long long benchSink = 0; // keeps results observable so loops aren't optimised away
+
+template<typename F>
+static double ns_per_op(size_t ops, F f) {
+    auto t0 = BenchClock::now();
+    f();
+    return ms_since(t0) * 1e6 / (double)max<size_t>(1, ops);
+}
+
+static vector<Product> synthetic_products(size_t n, bool sortedByPrice, unsigned seed = 3) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> price(1.0, 5000.0);
+    static const char* cats[] = {"Dairy","Meat","Produce","Snacks","Beverages","Household","Bakery","Toys"};
+    vector<Product> v;
+    for (size_t i = 0; i < n; ++i)
+        v.push_back(Product("P" + to_string(i), "Item " + to_string(i), price(rng), 100, "2030-01-01", cats[rng() % 8]));
+    if (sortedByPrice) sort(v.begin(), v.end(), [](const Product& a, const Product& b){ return a.price < b.price; });
+    return v;
+}
+
+static void bench_stack(size_t n) {
+    emit("stack", "MyStack push+pop", n, ns_per_op(2 * n, [&]() {
+        MyStack<int> st;
+        for (size_t i = 0; i < n; ++i) st.push((int)i);
+        long long t = 0;
+        while (!st.isEmpty()) { t += st.top(); st.pop(); }
+        benchSink += t;
+    }), "ns/op");
+    emit("stack", "std::stack push+pop", n, ns_per_op(2 * n, [&]() {
+        stack<int, vector<int>> st;
+        for (size_t i = 0; i < n; ++i) st.push((int)i);
+        long long t = 0;
+        while (!st.empty()) { t += st.top(); st.pop(); }
+        benchSink += t;
+    }), "ns/op");
+}
+
+static void bench_queue(size_t n) {
+    emit("queue", "MyQueue enqueue+dequeue", n, ns_per_op(2 * n, [&]() {
+        MyQueue<int> q;
+        for (size_t i = 0; i < n; ++i) q.enqueue((int)i);
+        long long t = 0;
+        while (!q.isEmpty()) { t += q.front(); q.dequeue(); }
+        benchSink += t;
+    }), "ns/op");
+    emit("queue", "std::queue enqueue+dequeue", n, ns_per_op(2 * n, [&]() {
+        queue<int> q;
+        for (size_t i = 0; i < n; ++i) q.push((int)i);
+        long long t = 0;
+        while (!q.empty()) { t += q.front(); q.pop(); }
+        benchSink += t;
+    }), "ns/op");
+}
+
+struct IntGreater { bool operator()(int a, int b) const { return a < b; } };
+
+static void bench_priority_queue(size_t n) {
+    mt19937 rng(5);
+    vector<int> keys(n);
+    for (auto &k : keys) k = (int)(rng() % 1000000);
+    emit("priority_queue", "MyPriorityQueue push+pop", n, ns_per_op(2 * n, [&]() {
+        MyPriorityQueue<int, IntGreater> pq; // IntGreater: smaller key first, as the online queue used to
+        for (int k : keys) pq.push(k);
+        long long t = 0;
+        while (!pq.isEmpty()) { t += pq.top(); pq.pop(); }
+        benchSink += t;
+    }), "ns/op");
+    emit("priority_queue", "std::priority_queue push+pop", n, ns_per_op(2 * n, [&]() {
+        priority_queue<int, vector<int>, greater<int>> pq;
+        for (int k : keys) pq.push(k);
+        long long t = 0;
+        while (!pq.empty()) { t += pq.top(); pq.pop(); }
+        benchSink += t;
+    }), "ns/op");
+}
+
+static void bench_bst(size_t n, bool sortedInput) {
+    vector<Product> items = synthetic_products(n, sortedInput);
+    string order = sortedInput ? " sorted" : " random";
+    ProductBST bst;
+    emit("bst", "ProductBST build" + order, n, ns_per_op(n, [&]() { bst.build(items); }), "ns/op");
+    emit("bst", "ProductBST inorder" + order, n, ns_per_op(n, [&]() { benchSink += (long long)bst.sorted_by_price().size(); }), "ns/op");
+    multimap<double, Product> mm;
+    emit("bst", "std::multimap build" + order, n, ns_per_op(n, [&]() {
+        mm.clear();
+        for (auto &p : items) mm.emplace(p.price, p);
+    }), "ns/op");
+    emit("bst", "std::multimap inorder" + order, n, ns_per_op(n, [&]() {
+        vector<Product> out;
+        for (auto &kv : mm) out.push_back(kv.second);
+        benchSink += (long long)out.size();
+    }), "ns/op");
+    emit("bst", "std::stable_sort copy" + order, n, ns_per_op(n, [&]() {
+        vector<Product> out = items;
+        stable_sort(out.begin(), out.end(), [](const Product& a, const Product& b){ return a.price < b.price; });
+        benchSink += (long long)out.size();
+    }), "ns/op");
+}
+
+static void bench_inventory(size_t n) {
+    vector<Product> items = synthetic_products(n, false);
+    vector<string> probes;
+    mt19937 rng(9);
+    for (size_t i = 0; i < n; ++i) probes.push_back("P" + to_string(rng() % (n * 2))); // ~half misses
+    Inventory inv;
+    emit("inventory", "Inventory add_product", n, ns_per_op(n, [&]() { for (auto &p : items) inv.add_product(p); }), "ns/op");
+    emit("inventory", "Inventory find", n, ns_per_op(n, [&]() {
+        long long hits = 0;
+        for (auto &b : probes) hits += inv.find(b) != nullptr;
+        benchSink += hits;
+    }), "ns/op");
+    map<string, Product> m;
+    emit("inventory", "std::map insert", n, ns_per_op(n, [&]() { for (auto &p : items) m.emplace(p.barcode, p); }), "ns/op");
+    emit("inventory", "std::map find", n, ns_per_op(n, [&]() {
+        long long hits = 0;
+        for (auto &b : probes) hits += m.find(b) != m.end();
+        benchSink += hits;
+    }), "ns/op");
+}
+
+// one cart of n distinct lines: add each, remove each, then undo all 2n actions
+static void bench_cart(size_t n) {
+    vector<Product> items = synthetic_products(n, false);
+    Inventory inv;
+    for (auto &p : items) inv.add_product(p);
+    ShoppingCart cart;
+    emit("cart", "ShoppingCart add", n, ns_per_op(n, [&]() { for (auto &p : items) cart.add_item(p, 1); }), "ns/op");
+    emit("cart", "ShoppingCart remove", n, ns_per_op(n, [&]() { for (auto &p : items) cart.remove_item(p.barcode, 1); }), "ns/op");
+    emit("cart", "ShoppingCart undo", 2 * n, ns_per_op(2 * n, [&]() {
+        for (size_t i = 0; i < 2 * n; ++i) benchSink += cart.undo(inv).qty;
+    }), "ns/op");
+    // baseline: the same work on a vector of lines plus a vector of actions
+    vector<pair<string,int>> lines;
+    vector<pair<string,int>> actions;
+    emit("cart", "vector cart add", n, ns_per_op(n, [&]() {
+        for (auto &p : items) {
+            auto it = find_if(lines.begin(), lines.end(), [&](const pair<string,int>& l){ return l.first == p.barcode; });
+            if (it != lines.end()) it->second++; else lines.push_back({p.barcode, 1});
+            actions.push_back({p.barcode, 1});
+        }
+    }), "ns/op");
+    emit("cart", "vector cart remove", n, ns_per_op(n, [&]() {
+        for (auto &p : items) {
+            auto it = find_if(lines.begin(), lines.end(), [&](const pair<string,int>& l){ return l.first == p.barcode; });
+            if (it != lines.end() && --it->second == 0) lines.erase(it);
+            actions.push_back({p.barcode, -1});
+        }
+    }), "ns/op");
+}
+
+static void bench_containers(size_t n) {
+    vector<size_t> sizes = n ? vector<size_t>{n} : vector<size_t>{1000, 10000, 100000};
+    for (size_t sz : sizes) {
+        bench_stack(sz);
+        bench_queue(sz);
+        bench_inventory(sz);
+        bench_bst(sz, false);
+        // sorted insertion degenerates the BST into a list: O(n^2) and n-deep recursion
+        if (sz <= 10000) bench_bst(sz, true);
+        // the linked-list priority queue and cart are O(n) per operation
+        if (sz <= 10000) { bench_priority_queue(sz); bench_cart(sz); }
+    }
+}
+
+// catalog import: CSV and binary files against inserting the same products one
+// by one; 1% of the rows repeat an earlier barcode so the duplicate path runs too
+static void bench_catalog(size_t n) {
+    vector<Product> products = synthetic_products(n, false);
+    for (size_t i = 0; i < n / 100; ++i) products.push_back(products[i * 97 % n]);
+    size_t rows = products.size();
+
+    auto t0 = BenchClock::now();
+    {
+        Inventory inv;
+        for (auto &p : products) inv.add_product(p);
+        emit("catalog", "add_product loop", rows, ms_since(t0), "ms");
+    }
+    for (const char* path : {"bench_catalog.csv", "bench_catalog.smc"}) {
+        string name = string(path).substr(string(path).size() - 3);
+        t0 = BenchClock::now();
+        if (!write_catalog(path, products)) { cerr << "cannot write " << path << '\n'; exit(1); }
+        emit("catalog", name + " write", rows, ms_since(t0), "ms");
+        ifstream sz(path, ios::binary | ios::ate);
+        emit("catalog", name + " file size", rows, (double)sz.tellg() / (1024.0 * 1024.0), "MB");
+
+        Inventory inv;
+        CatalogLoadStats st;
+        if (!load_catalog(path, inv, st)) { cerr << "cannot load " << path << '\n'; exit(1); }
+        emit("catalog", name + " load", rows, st.millis, "ms");
+        emit("catalog", name + " load rows/s", rows, rows / (st.millis / 1000.0), "rows/s");
+        if (st.loaded != n || st.duplicates != rows - n) cerr << name << ": loaded " << st.loaded << ", " << st.duplicates << " duplicates\n";
+        remove(path);
+    }
+    emit("catalog", "peak memory", rows, peak_memory_bytes() / (1024.0 * 1024.0), "MB");
+}
+
+// constructor cost with the compile-time catalog, against the old eager path
+// (every product built and inserted, then both BSTs rebuilt)
+static void bench_startup(size_t n) {
+    auto t0 = BenchClock::now();
+    { SupermarketSystem first(3); }
+    emit("startup", "first construct", 1, ms_since(t0) * 1000.0, "us");
+    emit("startup", "construct", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) { SupermarketSystem sys(3); benchSink += sys.cashier_queue_length(0); }
+    }) / 1000.0, "us");
+    emit("startup", "eager seed + rebuild_bst", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            Inventory inv;
+            for (const CatalogEntry& e : DEFAULT_CATALOG)
+                inv.add_product(Product(string(e.barcode), string(e.name), e.price, e.stock, string(e.expiry), string(DEFAULT_CATEGORIES[e.category])));
+            ProductBST byPrice; ProductBSTByCategory byCategory;
+            byPrice.build(inv.all_products());
+            byCategory.build(inv.all_products());
+            benchSink += inv.size();
+        }
+    }) / 1000.0, "us");
+    emit("startup", "construct + touch every product", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            SupermarketSystem sys(3);
+            for (const CatalogEntry& e : DEFAULT_CATALOG) benchSink += sys.get_inventory().find(string(e.barcode))->stock;
+        }
+    }) / 1000.0, "us");
+}
+
+// change feed: raw publish cost, what it adds to a cart add/remove pair, and
+// one producer against 1 and 4 consumers polling in batches of 256
+static void bench_feed(size_t n) {
+    {
+        ChangeFeed feed;
+        emit("feed", "publish", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) benchSink += feed.publish(ChangeType::StockChanged, "0001", -1, (int)i, 0);
+        }), "ns/op");
+    }
+    for (int withFeed = 0; withFeed < 2; ++withFeed) {
+        SupermarketSystem sys(3);
+        if (withFeed) sys.enable_change_feed();
+        sys.add_walkin_customer("C1", "Bench");
+        emit("feed", withFeed ? "cart add+remove feed on" : "cart add+remove feed off", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                benchSink += sys.customer_add_to_cart("C1", "0001", 1).available;
+                benchSink += sys.customer_remove_from_cart("C1", "0001", 1).available;
+            }
+        }), "ns/op");
+    }
+    for (int consumers : {1, 4}) {
+        ChangeFeed feed(1 << 16);
+        atomic<bool> done{false};
+        vector<uint64_t> got(consumers), lost(consumers);
+        vector<thread> ts;
+        for (int c = 0; c < consumers; ++c) ts.emplace_back([&, c] {
+            FeedSubscriber sub(feed, 1);
+            vector<ChangeEvent> buf(256);
+            for (;;) {
+                bool finished = done.load(memory_order_acquire);
+                size_t k = sub.poll(buf.data(), buf.size());
+                got[c] += k;
+                if (k == 0) { if (finished && sub.backlog() == 0) break; this_thread::yield(); }
+            }
+            lost[c] = sub.lost_events();
+        });
+        auto t0 = BenchClock::now();
+        for (size_t i = 0; i < n; ++i) feed.publish(ChangeType::StockChanged, "0001", -1, (int)i, 0);
+        done.store(true, memory_order_release);
+        for (auto &t : ts) t.join();
+        double ms = ms_since(t0);
+        uint64_t totalLost = 0;
+        for (int c = 0; c < consumers; ++c) totalLost += lost[c];
+        string name = to_string(consumers) + (consumers == 1 ? " consumer" : " consumers");
+        emit("feed", name + " events/s", n, n / (ms / 1000.0), "events/s");
+        emit("feed", name + " lost", n, (double)totalLost, "events");
+    }
+}
+
+// snapshots: checkouts per second and checkout latency while 0, 1 or 4 threads
+// run sales reports nonstop, first with reports reading the live engine under
+// a mutex, then on pinned snapshots; n sales are on the ledger beforehand
+static void bench_snapshot(size_t n) {
+    const double seconds = 1.0;
+    for (int useSnapshots = 0; useSnapshots < 2; ++useSnapshots) {
+        for (int reporters : {0, 1, 4}) {
+            SupermarketSystem sys(3);
+            sys.add_product(Product("SNAP1", "Bench item", 2.5, 1 << 30, "2030-01-01", "Bench"));
+            sys.add_walkin_customer("C1", "Bench");
+            if (useSnapshots) sys.enable_snapshots();
+            mutex engine; // guards the live engine in the mutex runs
+            auto checkout = [&] {
+                sys.customer_add_to_cart("C1", "SNAP1", 1);
+                sys.enqueue_walkin_to_cashier("C1");
+                benchSink += (long long)sys.process_checkout_at_cashier(0).saleId.size();
+            };
+            for (size_t i = 0; i < n; ++i) checkout();
+
+            atomic<bool> done{false};
+            vector<uint64_t> reports(reporters);
+            vector<thread> ts;
+            for (int r = 0; r < reporters; ++r) ts.emplace_back([&, r] {
+                if (useSnapshots) {
+                    SnapshotReader reader(*sys.snapshots());
+                    while (!done.load(memory_order_relaxed)) {
+                        SnapshotPin v = reader.pin();
+                        benchSink += snapshot_sales_report(*v).saleCount;
+                        reports[r]++;
+                    }
+                } else {
+                    while (!done.load(memory_order_relaxed)) {
+                        lock_guard<mutex> g(engine);
+                        benchSink += sys.sales_report().saleCount;
+                        reports[r]++;
+                    }
+                }
+            });
+
+            LatencyHistogram lat;
+            size_t checkouts = 0;
+            auto t0 = BenchClock::now();
+            while (ms_since(t0) < seconds * 1000.0) {
+                auto c0 = BenchClock::now();
+                if (useSnapshots) checkout();
+                else { lock_guard<mutex> g(engine); checkout(); }
+                lat.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(BenchClock::now() - c0).count());
+                checkouts++;
+            }
+            double ms = ms_since(t0);
+            done.store(true);
+            for (auto &t : ts) t.join();
+
+            uint64_t totalReports = 0;
+            for (uint64_t k : reports) totalReports += k;
+            string name = string(useSnapshots ? "snapshot " : "mutex ") + to_string(reporters) + (reporters == 1 ? " reporter" : " reporters");
+            emit("snapshot", name + " checkouts/s", n, checkouts / (ms / 1000.0), "checkouts/s");
+            emit("snapshot", name + " checkout p99", n, lat.percentile(99) / 1000.0, "us");
+            emit("snapshot", name + " checkout p99.9", n, lat.percentile(99.9) / 1000.0, "us");
+            emit("snapshot", name + " checkout max", n, lat.max_ns() / 1000.0, "us");
+            if (reporters) emit("snapshot", name + " reports/s", n, totalReports / (ms / 1000.0), "reports/s");
+        }
+    }
+    SupermarketSystem sys(3);
+    SnapshotReader reader(sys.enable_snapshots());
+    emit("snapshot", "pin+unpin", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) { SnapshotPin v = reader.pin(); benchSink += (long long)v->productCount; }
+    }), "ns/op");
+}
+
+// the customer layout before CustomerRegistry: a heap object with a vtable
+// and a cart each, in a map keyed by id, kind found by dynamic_cast
+struct LegacyCustomer {
+    string id, name;
+    ShoppingCart cart;
+    virtual ~LegacyCustomer() = default;
+};
+struct LegacyOnlineCustomer : LegacyCustomer {
+    string address, paymentMethod;
+    int priority = 5;
+};
+
+// customers: n registered loyalty customers (1 in 10 online), registry against
+// the old map; register, id lookup + kind check, memory per customer. The old
+// layout's bytes are counted from its node and object sizes (strings short
+// enough to stay inline), the registry reports its own.
+static void bench_customers(size_t n) {
+    vector<string> ids(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = "LOY" + to_string(10000000 + i);
+    vector<size_t> probe(n);
+    mt19937 rng(11);
+    for (auto &x : probe) x = rng() % n;
+    {
+        CustomerRegistry reg;
+        emit("customers", "registry add", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                CustomerNo c = reg.add(i % 10 == 0 ? CustomerKind::Online : CustomerKind::WalkIn, ids[i], "Loyalty member");
+                if (i % 10 == 0) reg.online_profile(c).priority = 3;
+            }
+        }), "ns/op");
+        emit("customers", "registry find+kind", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) benchSink += reg.kind(reg.find(ids[probe[i]])) == CustomerKind::Online;
+        }), "ns/op");
+        emit("customers", "registry bytes/customer", n, (double)reg.memory_bytes() / n, "bytes");
+    }
+    {
+        unordered_map<string, unique_ptr<LegacyCustomer>> m;
+        emit("customers", "map add", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                unique_ptr<LegacyCustomer> c;
+                if (i % 10 == 0) c = make_unique<LegacyOnlineCustomer>();
+                else c = make_unique<LegacyCustomer>();
+                c->id = ids[i]; c->name = "Loyalty member";
+                m.emplace(ids[i], move(c));
+            }
+        }), "ns/op");
+        emit("customers", "map find+dynamic_cast", n, ns_per_op(n, [&] {
+            for (size_t i = 0; i < n; ++i) benchSink += dynamic_cast<LegacyOnlineCustomer*>(m.find(ids[probe[i]])->second.get()) != nullptr;
+        }), "ns/op");
+        size_t node = sizeof(void*) + sizeof(pair<const string, unique_ptr<LegacyCustomer>>) + sizeof(size_t);
+        double bytes = (double)m.bucket_count() * sizeof(void*) + n * node
+                     + (n - (n + 9) / 10) * sizeof(LegacyCustomer) + (n + 9) / 10 * sizeof(LegacyOnlineCustomer);
+        emit("customers", "map bytes/customer est", n, bytes / n, "bytes");
+    }
+}
+
+// sessions: n visits of 8 cart lines with a remove and an undo each, ended
+// by checkout for a regular customer and by abandonment for one-off walk-ins
+// who are then forgotten; the heap held afterwards should not depend on n
+static void bench_sessions(size_t n) {
+    const int lines = 8;
+    SupermarketSystem sys(3);
+    vector<string> bcs;
+    for (int i = 0; i < lines; ++i) {
+        bcs.push_back("SES" + to_string(i));
+        sys.add_product(Product(bcs.back(), "Session item", 1.0, 1 << 30, "2030-01-01", "Bench"));
+    }
+    sys.add_walkin_customer("REG", "Regular");
+    auto fill = [&](const string& cid) {
+        for (auto &bc : bcs) sys.customer_add_to_cart(cid, bc, 2);
+        sys.customer_remove_from_cart(cid, bcs[0], 2);
+        sys.customer_undo(cid);
+    };
+    emit("sessions", "visit + checkout", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            fill("REG");
+            sys.enqueue_walkin_to_cashier("REG");
+            benchSink += (long long)sys.process_checkout_at_cashier(0).lines.size();
+        }
+    }), "ns/visit");
+    vector<string> ids(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = "W" + to_string(i);
+    size_t regBefore = sys.customer_registry().memory_bytes();
+    emit("sessions", "walk-in visit + abandon + forget", n, ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            sys.add_walkin_customer(ids[i], "One-off");
+            fill(ids[i]);
+            sys.enqueue_walkin_to_cashier(ids[i]); // leaves the line with the visit
+            benchSink += sys.end_session(ids[i], true).units;
+        }
+    }), "ns/visit");
+    const CustomerRegistry& reg = sys.customer_registry();
+    emit("sessions", "customers left", n, (double)reg.size(), "customers");
+    emit("sessions", "carts in use", n, (double)reg.active_carts(), "carts");
+    emit("sessions", "carts pooled", n, (double)reg.pooled_carts(), "carts");
+    emit("sessions", "arena blocks pooled", n, (double)SessionArena::pooled_blocks(), "blocks");
+    emit("sessions", "registry growth", n, (double)reg.memory_bytes() - (double)regBefore, "bytes");
+    size_t queued = 0;
+    for (int i = 0; i < sys.cashier_count(); ++i) queued += sys.cashier_queue_length(i);
+    emit("sessions", "queue entries left", n, (double)queued, "entries");
+}
+
+// waves: n online orders of 8 lines over a 400-SKU catalog, fulfilled one at a
+// time and in waves of 1 to 256; orders per second and the pick-list build
+// time per wave (on the worker pool, overlapped with taking and committing).
+// Then the same with a log that makes every commit wait for its fsync, where
+// a wave pays one wait for all of its sales.
+static void bench_waves(size_t n) {
+    const int skus = 400, lines = 8;
+    static const char* cats[] = {"Dairy","Meat","Produce","Snacks","Beverages","Household","Bakery","Toys"};
+    string dir = "bench_waves";
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+    auto setup = [&](SupermarketSystem& sys, size_t orders) {
+        for (int i = 0; i < skus; ++i)
+            sys.add_product(Product("WV" + to_string(i), "Wave item", 3.5, 1 << 30, "2030-01-01", cats[i % 8]));
+        mt19937 rng(5);
+        for (size_t c = 0; c < orders; ++c) {
+            string id = "ON" + to_string(c);
+            sys.add_online_customer(id, "Online", "-", "card", 1 + (int)(rng() % 10));
+            for (int l = 0; l < lines; ++l) sys.customer_add_to_cart(id, "WV" + to_string(rng() % skus), 1 + (int)(rng() % 3));
+            sys.place_online_order(id);
+        }
+    };
+    for (int logged = 0; logged < 2; ++logged) {
+        size_t orders = logged ? min(n, (size_t)2000) : n;
+        string tag = logged ? " sync log" : "";
+        auto fresh = [&](SupermarketSystem& sys) {
+            if (!logged) return;
+            remove((dir + "/wal.log").c_str());
+            remove((dir + "/snapshot.bin").c_str());
+            WalOptions o;
+            o.syncCommit = true;
+            if (!sys.open_wal(dir, o)) { cerr << "cannot open log in " << dir << '\n'; exit(1); }
+        };
+        {
+            SupermarketSystem sys(3);
+            fresh(sys);
+            setup(sys, orders);
+            auto t0 = BenchClock::now();
+            size_t done = 0;
+            while (sys.process_next_online_order().status == Status::Ok) done++;
+            emit("waves", "one at a time" + tag + " orders/s", orders, done / (ms_since(t0) / 1000.0), "orders/s");
+        }
+        for (size_t size : {1, 4, 16, 64, 256}) {
+            SupermarketSystem sys(3);
+            fresh(sys);
+            setup(sys, orders);
+            auto t0 = BenchClock::now();
+            WaveStats st = sys.fulfil_online_waves(size);
+            double ms = ms_since(t0);
+            string name = "wave " + to_string(size) + tag;
+            emit("waves", name + " orders/s", orders, st.orders / (ms / 1000.0), "orders/s");
+            if (logged) continue;
+            emit("waves", name + " pick-list build mean", orders, st.buildNs / 1000.0 / max<size_t>(1, st.waves), "us");
+            emit("waves", name + " pick-list build max", orders, st.maxBuildNs / 1000.0, "us");
+            emit("waves", name + " pick lines per wave", orders, (double)st.pickLines / max<size_t>(1, st.waves), "lines");
+        }
+    }
+}
+
+// scheduler: a simulated 8-hour day of online orders with a two-hour rush at
+// twice the packing capacity, served under four policies; on-time share,
+// mean and max wait overall and for the lowest priority. Then the cost of a
+// push + pop at queue depth n against the sorted linked list it replaced.
+static void bench_scheduler(size_t n) {
+    struct Policy { const char* name; int aging; int urgent; };
+    Policy policies[] = {{"static priority", 0, 0}, {"aging", 300, 0}, {"deadline only", 0, 900}, {"aging + deadline", 300, 900}};
+    const int64_t day = 8 * 3600, serviceSeconds = 20;
+    for (const Policy& pol : policies) {
+        SchedulerOptions o;
+        o.agingSeconds = pol.aging;
+        o.urgentSeconds = pol.urgent;
+        OnlineScheduler q(o);
+        mt19937 rng(21);
+        uniform_real_distribution<double> u(0.0, 1.0);
+        int64_t lowMaxWait = 0;
+        for (int64_t t = 0; t < day || !q.isEmpty(); ++t) {
+            bool rush = t >= 2 * 3600 && t < 4 * 3600;
+            double perSecond = (rush ? 2.0 : 0.6) / serviceSeconds;
+            if (t < day && u(rng) < perSecond) {
+                ScheduledOrder so;
+                so.priority = 1 + (int)(rng() % 10);
+                so.placed = t;
+                q.push(so);
+            }
+            ScheduledOrder got;
+            if (t % serviceSeconds == 0 && q.pop(t, got) && got.priority == 10) lowMaxWait = max(lowMaxWait, t - got.placed);
+        }
+        const SchedulerStats& st = q.stats();
+        string name = pol.name;
+        emit("scheduler", name + " on time", st.served, st.on_time_percent(), "%");
+        emit("scheduler", name + " mean wait", st.served, st.mean_wait() / 60.0, "min");
+        emit("scheduler", name + " max wait", st.served, st.maxWait / 60.0, "min");
+        emit("scheduler", name + " max wait priority 10", st.served, lowMaxWait / 60.0, "min");
+    }
+    struct LegacyOrder { int priority; int64_t placed; };
+    struct LegacyCompare {
+        bool operator()(const LegacyOrder& a, const LegacyOrder& b) const {
+            if (a.priority != b.priority) return a.priority > b.priority;
+            return a.placed > b.placed;
+        }
+    };
+    mt19937 rng(3);
+    MyPriorityQueue<LegacyOrder, LegacyCompare> legacy;
+    OnlineScheduler q;
+    for (size_t i = 0; i < n; ++i) {
+        int p = 1 + (int)(rng() % 10);
+        legacy.push(LegacyOrder{p, (int64_t)i});
+        ScheduledOrder so; so.priority = p; so.placed = (int64_t)i;
+        q.push(so);
+    }
+    const size_t ops = 20000;
+    emit("scheduler", "sorted list push+pop", n, ns_per_op(ops, [&] {
+        for (size_t i = 0; i < ops; ++i) {
+            legacy.push(LegacyOrder{1 + (int)(rng() % 10), (int64_t)(n + i)});
+            benchSink += legacy.top().priority; legacy.pop();
+        }
+    }), "ns/op");
+    emit("scheduler", "scheduler push+pop", n, ns_per_op(ops, [&] {
+        ScheduledOrder got;
+        for (size_t i = 0; i < ops; ++i) {
+            ScheduledOrder so; so.priority = 1 + (int)(rng() % 10); so.placed = (int64_t)(n + i);
+            q.push(so);
+            q.pop((int64_t)(n + i), got);
+            benchSink += got.priority;
+        }
+    }), "ns/op");
+}
+
+// chain: 16 stores in 4 regions on one shared catalog. Sales run on the
+// stores' own threads, and the chain report fans out, with one worker and
+// with one per core; then stock lookups, transfers, and how much of the
+// shared catalog the stores ended up copying.
+static void bench_chain(size_t n) {
+    const size_t stores = 16, skus = 20000;
+    vector<StoreInfo> info;
+    for (size_t i = 0; i < stores; ++i) info.push_back(StoreInfo{"S" + to_string(i), "R" + to_string(i % 4)});
+    auto catalog = make_shared<const SharedCatalog>(synthetic_products(skus, false));
+    auto sell = [&](StoreChain& chain) {
+        vector<future<void>> done;
+        for (size_t s = 0; s < stores; ++s)
+            done.push_back(chain.at(s, [=](SupermarketSystem& sys) {
+                mt19937 rng((unsigned)s);
+                for (size_t i = s; i < n; i += stores) {
+                    string id = "C" + to_string(i);
+                    sys.add_walkin_customer(id, "Shopper");
+                    for (int l = 0; l < 4; ++l) sys.customer_add_to_cart(id, "P" + to_string(rng() % skus), 1);
+                    sys.enqueue_walkin_to_cashier(id);
+                    sys.process_checkout_at_cashier(0);
+                    sys.process_checkout_at_cashier(1);
+                    sys.process_checkout_at_cashier(2);
+                }
+            }));
+        for (auto &f : done) f.get();
+    };
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    const size_t reps = 20;
+    vector<unsigned> workerCounts = {1};
+    if (cores > 1) workerCounts.push_back(cores);
+    for (unsigned threads : workerCounts) {
+        StoreChain chain(info, catalog, threads);
+        auto t0 = BenchClock::now();
+        sell(chain);
+        emit("chain", "sales " + to_string(chain.worker_count()) + " workers", n, n / (ms_since(t0) / 1000.0), "sales/s");
+        emit("chain", "chain report " + to_string(chain.worker_count()) + " workers", n, ns_per_op(reps, [&] {
+            for (size_t i = 0; i < reps; ++i) benchSink += chain.chain_report().revenue;
+        }) / 1e6, "ms");
+    }
+    StoreChain chain(info, catalog);
+    sell(chain);
+    const size_t ops = 2000;
+    emit("chain", "total stock of a barcode", stores, ns_per_op(ops, [&] {
+        for (size_t i = 0; i < ops; ++i) benchSink += chain.total_stock("P" + to_string(i % skus));
+    }) / 1000.0, "us");
+    long long before = chain.total_stock("P7");
+    emit("chain", "transfer", stores, ns_per_op(ops, [&] {
+        for (size_t i = 0; i < ops; ++i)
+            benchSink += (int)chain.transfer_stock("S" + to_string(i % stores), "S" + to_string((i + 1) % stores), "P7", 1).status;
+    }) / 1000.0, "us");
+    if (chain.total_stock("P7") != before) { cerr << "transfers changed the chain's stock\n"; exit(1); }
+    size_t copied = 0;
+    for (size_t c : chain.shared_rows_copied()) copied += c;
+    emit("chain", "catalog rows copied per store", skus, (double)copied / stores, "rows");
+}
+
+// audit: a day of n checkouts over a 20k-SKU catalog (some bills voided, some
+// carts left open), then a full stock audit with one thread and one per core;
+// what an audit costs, and the cost every cart add pays for the book. Last, an
+// undo of a cart remove the shelf cannot cover must be refused, and the books
+// must still balance.
+static void bench_audit(size_t n) {
+    const int skus = 20000, lines = 6;
+    SupermarketSystem sys(4);
+    for (int i = 0; i < skus; ++i)
+        sys.add_product(Product("A" + to_string(i), "Audit item", 2.5, 1 << 20, "2030-01-01", "Bench"));
+    mt19937 rng(11);
+    auto t0 = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        string id = "C" + to_string(i);
+        sys.add_walkin_customer(id, "Shopper");
+        for (int l = 0; l < lines; ++l) sys.customer_add_to_cart(id, "A" + to_string(rng() % skus), 1 + (int)(rng() % 3));
+        if (i % 50 == 0) continue; // still shopping when the audit runs
+        sys.enqueue_walkin_to_cashier(id);
+        sys.process_checkout_at_cashier((int)(i % 4));
+        if (i % 97 == 0) sys.cashier_undo_last_bill((int)(i % 4));
+    }
+    emit("audit", "day of checkouts", n, n / (ms_since(t0) / 1000.0), "sales/s");
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    vector<unsigned> threadCounts = {1};
+    if (cores > 1) threadCounts.push_back(cores);
+    const size_t reps = 5;
+    for (unsigned threads : threadCounts) {
+        StockAudit a;
+        emit("audit", "full audit " + to_string(threads) + " threads", n, ns_per_op(reps, [&] {
+            for (size_t r = 0; r < reps; ++r) a = sys.audit_stock(threads);
+        }) / 1e6, "ms");
+        if (!a.clean()) { cerr << "audit of a consistent day found " << a.discrepancies.size() << " SKUs\n"; exit(1); }
+        emit("audit", "skus checked", n, (double)a.skus, "skus");
+    }
+    // undo a remove after the shelf ran dry: refused, and it stays undoable once stock is back
+    sys.add_product(Product("SCARCE", "Last one", 1.0, 1, "2030-01-01", "Bench"));
+    sys.add_walkin_customer("X1", "First"); sys.add_walkin_customer("X2", "Second");
+    sys.customer_add_to_cart("X1", "SCARCE", 1);
+    sys.customer_remove_from_cart("X1", "SCARCE", 1);
+    sys.customer_add_to_cart("X2", "SCARCE", 1);
+    CartUndoResult u = sys.customer_undo("X1");
+    StockAudit a = sys.audit_stock();
+    if (u.status != Status::OutOfStock || !a.clean()) {
+        cerr << "undo without stock: " << status_message(u.status) << ", " << a.discrepancies.size() << " SKUs off\n";
+        exit(1);
+    }
+    sys.customer_remove_from_cart("X2", "SCARCE", 1);
+    u = sys.customer_undo("X1");
+    a = sys.audit_stock();
+    if (u.status != Status::Ok || u.qty != 1 || !a.clean()) {
+        cerr << "undo once stock was back: " << status_message(u.status) << ", " << a.discrepancies.size() << " SKUs off\n";
+        exit(1);
+    }
+    emit("audit", "unbacked undo refused", n, 1, "checks");
+}
+
+// memory: the engine at catalog size n with n/4 sales and 1% of shoppers still
+// in the store; bytes and overhead per structure, and what the report costs.
+// Prices are random and categories many, so the BSTs stay shallow enough to build.
+static void bench_memory(size_t n) {
+    SupermarketSystem sys(4);
+    mt19937 rng(5);
+    for (size_t i = 0; i < n; ++i)
+        sys.add_product(Product("M" + to_string(1000000 + i), "Catalog item " + to_string(i), 0.5 + rng() % 100000 / 100.0,
+                                1 << 20, "2030-01-01", "Aisle " + to_string(i % 1000)));
+    size_t sales = n / 4;
+    for (size_t i = 0; i < sales; ++i) {
+        string id = "C" + to_string(i);
+        sys.add_walkin_customer(id, "Shopper");
+        for (int l = 0; l < 6; ++l) sys.customer_add_to_cart(id, "M" + to_string(1000000 + rng() % n), 1);
+        if (i % 100 == 0) continue;
+        sys.enqueue_walkin_to_cashier(id);
+        sys.process_checkout_at_cashier((int)(i % 4));
+    }
+    sys.rebuild_bst();
+    MemoryReport r;
+    double ms = ns_per_op(1, [&] { r = sys.memory_report(); }) / 1e6;
+    for (auto &p : r.parts) {
+        emit("memory", p.name + " bytes", p.elements, (double)p.bytes, "bytes");
+        emit("memory", p.name + " overhead", p.elements, p.overhead_percent(), "%");
+    }
+    MemoryUsage t = r.total();
+    emit("memory", "total bytes", n, (double)t.bytes, "bytes");
+    emit("memory", "bytes per product", n, (double)t.bytes / n, "bytes");
+    emit("memory", "report", n, ms, "ms");
+}
+
+// listings written to a file: operator<< per field (the old console path)
+// against rows rendered into an OutBuffer; plus one page of a big inventory
+static void bench_output(size_t n) {
+    const char* path = "bench_output.txt";
+    vector<Product> rows;
+    rows.reserve(n);
+    mt19937 rng(9);
+    for (size_t i = 0; i < n; ++i)
+        rows.emplace_back("P" + to_string(1000000 + i), "Catalog item " + to_string(i), 0.5 + rng() % 100000 / 100.0,
+                          (int)(rng() % 500), "2030-01-01", "Aisle " + to_string(i % 100));
+    double streamMs, bufferMs;
+    {
+        ofstream os(path);
+        auto t0 = BenchClock::now();
+        for (const Product &p : rows)
+            os << p.barcode << " | " << p.name << " | " << p.price << " LE "
+               << " | stock: " << p.stock << " | expiry: " << p.expiry << " | " << p.category << '\n';
+        os.flush();
+        streamMs = ms_since(t0);
+    }
+    size_t writes = 0;
+    {
+        FILE* f = fopen(path, "wb");
+        OutputSink sink = file_sink(f);
+        auto t0 = BenchClock::now();
+        {
+            OutBuffer out([&](const char* p, size_t k) { writes++; return sink(p, k); });
+            for (const Product &p : rows) write_product(out, p);
+        }
+        fflush(f);
+        bufferMs = ms_since(t0);
+        fclose(f);
+    }
+    emit("output", "ostream products", n, streamMs * 1e6 / n, "ns/row");
+    emit("output", "buffer products", n, bufferMs * 1e6 / n, "ns/row");
+    emit("output", "buffer sink writes", n, (double)writes, "writes");
+
+    SalesList sales;
+    synthetic_sales(sales, n, 5000);
+    vector<const SaleRecord*> ledger = sales.ledger();
+    {
+        ofstream os(path);
+        auto t0 = BenchClock::now();
+        for (const SaleRecord* s : ledger) {
+            os << s->saleId << " | Cust: " << s->customerId << " | " << (s->online ? "Online" : "Walk-in")
+               << " | LE " << s->total << " | " << s->time << '\n';
+            for (auto &it : s->items) os << "   - " << it.first << " x" << it.second << '\n';
+        }
+        os.flush();
+        streamMs = ms_since(t0);
+    }
+    {
+        FILE* f = fopen(path, "wb");
+        auto t0 = BenchClock::now();
+        print_sale_records(ledger, file_sink(f));
+        fflush(f);
+        bufferMs = ms_since(t0);
+        fclose(f);
+    }
+    emit("output", "ostream sales", n, streamMs * 1e6 / n, "ns/sale");
+    emit("output", "buffer sales", n, bufferMs * 1e6 / n, "ns/sale");
+
+    Inventory inv;
+    for (auto &p : rows) inv.add_product(move(p));
+    OutputSink discard = [](const char*, size_t) { return true; };
+    double allMs = ns_per_op(1, [&] { OutBuffer out(discard); inv.write_all(out); }) / 1e6;
+    double pageUs = ns_per_op(1, [&] { OutBuffer out(discard); inv.write_all(out, RowWindow{n / 2, 20}); }) / 1e3;
+    emit("output", "full listing", n, allMs, "ms");
+    emit("output", "page of 20 mid-listing", n, pageUs, "us");
+    remove(path);
+}
+
+// EAN-13 with its check digit
+static string synthetic_ean(mt19937& rng) {
+    string s(13, '0');
+    int sum = 0;
+    for (int i = 0; i < 12; ++i) {
+        s[i] = (char)('0' + rng() % 10);
+        sum += (s[i] - '0') * (i % 2 ? 3 : 1);
+    }
+    s[12] = (char)('0' + (10 - sum % 10) % 10);
+    return s;
+}
+
+// a scan stream off a file: getline + per-line checks against ScanReader
+// (scalar and SSE2 decoding), then the same stream into a cart both ways
+static void bench_scan(size_t n) {
+    const char* path = "bench_scans.txt";
+    mt19937 rng(11);
+    vector<string> skus;
+    for (int i = 0; i < 2000; ++i) skus.push_back(synthetic_ean(rng));
+    {
+        ofstream os(path, ios::binary);
+        for (size_t i = 0; i < n; ++i) {
+            string bc = skus[rng() % skus.size()];
+            if (i % 100 == 7) bc[12] = (char)('0' + (bc[12] - '0' + 1) % 10); // misread
+            os << bc << (i % 3 ? "\n" : "\r\n");
+        }
+    }
+    auto getline_keys = [&](auto consume) {
+        ifstream is(path, ios::binary);
+        string line;
+        size_t valid = 0;
+        while (getline(is, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line.size() > 16) continue;
+            if (line.find_first_not_of("0123456789") != string::npos) continue;
+            if (line.size() == 12 || line.size() == 13) {
+                int sum = 0;
+                for (size_t i = 0; i < line.size(); ++i) sum += (line[line.size() - 1 - i] - '0') * (i % 2 ? 3 : 1);
+                if (sum % 10) continue;
+            }
+            valid++;
+            consume(line, scan_key(line.size() == 12 ? 13 : (unsigned)line.size(), stoull(line)));
+        }
+        return valid;
+    };
+    uint64_t sink = 0;
+    size_t valid = 0;
+    double ms = ns_per_op(1, [&] { valid = getline_keys([&](const string&, uint64_t k) { sink += k; }); }) / 1e6;
+    emit("scan", "getline scans/s", n, n / ms * 1e3, "scans/s");
+    for (bool simd : {false, true}) {
+        size_t got = 0;
+        double t = ns_per_op(1, [&] {
+            FILE* f = fopen(path, "rb");
+            ScanReader in(f);
+            in.set_vectorized(simd);
+            ScanBatch b;
+            while (in.next(b)) { got += b.keys.size(); for (uint64_t k : b.keys) sink += k; }
+            fclose(f);
+        }) / 1e6;
+        emit("scan", simd ? "reader sse2 scans/s" : "reader scalar scans/s", n, n / t * 1e3, "scans/s");
+        if (got != valid) emit("scan", "MISMATCH valid reads", n, (double)got, "reads");
+    }
+    emit("scan", "valid reads", n, (double)valid, "reads");
+
+    // into a cart: one add per read against one add per code per batch
+    size_t m = min<size_t>(n, 200000);
+    auto fresh = [&](SupermarketSystem& sys) {
+        for (auto &bc : skus) sys.add_product(Product(bc, "Item " + bc, 9.99, 1 << 30, "2030-01-01", "Aisle"));
+        sys.add_walkin_customer("C1", "Scanner");
+    };
+    {
+        ofstream os(path, ios::binary);
+        for (size_t i = 0; i < m; ++i) os << skus[rng() % 50] << '\n'; // a basket of repeat items
+    }
+    {
+        SupermarketSystem sys(1);
+        fresh(sys);
+        double t = ns_per_op(1, [&] { getline_keys([&](const string& bc, uint64_t) { sys.customer_add_to_cart("C1", bc, 1); }); }) / 1e6;
+        emit("scan", "getline into cart", m, m / t * 1e3, "scans/s");
+    }
+    {
+        SupermarketSystem sys(1);
+        fresh(sys);
+        FILE* f = fopen(path, "rb");
+        ScanReader in(f);
+        ScanIngest r = sys.scan_into_cart("C1", in);
+        fclose(f);
+        emit("scan", "reader into cart", m, m / (r.elapsedNs / 1e9), "scans/s");
+        emit("scan", "cart adds", m, (double)r.adds, "adds");
+    }
+    remove(path);
+    volatile uint64_t keep = sink; // the loops above must not be optimised away
+    (void)keep;
+}
+
+int main(int argc, char** argv) {
+    string section = argc > 1 ? argv[1] : "all";
+    size_t n = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+    cout << "bench,case,n,value,unit\n";
+    if (section == "all" || section == "report") bench_report(n ? n : 1000000);
+    if (section == "all" || section == "archive") bench_archive(n ? n : 1000000);
+    if (section == "all" || section == "basket") bench_basket(n ? n : 500000);
+    if (section == "all" || section == "sketch") bench_sketch(n ? n : 1000000);
+    if (section == "all" || section == "containers") bench_containers(n);
+    if (section == "all" || section == "wal") bench_wal(n ? n : 1000000);
+    if (section == "all" || section == "catalog") bench_catalog(n ? n : 2000000);
+    if (section == "all" || section == "startup") bench_startup(n ? n : 10000);
+    if (section == "all" || section == "feed") bench_feed(n ? n : 1000000);
+    if (section == "all" || section == "snapshot") bench_snapshot(n ? n : 20000);
+    if (section == "all" || section == "customers") bench_customers(n ? n : 2000000);
+    if (section == "all" || section == "sessions") bench_sessions(n ? n : 200000);
+    if (section == "all" || section == "waves") bench_waves(n ? n : 20000);
+    if (section == "all" || section == "scheduler") bench_scheduler(n ? n : 10000);
+    if (section == "all" || section == "chain") bench_chain(n ? n : 50000);
+    if (section == "all" || section == "audit") bench_audit(n ? n : 200000);
+    if (section == "all" || section == "memory") bench_memory(n ? n : 200000);
+    if (section == "all" || section == "output") bench_output(n ? n : 500000);
+    if (section == "all" || section == "scan") bench_scan(n ? n : 5000000);
+    return 0;
+}
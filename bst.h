@@ -2,6 +2,7 @@
 #pragma once
 #include <vector>
 #include "product.h"
+#include "memory.h"
 using namespace std;
 
 struct BSTNode {
@@ -15,6 +16,23 @@ struct BSTNode {
     }
 };
 
+// every node holds a full copy of its product; walked with an explicit stack,
+// since a tree built from sorted input is as deep as it is long
+inline MemoryUsage bst_memory(const string& name, const BSTNode* root) {
+    MemoryUsage m(name);
+    vector<const BSTNode*> todo;
+    if (root) todo.push_back(root);
+    while (!todo.empty()) {
+        const BSTNode* n = todo.back(); todo.pop_back();
+        m.elements++;
+        account_nodes(m, 1, sizeof(Product), sizeof(BSTNode));
+        account_product(m, n->p);
+        if (n->left) todo.push_back(n->left);
+        if (n->right) todo.push_back(n->right);
+    }
+    return m;
+}
+
 class ProductBST {
 private:
     BSTNode* root = nullptr;
@@ -63,6 +81,7 @@ public:
         inorder(root, out);
         return out;
     }
+    MemoryUsage memory_usage() const { return bst_memory("bst by price", root); }
 };
 
 class ProductBSTByCategory {
@@ -109,4 +128,5 @@ class ProductBSTByCategory {
             inorder(root, out);
             return out;
         }
+        MemoryUsage memory_usage() const { return bst_memory("bst by category", root); }
 };
\ No newline at end of file
@@ -1,50 +1,37 @@
 // cart.h
 #pragma once
 #include <string>
-#include "stack.h"
+#include <string_view>
+#include "arena.h"
 #include <iostream>
 #include <vector>
 #include "product.h"
 #include "inventory.h"
+#include "results.h"
+#include "output.h"
 using namespace std;
 
+inline const LineTemplate CART_ROW("{0} | {1} | {2} | qty: {3} | unit: LE{4}\n");
+
+// Lines and actions live in the cart's SessionArena (arena.h), text included,
+// so a visit costs a few bump allocations and ends with one release.
 struct CartItem {
-    string barcode;
-    string name;
-    string category;
-    double unitPrice;
-    int qty;
-    CartItem* next;
-    CartItem() {
-        barcode = "";
-        name = "";
-        category = "";
-        unitPrice = 0.0;
-        qty = 0;
-        next = nullptr;
-    }
-    CartItem(const string& b, const string& n, const string& c, double up, int q){
-        barcode = b;
-        name = n;
-        category = c;
-        unitPrice = up;
-        qty = q;
-        next = nullptr;
-    }
+    string_view barcode;
+    string_view name;
+    string_view category;
+    double unitPrice = 0.0;
+    int qty = 0;
+    CartItem* next = nullptr;
 };
 
 enum class CartActionType { ADD, REMOVE };
 
+// undo history, newest first
 struct CartAction {
     CartActionType type;
-    string barcode;
+    string_view barcode;
     int qty;
-    CartAction() : type(CartActionType::ADD), barcode(""), qty(0) {}
-    CartAction(CartActionType t, const string& b, int q) {
-        type = t;
-        barcode = b;
-        qty = q;
-    }
+    CartAction* next;
 };
 
 struct Coupon {
@@ -62,31 +49,38 @@ struct Coupon {
 
 class ShoppingCart {
 private:
+    SessionArena arena;
     CartItem* head = nullptr;
-    MyStack<CartAction> actions;
+    CartItem* spare = nullptr;   // removed lines, reused before the arena grows
+    CartAction* actions = nullptr;
 
     void add_item_noaction_internal(const Product& p, int qty) {
-        if (qty <= 0){
-            cout << "Quantity must be positive.\n";
-            return;
-        }
+        if (qty <= 0) return;
         CartItem* node = find_node(p.barcode);
-        if (node) node->qty += qty;
+        if (node) { node->qty += qty; return; }
+        // a line removed earlier in the visit comes back with its text already copied
+        CartItem** link = &spare;
+        while (*link && (*link)->barcode != p.barcode) link = &(*link)->next;
+        if (*link) { node = *link; *link = node->next; }
         else {
-            CartItem* n = new CartItem(p.barcode, p.name, p.category, p.price, qty);
-            n->next = head; head = n;
+            node = arena.make<CartItem>();
+            node->barcode = arena.copy(p.barcode);
+            node->name = arena.copy(p.name);
+            node->category = arena.copy(p.category);
         }
+        node->unitPrice = p.price;
+        node->qty = qty;
+        node->next = head; head = node;
     }
 
-    int remove_item_noaction_internal(const string& barcode, int qty) {
-        if (qty <= 0){
-            cout << "Quantity must be positive.\n";
-            return 0;
-        }
+    // kept: the line's own copy of the barcode, which outlives the line
+    int remove_item_noaction_internal(string_view barcode, int qty, string_view* kept = nullptr) {
+        if (qty <= 0) return 0;
         CartItem* prev = nullptr;
         CartItem* cur = head;
         while (cur != nullptr) {
             if (cur->barcode == barcode) {
+                if (kept) *kept = cur->barcode;
                 if (qty >= cur->qty) {
                     int removed = cur->qty;
                     if (prev != nullptr) {
@@ -95,7 +89,7 @@ private:
                     else {
                         head = cur->next;
                     }
-                    delete cur;
+                    cur->next = spare; spare = cur;
                     return removed;
                 } 
                 else {
@@ -108,29 +102,37 @@ private:
         return 0;
     }
 
-    vector<Coupon> coupons = {
-        {"LOVEEGYPT", 10.0},
-        {"SAVE5", 5.0},
-        {"OFFER20", 20.0},
-        {"BLACKFRIDAY", 15.0}
-    };
+    void push_action(CartActionType t, string_view barcode, int qty) {
+        actions = arena.make<CartAction>(CartAction{t, barcode, qty, actions});
+    }
+
     Coupon appliedCoupon;
     bool couponApplied = false;
 
 public:
     ShoppingCart() = default;
-    ~ShoppingCart() { clear(); }
+    ShoppingCart(const ShoppingCart&) = delete;
+    ShoppingCart& operator=(const ShoppingCart&) = delete;
+
+    // the codes every till accepts (shared, not copied into each cart)
+    static const vector<Coupon>& coupons() {
+        static const vector<Coupon> list = {
+            {"LOVEEGYPT", 10.0},
+            {"SAVE5", 5.0},
+            {"OFFER20", 20.0},
+            {"BLACKFRIDAY", 15.0}
+        };
+        return list;
+    }
 
+    // drops every line and action at once
     void clear() {
-        while (head != nullptr) { 
-            CartItem* t = head; 
-            head = head->next; 
-            delete t; 
-        }
-        while (!actions.isEmpty()) actions.pop();
+        head = spare = nullptr;
+        actions = nullptr;
+        arena.release();
     }
 
-    CartItem* find_node(const string& barcode) {
+    CartItem* find_node(string_view barcode) {
         CartItem* cur = head;
         while (cur != nullptr) {
             if (cur->barcode == barcode){
@@ -143,56 +145,78 @@ public:
         return nullptr;
     }
 
-    void add_item(const Product& p, int qty) {
-        if (qty <= 0){
-            cout << "Quantity must be positive.\n";
-            return;
-        }
+    bool add_item(const Product& p, int qty) {
+        if (qty <= 0) return false;
         add_item_noaction_internal(p, qty);
-        actions.push(CartAction(CartActionType::ADD, p.barcode, qty));
+        push_action(CartActionType::ADD, find_node(p.barcode)->barcode, qty);
+        return true;
     }
 
     // removes up to qty items; returns number of items actually removed (0 if none)
-    int remove_item(const string& barcode, int qty) {
-        if (qty <= 0){
-            cout << "Quantity must be positive.\n";
-            return 0;
-        }
-        int removed = remove_item_noaction_internal(barcode, qty);
+    int remove_item(string_view barcode, int qty) {
+        if (qty <= 0) return 0;
+        string_view kept;
+        int removed = remove_item_noaction_internal(barcode, qty, &kept);
         if (removed == 0) return 0;
-        actions.push(CartAction(CartActionType::REMOVE, barcode, removed));
+        push_action(CartActionType::REMOVE, kept, removed);
         return removed;
     }
 
-    bool apply_coupon(const string& code) {
-        if (couponApplied) {
-            cout << "A coupon has already been applied.\n";
-            return false;
-        }
-        for (const auto& c : coupons) {
+    Status apply_coupon(const string& code) {
+        if (couponApplied) return Status::CouponAlreadyApplied;
+        for (const auto& c : coupons()) {
             if (c.code == code) {
                 appliedCoupon = c;
                 couponApplied = true;
-                return true;
+                return Status::Ok;
             }
         }
-        cout << "Invalid coupon code.\n";
-        return false;
+        return Status::InvalidCoupon;
     }
 
-    double total() const {
+    // total of the lines before any coupon
+    double subtotal() const {
         double t = 0;
-        CartItem* cur = head;
-        while (cur != nullptr) {
-             t += cur->unitPrice * cur->qty;
-            cur = cur->next; 
-        } 
+        for (CartItem* cur = head; cur != nullptr; cur = cur->next) t += cur->unitPrice * cur->qty;
+        return t;
+    }
+
+    double total() const {
+        double t = subtotal();
         if(couponApplied){
             t = t * (1 - appliedCoupon.discountRate / 100.0);
         }
         return t;
     }
 
+    // (barcode, qty) lines as recorded on the sale
+    vector<pair<string,int>> line_items() const {
+        vector<pair<string,int>> v;
+        for (CartItem* cur = head; cur != nullptr; cur = cur->next) v.push_back({string(cur->barcode), cur->qty});
+        return v;
+    }
+
+    vector<ReceiptLine> receipt_lines() const {
+        vector<ReceiptLine> v;
+        for (CartItem* cur = head; cur != nullptr; cur = cur->next) {
+            ReceiptLine l;
+            l.barcode = string(cur->barcode); l.name = string(cur->name); l.category = string(cur->category);
+            l.unitPrice = cur->unitPrice; l.qty = cur->qty;
+            v.push_back(l);
+        }
+        return v;
+    }
+
+    // nothing in it, nothing to undo, no coupon: the same as a new cart
+    bool idle() const { return head == nullptr && actions == nullptr && !couponApplied; }
+
+    // back to a new cart, for the next visit; O(1) whatever the visit held
+    void reset() {
+        clear();
+        couponApplied = false;
+        appliedCoupon = Coupon();
+    }
+
     bool empty() const {
          if (head == nullptr){
              return true;
@@ -202,43 +226,56 @@ public:
          }
     }
 
-    void print_cart() {
-        cout << "Cart contents:\n";
-        CartItem* cur = head;
-        while (cur!= nullptr) {
-            cout << cur->barcode << " | " << cur->name << " | " << cur->category << " | qty: " << cur->qty
-                 << " | unit: LE" << cur->unitPrice << '\n';
-            cur = cur->next;
-        }
-        cout << "Total before discount: LE " << total() << '\n';
+    void write_cart(OutBuffer& out) const {
+        out.text("Cart contents:\n");
+        for (CartItem* cur = head; cur != nullptr; cur = cur->next)
+            CART_ROW.render(out, {cur->barcode, cur->name, cur->category, cur->qty, Money{cur->unitPrice}});
+        out.text("Total before discount: LE ").money(Money{total()}).ch('\n');
+    }
+    void print_cart(const OutputSink& sink = console_sink()) const {
+        OutBuffer out(sink);
+        write_cart(out);
     }
 
     // The undo functions require Inventory type; forward declare or define in caller.
     friend class Inventory; // allow Inventory access in undo if needed by design
 
-    // Undo the last cart action and update inventory accordingly.
-    // Returns pair(success, message).
-    pair<bool,string> undo(Inventory& inv) {
-        if (actions.isEmpty()) { 
-            return {false, "No actions to undo"};
-        } 
-        CartAction act = actions.top(); actions.pop();
+    // barcode the next undo() will touch ("" if there is nothing to undo)
+    string last_action_barcode() const { return actions == nullptr ? string() : string(actions->barcode); }
+
+    // lines in the cart, newest first, for callers that walk them
+    const CartItem* lines() const { return head; }
+    size_t line_count() const { size_t n = 0; for (CartItem* cur = head; cur != nullptr; cur = cur->next) ++n; return n; }
+    size_t arena_bytes() const { return arena.bytes_used(); }
+    size_t arena_reserved() const { return arena.bytes_reserved(); }
+
+    // Undo the last cart action and update inventory accordingly. Putting a
+    // removed line back needs the shelf to cover it; if it cannot, nothing
+    // changes, the action stays to be undone later and the status is OutOfStock.
+    CartUndoResult undo(Inventory& inv) {
+        CartUndoResult r;
+        if (actions == nullptr) { r.status = Status::NothingToUndo; return r; }
+        CartAction act = *actions;
+        r.barcode = string(act.barcode);
         if (act.type == CartActionType::ADD) {
+            actions = act.next;
             // Undo adding to cart: remove from cart, restore inventory
+            r.wasAdd = true;
             int removed = remove_item_noaction_internal(act.barcode, act.qty);
-            if (removed <= 0){
-                return {false, "Nothing to remove from cart"};
-            }
-            inv.update_stock(act.barcode, removed); // restore stock
-            return {true, "Undid add: restored " + to_string(removed) + " items to inventory"};
+            if (removed <= 0) { r.status = Status::NotInCart; return r; }
+            inv.update_stock(r.barcode, removed); // restore stock
+            r.qty = removed;
         } 
         else {
             // Undo removing from cart: add back to cart, decrease inventory
-            Product* p = inv.find(act.barcode);
-            if (p == nullptr) return {false, "Product not found in inventory to restore into cart"};
+            Product* p = inv.find(r.barcode);
+            if (p == nullptr) { actions = act.next; r.status = Status::ProductNotFound; return r; }
+            if (p->stock < act.qty) { r.status = Status::OutOfStock; return r; }
+            actions = act.next;
             add_item_noaction_internal(*p, act.qty);
-            inv.update_stock(act.barcode, -act.qty);
-            return {true, "Undid remove: returned " + to_string(act.qty) + " items to cart"};
+            inv.move_stock(*p, -act.qty);
+            r.qty = act.qty;
         }
+        return r;
     }
 };
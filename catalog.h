@@ -0,0 +1,233 @@
+// catalog.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include "inventory.h"
+#include "archive.h"
+#include "mmap_file.h"
+using namespace std;
+
+// Catalog import/export. Two formats, told apart by their first bytes:
+//  - CSV with the columns barcode,name,price,stock,expiry,category (header
+//    optional, RFC 4180 quoting), parsed straight out of the mapped file;
+//  - binary ".smc": CatalogHeader, `count` CatalogRow entries, then one blob
+//    holding each row's barcode, name, expiry and category back to back.
+// Rows are checked like SupermarketSystem::add_product; a barcode that is
+// already known is a duplicate and the first one wins.
+const char CATALOG_MAGIC[4] = {'S','M','S','C'};
+const uint32_t CATALOG_VERSION = 1;
+
+struct CatalogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t blobBytes;
+};
+
+struct CatalogRow {
+    uint64_t strOff; // barcode, name, expiry, category start here in the blob
+    double price;
+    int32_t stock;
+    uint16_t len[4];
+};
+
+struct CatalogLoadStats {
+    size_t rows = 0;
+    size_t loaded = 0;
+    size_t duplicates = 0;
+    size_t rejected = 0;
+    vector<string> problems; // the first few, with line (CSV) or row (binary) numbers
+    double millis = 0.0;
+
+    static const size_t MAX_PROBLEMS = 20;
+    void note(size_t where, const string& what) {
+        if (problems.size() < MAX_PROBLEMS) problems.push_back("line " + to_string(where) + ": " + what);
+    }
+};
+
+inline bool catalog_row_valid(const Product& p) {
+    return !p.barcode.empty() && !p.category.empty() && isfinite(p.price) && p.price >= 0.0 && p.stock >= 0;
+}
+
+// adds one parsed row and keeps the counters
+inline void catalog_add(Inventory& inv, Product&& p, size_t where, CatalogLoadStats& st) {
+    st.rows++;
+    if (!catalog_row_valid(p)) { st.rejected++; st.note(where, "invalid product " + p.barcode); return; }
+    string barcode = p.barcode;
+    if (!inv.add_product(move(p))) { st.duplicates++; st.note(where, "duplicate barcode " + barcode); return; }
+    st.loaded++;
+}
+
+// splits one CSV record into fields; handles quotes and "" escapes.
+// p is left at the start of the next record.
+inline void csv_fields(const char*& p, const char* end, vector<string>& out) {
+    out.clear();
+    string cur;
+    bool quoted = false;
+    for (; p < end; ++p) {
+        char c = *p;
+        if (quoted) {
+            if (c != '"') cur += c;
+            else if (p + 1 < end && p[1] == '"') { cur += '"'; ++p; }
+            else quoted = false;
+        } else if (c == '"') quoted = true;
+        else if (c == ',') { out.push_back(move(cur)); cur.clear(); }
+        else if (c == '\n') { ++p; break; }
+        else if (c != '\r') cur += c;
+    }
+    out.push_back(move(cur));
+}
+
+// long long, since long is 32 bits on Windows and strtol saturates there
+inline bool parse_int_field(const string& s, int& v) {
+    if (s.empty()) return false;
+    char* e = nullptr;
+    errno = 0;
+    long long x = strtoll(s.c_str(), &e, 10);
+    if (*e != '\0' || errno == ERANGE || x < INT32_MIN || x > INT32_MAX) return false;
+    v = (int)x;
+    return true;
+}
+
+inline bool parse_price_field(const string& s, double& v) {
+    if (s.empty()) return false;
+    char* e = nullptr;
+    v = strtod(s.c_str(), &e);
+    return *e == '\0' && isfinite(v); // no inf or nan
+}
+
+inline bool load_catalog_csv(const char* data, size_t size, Inventory& inv, CatalogLoadStats& st) {
+    const char* p = data;
+    const char* end = data + size;
+    size_t lines = 0;
+    for (const char* q = p; (q = (const char*)memchr(q, '\n', (size_t)(end - q))) != nullptr; ++q) lines++;
+    inv.reserve(inv.size() + lines + 1);
+
+    vector<string> f;
+    size_t line = 0;
+    while (p < end) {
+        csv_fields(p, end, f);
+        line++;
+        if (f.size() == 1 && f[0].empty()) continue; // blank line
+        if (line == 1 && f[0] == "barcode") continue;
+        if (f.size() != 6) {
+            st.rows++; st.rejected++;
+            st.note(line, "expected 6 fields, got " + to_string(f.size()));
+            continue;
+        }
+        Product pr;
+        if (!parse_price_field(f[2], pr.price) || !parse_int_field(f[3], pr.stock)) {
+            st.rows++; st.rejected++;
+            st.note(line, "bad price or stock for " + f[0]);
+            continue;
+        }
+        pr.barcode = move(f[0]); pr.name = move(f[1]); pr.expiry = move(f[4]); pr.category = move(f[5]);
+        catalog_add(inv, move(pr), line, st);
+    }
+    return true;
+}
+
+inline bool load_catalog_binary(const char* data, size_t size, Inventory& inv, CatalogLoadStats& st, string* err) {
+    auto fail = [&](const string& msg) { if (err) *err = msg; return false; };
+    if (size < sizeof(CatalogHeader)) return fail("file too small");
+    const CatalogHeader* h = (const CatalogHeader*)data;
+    if (h->version != CATALOG_VERSION) return fail("unsupported catalog version");
+    if (h->count > (size - sizeof(CatalogHeader)) / sizeof(CatalogRow)) return fail("catalog is truncated");
+    const CatalogRow* rows = (const CatalogRow*)(data + sizeof(CatalogHeader));
+    const char* blob = (const char*)(rows + h->count);
+    if (h->blobBytes > size - (size_t)(blob - data)) return fail("catalog is truncated");
+
+    inv.reserve(inv.size() + h->count);
+    for (uint64_t i = 0; i < h->count; ++i) {
+        const CatalogRow& r = rows[i];
+        uint64_t n = (uint64_t)r.len[0] + r.len[1] + r.len[2] + r.len[3];
+        if (r.strOff > h->blobBytes || n > h->blobBytes - r.strOff) return fail("row " + to_string(i + 1) + " points outside the file");
+        const char* s = blob + r.strOff;
+        Product pr;
+        pr.barcode.assign(s, r.len[0]); s += r.len[0];
+        pr.name.assign(s, r.len[1]); s += r.len[1];
+        pr.expiry.assign(s, r.len[2]); s += r.len[2];
+        pr.category.assign(s, r.len[3]);
+        pr.price = r.price;
+        pr.stock = r.stock;
+        catalog_add(inv, move(pr), (size_t)i + 1, st);
+    }
+    return true;
+}
+
+// Adds every product in path to inv (CSV or binary, by content).
+inline bool load_catalog(const string& path, Inventory& inv, CatalogLoadStats& st, string* err = nullptr) {
+    auto start = chrono::steady_clock::now();
+    MappedFile f;
+    if (!f.open(path)) { if (err) *err = "cannot open " + path + " (missing or empty)"; return false; }
+    bool ok = f.size() >= 4 && memcmp(f.data(), CATALOG_MAGIC, 4) == 0
+                  ? load_catalog_binary(f.data(), f.size(), inv, st, err)
+                  : load_catalog_csv(f.data(), f.size(), inv, st);
+    st.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+inline bool write_catalog_csv(const string& path, const vector<Product>& products) {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+    {
+        ChunkWriter w(out);
+        w.put("barcode,name,price,stock,expiry,category\n");
+        char num[32];
+        for (auto &p : products) {
+            w.put_csv(p.barcode); w.put(',');
+            w.put_csv(p.name); w.put(',');
+            snprintf(num, sizeof(num), "%.2f", p.price);
+            w.put(string_view(num)); w.put(',');
+            w.put_int(p.stock); w.put(',');
+            w.put_csv(p.expiry); w.put(',');
+            w.put_csv(p.category); w.put('\n');
+        }
+    }
+    return (bool)out;
+}
+
+inline bool write_catalog_binary(const string& path, const vector<Product>& products) {
+    vector<CatalogRow> rows(products.size());
+    string blob;
+    for (size_t i = 0; i < products.size(); ++i) {
+        const Product& p = products[i];
+        const string* parts[4] = {&p.barcode, &p.name, &p.expiry, &p.category};
+        CatalogRow& r = rows[i];
+        memset(&r, 0, sizeof(r));
+        r.strOff = blob.size();
+        r.price = p.price;
+        r.stock = p.stock;
+        for (int k = 0; k < 4; ++k) {
+            if (parts[k]->size() > UINT16_MAX) return false;
+            r.len[k] = (uint16_t)parts[k]->size();
+            blob += *parts[k];
+        }
+    }
+    CatalogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CATALOG_MAGIC, 4);
+    h.version = CATALOG_VERSION;
+    h.count = rows.size();
+    h.blobBytes = blob.size();
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)rows.data(), (streamsize)(rows.size() * sizeof(CatalogRow)));
+    out.write(blob.data(), (streamsize)blob.size());
+    return (bool)out;
+}
+
+// ".smc" writes the binary format, anything else CSV
+inline bool write_catalog(const string& path, const vector<Product>& products) {
+    bool binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".smc") == 0;
+    return binary ? write_catalog_binary(path, products) : write_catalog_csv(path, products);
+}
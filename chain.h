@@ -0,0 +1,266 @@
+// chain.h
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+#include "system.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+// Many stores in one process. Each store is a SupermarketSystem shard owned by
+// one worker thread: every call on it runs on that thread in the order it was
+// made, so a shard stays as single-threaded as a store on its own. Shards are
+// dealt round-robin to the workers, and on Linux each worker is pinned to a CPU.
+//
+// Every store starts from the same catalog: the built-in one, or one
+// SharedCatalog loaded once. A store copies a product in only when it first
+// moves its stock, so names, prices and categories are not held per store.
+//
+// Chain-wide queries go to every shard at once and merge what comes back. A
+// transfer takes stock off one shelf and then puts it on the other; if the
+// second step fails the first is undone. Transfers hold the chain lock
+// exclusively and queries hold it shared, so no query ever sees units that
+// have left one store and not yet reached the other.
+
+struct StoreInfo {
+    string id;
+    string region;
+};
+
+struct ChainReport {
+    vector<pair<string, long long>> topSellers;      // units, highest first
+    vector<pair<string, long long>> revenueByRegion; // piasters, highest first
+    vector<pair<string, long long>> revenueByStore;  // piasters, highest first
+    long long saleCount = 0;
+    long long revenue = 0;
+};
+
+// one thread running jobs in submission order
+class ShardWorker {
+private:
+    deque<function<void()>> jobs;
+    mutex m;
+    condition_variable cv;
+    bool stopping = false;
+    thread t; // last: starts once the rest is built
+
+    void loop() {
+        for (;;) {
+            function<void()> job;
+            {
+                unique_lock<mutex> g(m);
+                cv.wait(g, [&] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+public:
+    explicit ShardWorker(int cpu = -1) : t(&ShardWorker::loop, this) {
+#ifdef __linux__
+        if (cpu >= 0) { // best effort: stays unpinned if the CPU is not ours
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+        }
+#else
+        (void)cpu;
+#endif
+    }
+    ~ShardWorker() {
+        { lock_guard<mutex> g(m); stopping = true; }
+        cv.notify_one();
+        t.join();
+    }
+    ShardWorker(const ShardWorker&) = delete;
+    ShardWorker& operator=(const ShardWorker&) = delete;
+
+    template<typename F>
+    auto submit(F f) -> future<decltype(f())> {
+        auto task = make_shared<packaged_task<decltype(f())()>>(move(f));
+        auto done = task->get_future();
+        { lock_guard<mutex> g(m); jobs.push_back([task] { (*task)(); }); }
+        cv.notify_one();
+        return done;
+    }
+};
+
+// a catalog file loaded once for every store of a chain
+inline shared_ptr<const SharedCatalog> load_shared_catalog(const string& path, CatalogLoadStats& st, string* err = nullptr) {
+    Inventory loaded;
+    if (!load_catalog(path, loaded, st, err)) return nullptr;
+    return make_shared<const SharedCatalog>(loaded.all_products());
+}
+
+class StoreChain {
+private:
+    struct Shard {
+        StoreInfo info;
+        unique_ptr<SupermarketSystem> sys;
+        ShardWorker* worker;
+    };
+    shared_ptr<const SharedCatalog> catalog;
+    vector<Shard> shards;                     // outlive the workers, which drain first
+    vector<unique_ptr<ShardWorker>> workers;
+    unordered_map<string, size_t> byId;
+    shared_mutex chainLock; // transfers exclusive, chain-wide queries shared
+
+    // f(sys) on every shard at once; results in store order
+    template<typename F>
+    auto each_store(F f) -> vector<decltype(f(declval<SupermarketSystem&>()))> {
+        vector<future<decltype(f(declval<SupermarketSystem&>()))>> parts;
+        parts.reserve(shards.size());
+        for (size_t i = 0; i < shards.size(); ++i) parts.push_back(at(i, f));
+        vector<decltype(f(declval<SupermarketSystem&>()))> out;
+        out.reserve(parts.size());
+        for (auto &p : parts) out.push_back(p.get());
+        return out;
+    }
+
+public:
+    // shared = null: every store starts from the built-in catalog.
+    // threads = 0: one worker per core, never more than one per store.
+    explicit StoreChain(const vector<StoreInfo>& stores, shared_ptr<const SharedCatalog> shared = nullptr,
+                        unsigned threads = 0, int cashiersPerStore = 3) : catalog(move(shared)) {
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        if (threads == 0) threads = cores;
+        threads = (unsigned)max<size_t>(1, min<size_t>(threads, stores.size()));
+        for (unsigned i = 0; i < threads; ++i) workers.push_back(make_unique<ShardWorker>((int)(i % cores)));
+        for (size_t i = 0; i < stores.size(); ++i) {
+            Shard s{stores[i], make_unique<SupermarketSystem>(cashiersPerStore), workers[i % threads].get()};
+            if (catalog) s.sys->use_shared_catalog(catalog);
+            byId.emplace(stores[i].id, i);
+            shards.push_back(move(s));
+        }
+    }
+    StoreChain(const StoreChain&) = delete;
+    StoreChain& operator=(const StoreChain&) = delete;
+
+    size_t store_count() const { return shards.size(); }
+    size_t worker_count() const { return workers.size(); }
+    const StoreInfo& store(size_t i) const { return shards[i].info; }
+    // -1 if no store has that id
+    int find_store(const string& id) const {
+        auto it = byId.find(id);
+        return it == byId.end() ? -1 : (int)it->second;
+    }
+    const SharedCatalog* shared_catalog() const { return catalog.get(); }
+
+    // Runs f(sys) on store i's own thread. Everything a store does (sales,
+    // carts, its WAL) goes through here; the future carries f's result.
+    template<typename F>
+    auto at(size_t i, F f) -> future<decltype(f(declval<SupermarketSystem&>()))> {
+        SupermarketSystem* sys = shards[i].sys.get();
+        return shards[i].worker->submit([sys, f]() mutable { return f(*sys); });
+    }
+
+    // stock of barcode at each store, -1 where the store does not carry it
+    vector<int> stock_by_store(const string& barcode) {
+        shared_lock<shared_mutex> g(chainLock);
+        return each_store([barcode](SupermarketSystem& s) {
+            const Product* p = s.get_inventory().peek(barcode);
+            return p ? p->stock : -1;
+        });
+    }
+    long long total_stock(const string& barcode) {
+        long long total = 0;
+        for (int n : stock_by_store(barcode)) if (n > 0) total += n;
+        return total;
+    }
+
+    // every store's ledger tallied at once, then merged; top keeps that many sellers
+    ChainReport chain_report(size_t top = 10) {
+        struct Part { unordered_map<string, long long> units; long long sales = 0, revenue = 0; };
+        vector<Part> parts;
+        {
+            shared_lock<shared_mutex> g(chainLock);
+            parts = each_store([](SupermarketSystem& s) { // just what the merge needs, no catalog pass
+                Part p;
+                for (const SaleRecord* sale : s.sales_ledger()) {
+                    p.sales++;
+                    p.revenue += to_piasters(sale->total);
+                    for (auto &it : sale->items) p.units[it.first] += it.second;
+                }
+                return p;
+            });
+        }
+        ChainReport r;
+        unordered_map<string, long long> units, byRegion, byStore;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            const Part& p = parts[i];
+            for (auto &kv : p.units) units[kv.first] += kv.second;
+            byRegion[shards[i].info.region] += p.revenue;
+            byStore[shards[i].info.id] += p.revenue;
+            r.saleCount += p.sales;
+            r.revenue += p.revenue;
+        }
+        r.topSellers = ranked(units);
+        if (r.topSellers.size() > top) r.topSellers.resize(top);
+        r.revenueByRegion = ranked(byRegion);
+        r.revenueByStore = ranked(byStore);
+        return r;
+    }
+
+    // Moves qty units of barcode from one store's shelf to another's. A store
+    // that has never carried the product gets it, at zero stock, first.
+    TransferResult transfer_stock(const string& fromId, const string& toId, const string& barcode, int qty) {
+        TransferResult r;
+        int from = find_store(fromId), to = find_store(toId);
+        if (from < 0 || to < 0) { r.status = Status::StoreNotFound; return r; }
+        if (from == to) { r.status = Status::BadRequest; return r; }
+        if (qty <= 0) { r.status = Status::InvalidQuantity; return r; }
+        unique_lock<shared_mutex> g(chainLock);
+        // 1. off the sending shelf, keeping the product for a receiver without it
+        Product sent;
+        auto out = at((size_t)from, [&](SupermarketSystem& s) {
+            const Product* p = s.get_inventory().find(barcode);
+            if (p == nullptr) return Status::ProductNotFound;
+            sent = *p;
+            Status st = s.adjust_stock(barcode, -qty);
+            r.fromStock = p->stock;
+            return st;
+        }).get();
+        if (out != Status::Ok) { r.status = out; return r; }
+        // 2. onto the receiving shelf
+        auto in = at((size_t)to, [&](SupermarketSystem& s) {
+            if (s.get_inventory().peek(barcode) == nullptr) {
+                Product p = sent;
+                p.stock = 0;
+                Status st = s.add_product(p);
+                if (st != Status::Ok) return st;
+            }
+            Status st = s.adjust_stock(barcode, qty);
+            r.toStock = s.get_inventory().peek(barcode)->stock;
+            return st;
+        }).get();
+        if (in != Status::Ok) { // 3. or back where it came from
+            at((size_t)from, [&](SupermarketSystem& s) {
+                s.adjust_stock(barcode, qty);
+                r.fromStock = s.get_inventory().peek(barcode)->stock;
+            }).get();
+            r.status = in;
+        }
+        return r;
+    }
+
+    // products each store has copied out of the shared catalog
+    vector<size_t> shared_rows_copied() {
+        return each_store([](SupermarketSystem& s) { return s.get_inventory().shared_rows_copied(); });
+    }
+};
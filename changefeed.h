@@ -0,0 +1,157 @@
+// changefeed.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <string_view>
+#include "memory.h"
+using namespace std;
+
+// In-process change feed. The engine thread publishes one fixed-size event per
+// stock move, new product, committed sale and voided bill into a ring; any
+// number of subscribers read it from their own cursor, at their own pace, in
+// batches. Sequence numbers run 1, 2, 3, ... without gaps, so a consumer can
+// store its position and resume from it later.
+//
+// The producer never waits for readers. A reader more than a ring behind finds
+// its events overwritten: poll() then says it was lapped and skips to the
+// oldest event still held, and the reader should rescan (all_products, the
+// ledger) before it carries on.
+enum class ChangeType : uint8_t {
+    StockChanged = 1, // key barcode, delta units, stock after
+    ProductAdded,     // key barcode, stock, amount = price in piasters
+    SaleCommitted,    // key sale id, delta = units sold, amount = total in piasters
+    SaleVoided,       // key sale id, delta = units back on the shelf, amount = total in piasters
+    Resync            // key names why ("catalog", "recovery", "close_day"); rescan everything
+};
+
+// one cache line; keys longer than KEY_MAX keep their first KEY_MAX bytes
+struct ChangeEvent {
+    static constexpr size_t KEY_MAX = 38;
+    uint64_t seq;
+    int64_t amount;
+    int32_t delta;
+    int32_t stock;
+    ChangeType type;
+    uint8_t keyLen; // full key length (capped at 255)
+    char key[KEY_MAX];
+
+    string_view key_view() const { return string_view(key, min<size_t>(keyLen, KEY_MAX)); }
+    bool key_truncated() const { return keyLen > KEY_MAX; }
+};
+static_assert(sizeof(ChangeEvent) == 64, "ChangeEvent should fill one cache line");
+
+class ChangeFeed {
+private:
+    static const size_t WORDS = sizeof(ChangeEvent) / 8;
+
+    // word 0 is the event's seq once it is complete, 0 while it is written;
+    // readers check it before and after copying (a seqlock per slot)
+    struct alignas(64) Slot {
+        atomic<uint64_t> w[WORDS];
+    };
+
+    unique_ptr<Slot[]> ring;
+    size_t mask;
+    alignas(64) atomic<uint64_t> head{1}; // seq of the next event
+
+public:
+    // capacity is rounded up to a power of two
+    explicit ChangeFeed(size_t capacity = 1 << 16) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        ring.reset(new Slot[n]);
+        mask = n - 1;
+        for (size_t i = 0; i < n; ++i) for (auto &w : ring[i].w) w.store(0, memory_order_relaxed);
+    }
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+    // the ring is allocated up front: slots not yet written and the padding
+    // to a cache line are overhead
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("change feed");
+        m.elements = (size_t)min<uint64_t>(next_seq() - 1, capacity());
+        m.add(m.elements * sizeof(ChangeEvent), heap_block(capacity() * sizeof(Slot) + alignof(Slot)));
+        return m;
+    }
+    uint64_t next_seq() const { return head.load(memory_order_acquire); }
+    // oldest seq that cannot be overwritten while it is read
+    uint64_t oldest_seq() const {
+        uint64_t h = next_seq();
+        return h > capacity() ? h - capacity() + 1 : 1;
+    }
+
+    // single producer: only the thread that owns the engine may publish
+    uint64_t publish(ChangeType type, string_view key, int32_t delta, int32_t stock, int64_t amount) {
+        uint64_t seq = head.load(memory_order_relaxed);
+        ChangeEvent e;
+        memset(&e, 0, sizeof(e));
+        e.seq = seq; e.amount = amount; e.delta = delta; e.stock = stock; e.type = type;
+        e.keyLen = (uint8_t)min<size_t>(key.size(), 255);
+        memcpy(e.key, key.data(), min(key.size(), ChangeEvent::KEY_MAX));
+        uint64_t words[WORDS];
+        memcpy(words, &e, sizeof(e));
+
+        Slot& s = ring[seq & mask];
+        s.w[0].store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        for (size_t i = 1; i < WORDS; ++i) s.w[i].store(words[i], memory_order_relaxed);
+        s.w[0].store(seq, memory_order_release);
+        head.store(seq + 1, memory_order_release);
+        return seq;
+    }
+
+    // copies event seq (< next_seq()) into out; false if it has been overwritten
+    bool read(uint64_t seq, ChangeEvent& out) const {
+        const Slot& s = ring[seq & mask];
+        if (s.w[0].load(memory_order_acquire) != seq) return false;
+        uint64_t words[WORDS];
+        words[0] = seq;
+        for (size_t i = 1; i < WORDS; ++i) words[i] = s.w[i].load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (s.w[0].load(memory_order_relaxed) != seq) return false;
+        memcpy(&out, words, sizeof(out));
+        return true;
+    }
+};
+
+// One consumer's cursor. Any thread may own a subscriber; each is used by one.
+class FeedSubscriber {
+private:
+    const ChangeFeed* feed;
+    uint64_t cursor;
+    uint64_t lost = 0;
+
+public:
+    // from == 0 starts at the next event published; otherwise resume at from
+    explicit FeedSubscriber(const ChangeFeed& f, uint64_t from = 0) : feed(&f) {
+        uint64_t h = f.next_seq();
+        cursor = from == 0 || from > h ? h : from;
+    }
+
+    // Copies up to limit events into out, oldest first, and returns how many.
+    // lapped is set when events were lost before these (see the top of the file).
+    size_t poll(ChangeEvent* out, size_t limit, bool* lapped = nullptr) {
+        if (lapped) *lapped = false;
+        uint64_t h = feed->next_seq();
+        size_t n = 0;
+        while (n < limit && cursor < h) {
+            if (feed->read(cursor, out[n])) { ++n; ++cursor; continue; }
+            if (n > 0) break; // hand over what came before the gap; the next poll reports it
+            uint64_t oldest = max(feed->oldest_seq(), cursor + 1);
+            lost += oldest - cursor;
+            cursor = oldest;
+            if (lapped) *lapped = true;
+            h = feed->next_seq();
+        }
+        return n;
+    }
+
+    uint64_t position() const { return cursor; } // store this to resume later
+    uint64_t backlog() const { return feed->next_seq() - cursor; }
+    uint64_t lost_events() const { return lost; }
+};
@@ -1,71 +1,282 @@
 // customer.h
 #pragma once
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
 #include "cart.h"
 using namespace std;
 
-class SupermarketSystem; // forward
+// Every registered customer gets a dense number (CustomerNo 0, 1, 2, ...) and
+// one fixed-size row: the kind as a tag, where its id and name sit in a shared
+// text buffer, and its entry in the side table for that kind (an online
+// customer's address, payment and priority; a special customer's discount).
+// Ids are found through an open-addressing table of numbers.
+//
+// A visit (session) holds a cart from the pool, taken when the visit begins
+// and handed back, arena and all, when it ends at checkout or abandonment, so
+// millions of loyalty customers cost a row each, not a cart each. Every ended
+// visit bumps the row's visit number. Queues and online orders hold a VisitRef,
+// which goes stale once that visit is over, even if the row has been removed
+// and given to someone else.
+enum class CustomerKind : uint8_t { WalkIn, Special, Online };
 
-class Customer {
-protected:
-    string id;
-    string name;
-public:
-    ShoppingCart cart;
-    Customer() = default;
-    Customer(string i, string n){
-        id = move(i);
-        name = move(n);
-    }
-    virtual ~Customer() = default;
-
-    virtual string get_type() const {
-         return "WalkIn"; 
+inline const char* kind_name(CustomerKind k) {
+    switch (k) {
+        case CustomerKind::Special: return "Special";
+        case CustomerKind::Online: return "Online";
+        default: return "WalkIn";
     }
-    string get_id() const {
-         return id; 
-        }
-    string get_name() const { return name; }
+}
 
-    virtual void checkout(SupermarketSystem& sys, int cashierIndex);
+typedef uint32_t CustomerNo;
+const CustomerNo NO_CUSTOMER = UINT32_MAX;
 
-    virtual void print_info() const;
+struct VisitRef {
+    CustomerNo customer = NO_CUSTOMER;
+    uint32_t visit = 0;
 };
 
-class OnlineCustomer : public Customer {
-private:
+struct OnlineProfile {
     string address;
     string paymentMethod;
-    int priority = 5;
-public:
-    OnlineCustomer() = default;
-    OnlineCustomer(string i, string n, string addr, string pay, int pr = 5) {
-        id=move(i);
-        name=move(n);
-        address=move(addr);
-        paymentMethod=move(pay);
-        priority = pr;
-    }
-
-    string get_type() const override { return "Online"; }
-    int get_priority() const { return priority; }
-    void set_priority(int p) { priority = p; }
-    void print_info() const override;
-    void checkout(SupermarketSystem& sys, int cashierIndex) override;
+    int priority = 5; // lower = served first
 };
 
-//add new class for spicialcruchturs customers if needed 
-class SpecialCustomer : public Customer {
+class CustomerRegistry {
 private:
-    double discountRate = 0.10; // 10% discount        
+    static const uint32_t NONE = UINT32_MAX;
+    struct Row {
+        uint64_t text;   // id, then name, in texts
+        uint32_t idLen;
+        uint32_t nameLen;
+        uint32_t side;   // index in online or specialRate, by kind
+        uint32_t cart;   // index in carts, NONE while no visit is open
+        uint32_t visit;  // ended visits so far; survives removal of the row
+        CustomerKind kind;
+        bool live;
+    };
+    vector<Row> rows;
+    vector<uint32_t> freeRows;
+    vector<char> texts;
+    size_t deadText = 0; // bytes of removed customers still in texts
+    // power of two, at most half full; each slot keeps the top bits of the id's
+    // hash next to the number, so a probe rarely has to look at a row
+    struct Slot { CustomerNo n; uint32_t tag; };
+    vector<Slot> slots;
+    vector<OnlineProfile> online;
+    vector<double> specialRate;
+    vector<uint32_t> freeOnline, freeSpecial;
+    vector<unique_ptr<ShoppingCart>> carts;
+    vector<uint32_t> freeCarts;
+
+    // id's slot, or the empty slot where it would go
+    size_t slot_of(string_view key, uint32_t& tag) const {
+        size_t h = hash<string_view>()(key);
+        size_t mask = slots.size() - 1;
+        tag = (uint32_t)(h >> (sizeof(size_t) * 4));
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            const Slot& s = slots[i];
+            if (s.n == NO_CUSTOMER || (s.tag == tag && id(s.n) == key)) return i;
+        }
+    }
+    uint32_t take_side(vector<uint32_t>& freeList, size_t& next) {
+        if (freeList.empty()) return (uint32_t)next++;
+        uint32_t i = freeList.back();
+        freeList.pop_back();
+        return i;
+    }
+    // live rows' text copied to the front, once removals have left half of it dead
+    void compact_text() {
+        vector<char> t;
+        t.reserve(texts.size() - deadText);
+        for (Row& r : rows) {
+            if (!r.live) continue;
+            uint64_t at = t.size();
+            t.insert(t.end(), texts.begin() + (ptrdiff_t)r.text, texts.begin() + (ptrdiff_t)(r.text + r.idLen + r.nameLen));
+            r.text = at;
+        }
+        texts.swap(t);
+        deadText = 0;
+    }
+    void rehash(size_t size) {
+        slots.assign(size, Slot{NO_CUSTOMER, 0});
+        uint32_t tag;
+        for (CustomerNo n = 0; n < rows.size(); ++n) {
+            if (!rows[n].live) continue;
+            size_t i = slot_of(id(n), tag);
+            slots[i] = Slot{n, tag};
+        }
+    }
+
 public:
-    SpecialCustomer(string i, string n) {
-        id=move(i);
-        name=move(n);
+    CustomerRegistry() : slots(16, Slot{NO_CUSTOMER, 0}) {}
+
+    void reserve(size_t n) {
+        rows.reserve(n);
+        texts.reserve(n * 16);
+        size_t size = slots.size();
+        while (size < 2 * n) size <<= 1;
+        if (size != slots.size()) rehash(size);
     }
 
-    string get_type() const override { return "Special"; }
-    double get_discount_rate() const { return discountRate; } 
-    void print_info() const override ;
-    void checkout(SupermarketSystem& sys, int cashierIndex) override ;
+    // NO_CUSTOMER if the id is taken
+    CustomerNo add(CustomerKind kind, string_view customerId, string_view customerName) {
+        if (2 * (size() + 1) > slots.size()) rehash(2 * slots.size());
+        uint32_t tag;
+        size_t i = slot_of(customerId, tag);
+        if (slots[i].n != NO_CUSTOMER) return NO_CUSTOMER;
+        CustomerNo n = (CustomerNo)rows.size();
+        if (freeRows.empty()) rows.push_back(Row{0, 0, 0, NONE, NONE, 0, kind, true});
+        else { n = freeRows.back(); freeRows.pop_back(); }
+        Row& r = rows[n];
+        r.text = texts.size();
+        r.idLen = (uint32_t)customerId.size();
+        r.nameLen = (uint32_t)customerName.size();
+        r.cart = NONE;
+        r.kind = kind;
+        r.live = true;
+        r.side = NONE;
+        if (kind == CustomerKind::Online) {
+            size_t next = online.size();
+            r.side = take_side(freeOnline, next);
+            if (r.side == online.size()) online.emplace_back(); else online[r.side] = OnlineProfile();
+        }
+        if (kind == CustomerKind::Special) {
+            size_t next = specialRate.size();
+            r.side = take_side(freeSpecial, next);
+            if (r.side == specialRate.size()) specialRate.push_back(0.10); else specialRate[r.side] = 0.10;
+        }
+        texts.insert(texts.end(), customerId.begin(), customerId.end());
+        texts.insert(texts.end(), customerName.begin(), customerName.end());
+        slots[i] = Slot{n, tag};
+        return n;
+    }
+
+    // Forgets n: ends its visit, frees the row and its side-table entry for
+    // reuse. Later slots of the probe run move back into the gap, so lookups
+    // never need tombstones.
+    void remove(CustomerNo n) {
+        if (n >= rows.size() || !rows[n].live) return;
+        end_visit(n);
+        uint32_t tag;
+        size_t hole = slot_of(id(n), tag);
+        size_t mask = slots.size() - 1;
+        for (size_t j = (hole + 1) & mask; slots[j].n != NO_CUSTOMER; j = (j + 1) & mask) {
+            size_t home = hash<string_view>()(id(slots[j].n)) & mask;
+            // j may move into the hole only if its home is not in (hole, j]
+            if (((j - home) & mask) >= ((j - hole) & mask)) { slots[hole] = slots[j]; hole = j; }
+        }
+        slots[hole] = Slot{NO_CUSTOMER, 0};
+        Row& r = rows[n];
+        if (r.kind == CustomerKind::Online) { online[r.side] = OnlineProfile(); freeOnline.push_back(r.side); }
+        if (r.kind == CustomerKind::Special) freeSpecial.push_back(r.side);
+        r.live = false;
+        deadText += r.idLen + r.nameLen;
+        freeRows.push_back(n);
+        if (deadText > 4096 && 2 * deadText > texts.size()) compact_text();
+    }
+
+    CustomerNo find(string_view customerId) const { uint32_t tag; return slots[slot_of(customerId, tag)].n; }
+    size_t size() const { return rows.size() - freeRows.size(); }
+    // numbers run below end(); removed ones are not live
+    CustomerNo end() const { return (CustomerNo)rows.size(); }
+    bool live(CustomerNo n) const { return n < rows.size() && rows[n].live; }
+
+    // views into the shared text; valid until the next add or remove
+    string_view id(CustomerNo n) const { return string_view(texts.data() + rows[n].text, rows[n].idLen); }
+    string_view name(CustomerNo n) const { return string_view(texts.data() + rows[n].text + rows[n].idLen, rows[n].nameLen); }
+    CustomerKind kind(CustomerNo n) const { return rows[n].kind; }
+
+    // online customers only
+    OnlineProfile& online_profile(CustomerNo n) { return online[rows[n].side]; }
+    const OnlineProfile& online_profile(CustomerNo n) const { return online[rows[n].side]; }
+    // special-needs discount; 0 for everyone else
+    double discount_rate(CustomerNo n) const {
+        return rows[n].kind == CustomerKind::Special ? specialRate[rows[n].side] : 0.0;
+    }
+
+    // ---- visits ----
+    VisitRef visit(CustomerNo n) const { return VisitRef{n, rows[n].visit}; }
+    // still the visit it was taken in: not checked out, abandoned or removed
+    bool is_current(VisitRef v) const { return live(v.customer) && rows[v.customer].visit == v.visit; }
+    bool in_visit(CustomerNo n) const { return rows[n].cart != NONE; }
+    // the visit is over: the cart goes back to the pool, emptied in O(1), and
+    // every VisitRef to it goes stale
+    void end_visit(CustomerNo n) {
+        release_cart(n);
+        rows[n].visit++;
+    }
+
+    // n's cart, opening a visit if none is open
+    ShoppingCart& cart(CustomerNo n) {
+        Row& r = rows[n];
+        if (r.cart == NONE) {
+            if (freeCarts.empty()) {
+                r.cart = (uint32_t)carts.size();
+                carts.push_back(make_unique<ShoppingCart>());
+            } else {
+                r.cart = freeCarts.back();
+                freeCarts.pop_back();
+            }
+        }
+        return *carts[r.cart];
+    }
+    // nullptr while n has no cart
+    const ShoppingCart* find_cart(CustomerNo n) const { return rows[n].cart == NONE ? nullptr : carts[rows[n].cart].get(); }
+    bool cart_empty(CustomerNo n) const { const ShoppingCart* c = find_cart(n); return c == nullptr || c->empty(); }
+    size_t cart_lines(CustomerNo n) const { const ShoppingCart* c = find_cart(n); return c ? c->line_count() : 0; }
+
+    // empties n's cart and returns it to the pool
+    void release_cart(CustomerNo n) {
+        Row& r = rows[n];
+        if (r.cart == NONE) return;
+        carts[r.cart]->reset();
+        freeCarts.push_back(r.cart);
+        r.cart = NONE;
+    }
+    size_t active_carts() const { return carts.size() - freeCarts.size(); }
+    size_t pooled_carts() const { return freeCarts.size(); }
+
+    // rows, text, index and profiles; removed customers' rows and text are overhead
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("customers");
+        m.elements = size();
+        m.add(size() * sizeof(Row), heap_block(rows.capacity() * sizeof(Row)));
+        m.add(texts.size() - deadText, heap_block(texts.capacity()));
+        m.add(size() * sizeof(Slot), heap_block(slots.capacity() * sizeof(Slot)));
+        m.add((online.size() - freeOnline.size()) * sizeof(OnlineProfile), heap_block(online.capacity() * sizeof(OnlineProfile)));
+        m.add((specialRate.size() - freeSpecial.size()) * sizeof(double), heap_block(specialRate.capacity() * sizeof(double)));
+        for (auto v : {&freeRows, &freeOnline, &freeSpecial}) m.add(0, heap_block(v->capacity() * sizeof(uint32_t)));
+        for (auto &p : online) { account_string(m, p.address); account_string(m, p.paymentMethod); }
+        return m;
+    }
+    // Carts and their arenas; pooled carts and spare arena space are overhead,
+    // and so are the blocks this thread keeps for the next visits.
+    MemoryUsage carts_memory_usage() const {
+        MemoryUsage m("carts");
+        m.elements = active_carts();
+        m.add(active_carts() * sizeof(unique_ptr<ShoppingCart>), heap_block(carts.capacity() * sizeof(unique_ptr<ShoppingCart>)));
+        m.add(0, heap_block(freeCarts.capacity() * sizeof(uint32_t)));
+        account_nodes(m, active_carts(), sizeof(ShoppingCart), sizeof(ShoppingCart));
+        account_nodes(m, pooled_carts(), 0, sizeof(ShoppingCart));
+        for (auto &c : carts) m.add(c->arena_bytes(), c->arena_reserved());
+        m.add(0, SessionArena::pooled_blocks() * SessionArena::block_bytes());
+        return m;
+    }
+
+    // heap held by the registry (cart contents not included)
+    size_t memory_bytes() const {
+        size_t b = rows.capacity() * sizeof(Row) + texts.capacity() + slots.capacity() * sizeof(Slot)
+                 + online.capacity() * sizeof(OnlineProfile) + specialRate.capacity() * sizeof(double)
+                 + carts.capacity() * sizeof(unique_ptr<ShoppingCart>) + carts.size() * sizeof(ShoppingCart)
+                 + (freeCarts.capacity() + freeRows.capacity() + freeOnline.capacity() + freeSpecial.capacity()) * sizeof(uint32_t);
+        for (auto &p : online) {
+            if (p.address.capacity() > 15) b += p.address.capacity() + 1;
+            if (p.paymentMethod.capacity() > 15) b += p.paymentMethod.capacity() + 1;
+        }
+        return b;
+    }
 };
\ No newline at end of file
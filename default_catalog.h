@@ -0,0 +1,205 @@
+// default_catalog.h
+#pragma once
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+// The built-in catalog as compile-time data: nothing here is constructed at
+// startup. Inventory copies a row into its hash map the first time it is
+// touched (see Inventory::use_default_catalog). catalog.csv holds the same rows.
+struct CatalogEntry {
+    string_view barcode;
+    string_view name;
+    double price;
+    int stock;
+    string_view expiry;
+    uint8_t category; // index into DEFAULT_CATEGORIES
+};
+constexpr string_view DEFAULT_CATEGORIES[] = {
+    "Dairy",
+    "Meat",
+    "School",
+    "Produce",
+    "Cleaning",
+    "Beverages",
+    "Snacks",
+    "Self Care",
+    "Household",
+    "Food Staples",
+    "Toys",
+    "Electronics",
+    "Sports",
+    "Bakery",
+    "Eggs",
+    "Grains",
+    "Breakfast",
+    "Condiments",
+};
+
+constexpr CatalogEntry DEFAULT_CATALOG[] = {
+    {"0001", "Milk 1L", 45.0, 50, "2025-12-01", 0},
+    {"0008", "Cheese 200g", 125.0, 35, "2026-02-01", 0},
+    {"0012", "Butter 250g", 170.5, 30, "2026-04-01", 0},
+    {"0009", "Yogurt 150g", 45.5, 80, "2026-03-01", 0},
+    {"0014", "Cream 200ml", 70.99, 40, "2026-05-01", 0},
+    {"0028", "Ice Cream 500ml", 172.5, 25, "2026-06-01", 0},
+    {"0006", "Chicken Breast 1kg", 185.0, 25, "2025-12-15", 1},
+    {"0015", "Ground Beef 500g", 250.0, 20, "2025-12-10", 1},
+    {"0016", "tuna 1kg", 285.0, 15, "2025-12-20", 1},
+    {"0024", "Salmon Fillet 500g", 490.0, 10, "2025-12-18", 1},
+    {"0025", "Turkey Slices 300g", 380.0, 18, "2025-12-22", 1},
+    {"0026", "Sausages 500g", 230.0, 22, "2025-12-25", 1},
+    {"0027", "Lamb Chops 500g", 280.0, 8, "2025-12-30", 1},
+    {"0017", "Notebook A4 120pg", 60.9, 100, "2027-12-31", 2},
+    {"0018", "Pen Blue Ink", 10.0, 200, "2027-12-31", 2},
+    {"0019", "Eraser", 5.0, 150, "2027-12-31", 2},
+    {"0020", "Ruler 30cm", 25.0, 80, "2027-12-31", 2},
+    {"0021", "Backpack", 250.0, 40, "2027-12-31", 2},
+    {"0022", "Calculator", 1500.0, 60, "2027-12-31", 2},
+    {"0023", "Highlighter Set", 30.5, 70, "2027-12-31", 2},
+    {"0004", "Apple 1kg", 85.0, 20, "2025-11-30", 3},
+    {"0103", "Lettuce", 15.0, 50, "2025-11-28", 3},
+    {"0104", "Carrots 1kg", 15.0, 60, "2025-12-05", 3},
+    {"0105", "Potatoes 2kg", 25.0, 70, "2025-12-10", 3},
+    {"0029", "Grapes 500g", 28.0, 40, "2025-11-29", 3},
+    {"0030", "Strawberries 250g", 32.0, 30, "2025-11-27", 3},
+    {"0031", "Cucumbers", 12.0, 55, "2025-12-03", 3},
+    {"0032", "Bell Peppers 1kg", 40.0, 45, "2025-12-07", 3},
+    {"0033", "Dish Soap 500ml", 85.5, 80, "2027-12-31", 4},
+    {"0034", "Laundry Detergent 1L", 50.0, 60, "2027-12-31", 4},
+    {"0035", "All-Purpose Cleaner 750ml", 35.0, 70, "2027-12-31", 4},
+    {"0036", "Sponges 5pc", 18.0, 90, "2027-12-31", 4},
+    {"0037", "Paper Towels 2rolls", 22.0, 50, "2027-12-31", 4},
+    {"0038", "Trash Bags 30pc", 40.0, 40, "2027-12-31", 4},
+    {"0039", "Coffee 250g", 250.0, 30, "2026-12-31", 5},
+    {"0040", "Tea Bags 100pc", 30.0, 50, "2026-12-31", 5},
+    {"0041", "Soda 330ml", 15.0, 70, "2025-12-31", 5},
+    {"0042", "Bottled Water 500ml", 8.0, 100, "2025-12-31", 5},
+    {"0043", "Energy Drink 250ml", 20.0, 40, "2025-12-31", 5},
+    {"0044", "Chips 200g", 25.0, 60, "2026-06-30", 6},
+    {"0045", "Chocolate Bar 100g", 30.0, 80, "2026-05-31", 6},
+    {"0046", "Cookies 150g", 20.0, 70, "2026-07-15", 6},
+    {"0047", "Nuts chocolate Mix 250g", 40.0, 50, "2026-08-31", 6},
+    {"0048", "Granola Bars 6pc", 50.0, 90, "2026-09-30", 6},
+    {"0049", "Popcorn 100g", 15.0, 100, "2026-04-30", 6},
+    {"0050", "Dried Fruit 200g", 75.0, 40, "2026-10-31", 6},
+    {"0051", "Pretzels 150g", 18.0, 75, "2026-11-30", 6},
+    {"0052", "Shampoo 500ml", 200.5, 60, "2027-12-31", 7},
+    {"0053", "Conditioner 400ml", 120.0, 55, "2027-12-31", 7},
+    {"0054", "Body Wash 500ml", 80.0, 70, "2027-12-31", 7},
+    {"0055", "Toothpaste 150g", 45.0, 80, "2027-12-31", 7},
+    {"0056", "Deodorant 200ml", 80.0, 50, "2027-12-31", 7},
+    {"0057", "Toilet Paper 12rolls", 50.0, 40, "2027-12-31", 8},
+    {"0058", "Facial Tissues 4packs", 30.0, 70, "2027-12-31", 8},
+    {"0059", "Hand Soap 300ml", 30.0, 90, "2027-12-31", 8},
+    {"0060", "Air Freshener 250ml", 40.0, 50, "2027-12-31", 8},
+    {"0061", "Light Bulbs 2pc", 35.0, 60, "2027-12-31", 8},
+    {"0062", "Batteries AA 4pc", 40.0, 80, "2027-12-31", 8},
+    {"0063", "Extension Cord 3m", 7.0, 30, "2027-12-31", 8},
+    {"0064", "Pasta 500g", 40.5, 70, "2027-12-31", 9},
+    {"0065", "Canned Beans 400g", 26.0, 80, "2027-12-31", 9},
+    {"0066", "Canned Tuna 200g", 50.0, 60, "2027-12-31", 9},
+    {"0067", "Olive Oil 1L", 80.0, 40, "2027-12-31", 9},
+    {"0068", "Flour 1kg", 25.0, 50, "2027-12-31", 9},
+    {"0069", "Sugar 1kg", 20.0, 60, "2027-12-31", 9},
+    {"0070", "Salt 500g", 10.0, 90, "2027-12-31", 9},
+    {"0071", "Baking Powder 200g", 18.0, 70, "2027-12-31", 9},
+    {"0072", "Yeast 100g", 15.0, 80, "2027-12-31", 9},
+    {"0073", "Action Figure", 400.0, 30, "2028-12-31", 10},
+    {"0074", "Doll", 380.0, 25, "2028-12-31", 10},
+    {"0075", "Puzzle 500pc", 250.0, 40, "2028-12-31", 10},
+    {"0076", "Board Game", 150.0, 20, "2028-12-31", 10},
+    {"0077", "Remote Control Car", 250.0, 15, "2028-12-31", 10},
+    {"0101", "LEGO Building Blocks Set", 300.0, 18, "2028-12-31", 10},
+    {"0102", "Stuffed Animal", 120.0, 50, "2028-12-31", 10},
+    {"0078", "Headphones", 600.0, 20, "2028-12-31", 11},
+    {"0079", "Portable Charger 65W", 400.0, 25, "2028-12-31", 11},
+    {"0080", "USB Flash Drive 128GB", 600.0, 30, "2028-12-31", 11},
+    {"0081", "Wireless Mouse", 380.0, 40, "2028-12-31", 11},
+    {"0082", "Keyboard", 180.0, 35, "2028-12-31", 11},
+    {"0083", "Webcam", 400.0, 15, "2028-12-31", 11},
+    {"0084", "Bluetooth Speaker", 350.0, 20, "2028-12-31", 11},
+    {"0085", "Smartwatch", 1500.0, 10, "2028-12-31", 11},
+    {"0086", "Fitness Tracker", 500.0, 15, "2028-12-31", 11},
+    {"0087", "E-reader", 380.0, 8, "2028-12-31", 11},
+    {"0088", "Tablet", 8700.0, 12, "2028-12-31", 11},
+    {"0089", "Iphone 13 pro max", 39900.0, 20, "2028-12-31", 11},
+    {"0090", "Laptop", 69999.0, 10, "2028-12-31", 11},
+    {"0091", "Football", 380.0, 25, "2027-12-31", 12},
+    {"0092", "Basketball", 220.0, 30, "2027-12-31", 12},
+    {"0093", "Tennis Racket", 500.0, 15, "2027-12-31", 12},
+    {"0094", "Yoga Mat", 180.0, 40, "2027-12-31", 12},
+    {"0095", "Dumbbell Set", 720.0, 10, "2027-12-31", 12},
+    {"0096", "Jump Rope", 80.0, 50, "2027-12-31", 12},
+    {"0097", "Cycling Helmet", 450.0, 20, "2027-12-31", 12},
+    {"0098", "Bagels 6pc", 30.0, 40, "2025-10-05", 13},
+    {"0099", "Muffins", 40.0, 35, "2025-10-03", 13},
+    {"0100", "Croissants 3pc", 35.0, 30, "2025-10-04", 13},
+    {"0002", "Bread", 2.0, 100, "2025-10-01", 13},
+    {"0003", "Eggs 12pc", 8.5, 30, "2026-01-01", 14},
+    {"0005", "Rice 1kg", 40.0, 40, "2027-01-01", 15},
+    {"0007", "Orange Juice 1L", 60.0, 60, "2025-12-20", 5},
+    {"0010", "Banana 1kg", 45.0, 45, "2025-11-25", 3},
+    {"0011", "Cereal 500g", 65.5, 55, "2026-06-01", 16},
+    {"0013", "Tomato Sauce 500g", 16.0, 70, "2027-05-01", 17},
+};
+
+constexpr size_t DEFAULT_CATALOG_SIZE = sizeof(DEFAULT_CATALOG) / sizeof(DEFAULT_CATALOG[0]);
+constexpr size_t DEFAULT_INDEX_SLOTS = 256; // power of two, at least twice the rows
+
+constexpr uint64_t barcode_hash(string_view s) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (char c : s) { h ^= (uint8_t)c; h *= 1099511628211ull; }
+    return h;
+}
+
+// Everything the engine would otherwise compute at startup: barcode hashes in
+// an open-addressing table (slot holds row + 1, 0 = empty) and the rows in
+// price and category order, ties kept in catalog order like the BSTs do.
+struct DefaultCatalogIndex {
+    uint16_t slot[DEFAULT_INDEX_SLOTS];
+    uint16_t byPrice[DEFAULT_CATALOG_SIZE];
+    uint16_t byCategory[DEFAULT_CATALOG_SIZE];
+    bool uniqueBarcodes;
+};
+
+constexpr DefaultCatalogIndex make_default_catalog_index() {
+    DefaultCatalogIndex x{};
+    x.uniqueBarcodes = true;
+    for (size_t i = 0; i < DEFAULT_CATALOG_SIZE; ++i) {
+        size_t s = barcode_hash(DEFAULT_CATALOG[i].barcode) & (DEFAULT_INDEX_SLOTS - 1);
+        while (x.slot[s] != 0) {
+            if (DEFAULT_CATALOG[x.slot[s] - 1].barcode == DEFAULT_CATALOG[i].barcode) x.uniqueBarcodes = false;
+            s = (s + 1) & (DEFAULT_INDEX_SLOTS - 1);
+        }
+        x.slot[s] = (uint16_t)(i + 1);
+    }
+    // insertion sorts: stable, and constexpr in C++17 unlike std::sort
+    for (size_t i = 0; i < DEFAULT_CATALOG_SIZE; ++i) {
+        size_t j = i;
+        while (j > 0 && DEFAULT_CATALOG[i].price < DEFAULT_CATALOG[x.byPrice[j - 1]].price) { x.byPrice[j] = x.byPrice[j - 1]; --j; }
+        x.byPrice[j] = (uint16_t)i;
+        j = i;
+        while (j > 0 && DEFAULT_CATEGORIES[DEFAULT_CATALOG[i].category] < DEFAULT_CATEGORIES[DEFAULT_CATALOG[x.byCategory[j - 1]].category]) {
+            x.byCategory[j] = x.byCategory[j - 1]; --j;
+        }
+        x.byCategory[j] = (uint16_t)i;
+    }
+    return x;
+}
+
+constexpr DefaultCatalogIndex DEFAULT_CATALOG_INDEX = make_default_catalog_index();
+static_assert(DEFAULT_CATALOG_INDEX.uniqueBarcodes, "duplicate barcode in DEFAULT_CATALOG");
+static_assert(DEFAULT_CATALOG_SIZE * 2 <= DEFAULT_INDEX_SLOTS, "grow DEFAULT_INDEX_SLOTS");
+
+// row of barcode in DEFAULT_CATALOG, or -1
+constexpr int default_catalog_find(string_view barcode) {
+    size_t s = barcode_hash(barcode) & (DEFAULT_INDEX_SLOTS - 1);
+    while (DEFAULT_CATALOG_INDEX.slot[s] != 0) {
+        int row = DEFAULT_CATALOG_INDEX.slot[s] - 1;
+        if (DEFAULT_CATALOG[row].barcode == barcode) return row;
+        s = (s + 1) & (DEFAULT_INDEX_SLOTS - 1);
+    }
+    return -1;
+}
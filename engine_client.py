@@ -0,0 +1,272 @@
+# engine_client.py - Python client for the engine server (server.h)
+#   main.exe --serve supermarket.sock      (or --serve 127.0.0.1:7070 on Windows)
+#   python -c "import engine_client; print(engine_client.EngineClient().coupons())"
+#
+# Frames are u32 len | u32 request id | u8 op or status | payload, little-endian;
+# payload fields follow the comments on ServerOp in server.h.
+import os
+import socket
+import struct
+from types import SimpleNamespace
+
+(OP_PING, OP_GET_PRODUCT, OP_LIST_PRODUCTS, OP_ADD_PRODUCT, OP_ADD_CUSTOMER, OP_LIST_CUSTOMERS,
+ OP_CART_ADD, OP_CART_REMOVE, OP_CART_UNDO, OP_CART_VIEW, OP_ENQUEUE, OP_PLACE_ONLINE, OP_CHECKOUT,
+ OP_UNDO_BILL, OP_QUEUE_STATUS, OP_SALES_LEDGER, OP_SALES_REPORT, OP_COUPONS, OP_SHUTDOWN,
+ OP_CHANGES, OP_BEGIN_SESSION, OP_END_SESSION) = range(1, 23)
+
+ORDER_CATALOG, ORDER_PRICE, ORDER_CATEGORY = 0, 1, 2
+KIND_WALKIN, KIND_SPECIAL, KIND_ONLINE = 0, 1, 2
+LANE_SPECIAL, LANE_ONLINE = -1, -2
+# change feed event types (ChangeType in changefeed.h)
+CHANGE_STOCK, CHANGE_PRODUCT, CHANGE_SALE, CHANGE_VOID, CHANGE_RESYNC = range(1, 6)
+
+# same order as Status in results.h
+STATUS_MESSAGES = [
+    'OK', 'Customer not found', 'Customer exists', 'Not an online customer', 'Product not found',
+    'Product already exists', 'Invalid product', 'Quantity must be positive.', 'Not enough stock',
+    'No such item in cart', 'No actions to undo', 'Invalid cashier', 'No customers in queue',
+    'Customer has empty cart', 'Invalid coupon code.', 'A coupon has already been applied.',
+    'Malformed or unknown request', 'Store not found',
+    'Write-ahead log failed; sales are not being saved',
+]
+STATUS_OUT_OF_STOCK = 8
+
+
+def default_address():
+    return os.environ.get('SUPERMARKET_ADDRESS') or ('127.0.0.1:7070' if os.name == 'nt' else 'supermarket.sock')
+
+
+def status_message(status):
+    return STATUS_MESSAGES[status] if 0 <= status < len(STATUS_MESSAGES) else f'Unknown status {status}'
+
+
+class Writer:
+    def __init__(self):
+        self.b = bytearray()
+
+    def u8(self, v): self.b += struct.pack('<B', v); return self
+    def u32(self, v): self.b += struct.pack('<I', v); return self
+    def u64(self, v): self.b += struct.pack('<Q', v); return self
+    def i32(self, v): self.b += struct.pack('<i', v); return self
+    def f64(self, v): self.b += struct.pack('<d', v); return self
+
+    def str(self, s):
+        data = s.encode('utf-8')
+        self.b += struct.pack('<I', len(data)) + data
+        return self
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def _take(self, fmt):
+        v = struct.unpack_from(fmt, self.data, self.pos)[0]
+        self.pos += struct.calcsize(fmt)
+        return v
+
+    def u8(self): return self._take('<B')
+    def i32(self): return self._take('<i')
+    def u32(self): return self._take('<I')
+    def u64(self): return self._take('<Q')
+    def f64(self): return self._take('<d')
+
+    def str(self):
+        n = self.u32()
+        s = bytes(self.data[self.pos:self.pos + n]).decode('utf-8', 'replace')
+        self.pos += n
+        return s
+
+    def product(self):
+        return SimpleNamespace(barcode=self.str(), name=self.str(), price=self.f64(), stock=self.i32(),
+                               expiry=self.str(), category=self.str())
+
+    def lines(self):
+        return [SimpleNamespace(barcode=self.str(), name=self.str(), category=self.str(), unit_price=self.f64(),
+                                qty=self.i32()) for _ in range(self.u32())]
+
+    def sale(self):
+        return SimpleNamespace(sale_id=self.str(), customer_id=self.str(), cashier_id=self.str(),
+                               online=self.u8() != 0, total=self.f64(), time=self.str(),
+                               items=[(self.str(), self.i32()) for _ in range(self.u32())])
+
+    def ranking(self):
+        return [(self.str(), self.u64()) for _ in range(self.u32())]
+
+
+def reply(status, **fields):
+    return SimpleNamespace(status=status, ok=status == 0, message=status_message(status), **fields)
+
+
+class EngineClient:
+    def __init__(self, address=None, timeout=5.0):
+        self.address = address or default_address()
+        host, _, port = self.address.rpartition(':')
+        if port.isdigit():
+            self.sock = socket.create_connection((host or '127.0.0.1', int(port)), timeout=timeout)
+            self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        else:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.settimeout(timeout)
+            self.sock.connect(self.address)
+        self.next_id = 1
+
+    def close(self):
+        self.sock.close()
+
+    def _recv_exact(self, n):
+        buf = bytearray()
+        while len(buf) < n:
+            chunk = self.sock.recv(n - len(buf))
+            if not chunk:
+                raise ConnectionError('engine server closed the connection')
+            buf += chunk
+        return buf
+
+    def call_many(self, requests):
+        """Pipelines [(op, payload bytes)]: one send, then the replies in order as (status, Reader)."""
+        out = bytearray()
+        ids = []
+        for op, payload in requests:
+            ids.append(self.next_id)
+            out += struct.pack('<IIB', len(payload) + 5, self.next_id, op) + payload
+            self.next_id = (self.next_id + 1) & 0xFFFFFFFF
+        self.sock.sendall(out)
+        replies = []
+        for rid in ids:
+            length, got, status = struct.unpack('<IIB', self._recv_exact(9))
+            body = self._recv_exact(length - 5)
+            if got != rid:
+                raise ConnectionError(f'reply {got} arrived for request {rid}')
+            replies.append((status, Reader(body)))
+        return replies
+
+    def call(self, op, payload=b''):
+        return self.call_many([(op, bytes(payload))])[0]
+
+    def _pages(self, op, head, row):
+        """Every row of a paged listing: asks again from where the last page ended."""
+        rows = []
+        while True:
+            st, r = self.call(op, bytes(head) + struct.pack('<II', len(rows), 0))
+            if st != 0:
+                return rows
+            total, n = r.u32(), r.u32()
+            rows += [row(r) for _ in range(n)]
+            if n == 0 or len(rows) >= total:
+                return rows
+
+    # ---- catalog ----
+    def ping(self):
+        return reply(self.call(OP_PING)[0])
+
+    def product(self, barcode):
+        st, r = self.call(OP_GET_PRODUCT, Writer().str(barcode).b)
+        return reply(st, product=r.product() if st == 0 else None)
+
+    def products(self, order=ORDER_CATALOG):
+        return self._pages(OP_LIST_PRODUCTS, Writer().u8(order).b, Reader.product)
+
+    def add_product(self, barcode, name, price, stock, expiry, category):
+        w = Writer().str(barcode).str(name).f64(price).i32(stock).str(expiry).str(category)
+        return reply(self.call(OP_ADD_PRODUCT, w.b)[0])
+
+    # ---- customers and carts ----
+    def add_customer(self, kind, cid, name, address='', payment='', priority=5):
+        w = Writer().u8(kind).str(cid).str(name).str(address).str(payment).i32(priority)
+        return reply(self.call(OP_ADD_CUSTOMER, w.b)[0])
+
+    def customers(self):
+        return self._pages(OP_LIST_CUSTOMERS, b'',
+                           lambda r: SimpleNamespace(id=r.str(), name=r.str(), type=r.str(), cart_lines=r.u32()))
+
+    def _cart(self, op, cid, barcode, qty):
+        st, r = self.call(op, Writer().str(cid).str(barcode).i32(qty).b)
+        return reply(st, product_name=r.str(), customer_name=r.str(), qty=r.i32(), available=r.i32())
+
+    def cart_add(self, cid, barcode, qty):
+        return self._cart(OP_CART_ADD, cid, barcode, qty)
+
+    def cart_remove(self, cid, barcode, qty):
+        return self._cart(OP_CART_REMOVE, cid, barcode, qty)
+
+    def cart_remove_all(self, cid, lines):
+        """Empties a cart in one pipelined round trip; lines as returned by cart_view()."""
+        reqs = [(OP_CART_REMOVE, bytes(Writer().str(cid).str(l.barcode).i32(l.qty).b)) for l in lines]
+        return [st for st, _ in self.call_many(reqs)] if reqs else []
+
+    def cart_undo(self, cid):
+        st, r = self.call(OP_CART_UNDO, Writer().str(cid).b)
+        return reply(st, was_add=r.u8() != 0, barcode=r.str(), qty=r.i32())
+
+    def begin_session(self, cid):
+        return reply(self.call(OP_BEGIN_SESSION, Writer().str(cid).b)[0])
+
+    def end_session(self, cid, forget=False):
+        """Abandons the visit: the cart goes back to the shelf; forget also removes the customer."""
+        st, r = self.call(OP_END_SESSION, Writer().str(cid).u8(1 if forget else 0).b)
+        return reply(st, customer_name=r.str(), lines=r.i32(), units=r.i32(), forgotten=r.u8() != 0)
+
+    def cart_view(self, cid):
+        st, r = self.call(OP_CART_VIEW, Writer().str(cid).b)
+        if st != 0:
+            return reply(st, lines=[], subtotal=0.0)
+        return reply(st, lines=r.lines(), subtotal=r.f64())
+
+    # ---- queues and checkout ----
+    def _enqueue(self, op, cid):
+        st, r = self.call(op, Writer().str(cid).b)
+        return reply(st, customer_name=r.str(), lane=r.str(), special=r.u8() != 0, priority=r.i32(),
+                     promised_by=r.u64())
+
+    def enqueue(self, cid):
+        return self._enqueue(OP_ENQUEUE, cid)
+
+    def place_online(self, cid):
+        return self._enqueue(OP_PLACE_ONLINE, cid)
+
+    def checkout(self, lane, coupon=''):
+        """lane: cashier index, LANE_SPECIAL or LANE_ONLINE."""
+        st, r = self.call(OP_CHECKOUT, Writer().i32(lane).str(coupon).b)
+        return reply(st, coupon_status=r.u8(), sale_id=r.str(), customer_id=r.str(), customer_name=r.str(),
+                     lane=r.str(), online=r.u8() != 0, coupon_applied=r.u8() != 0, subtotal=r.f64(),
+                     after_coupon=r.f64(), special_discount=r.f64(), bulk_discount=r.u8() != 0, total=r.f64(),
+                     lines=r.lines())
+
+    def undo_bill(self, lane):
+        st, r = self.call(OP_UNDO_BILL, Writer().i32(lane).b)
+        return reply(st, sale_id=r.str(), in_ledger=r.u8() != 0)
+
+    def queues(self):
+        st, r = self.call(OP_QUEUE_STATUS)
+        lanes = []
+        for _ in range(r.u32()):
+            lane = r.str()
+            lanes.append((lane, [SimpleNamespace(id=r.str(), name=r.str(), cart_lines=r.u32()) for _ in range(r.u32())]))
+        return lanes
+
+    # ---- reports ----
+    def sales(self):
+        return self._pages(OP_SALES_LEDGER, b'', Reader.sale)
+
+    def report(self):
+        st, r = self.call(OP_SALES_REPORT)
+        return SimpleNamespace(sale_count=r.u64(), revenue=r.u64() / 100.0, by_product=r.ranking(),
+                               by_category=r.ranking(), by_customer=r.ranking(), by_cashier=r.ranking())
+
+    def coupons(self):
+        st, r = self.call(OP_COUPONS)
+        return [(r.str(), r.f64()) for _ in range(r.u32())]
+
+    def changes(self, since=0, limit=1024):
+        """Events from seq `since` on (0 = from now). Pass `next` back in to continue;
+        lapped means events were lost and the caller should reload everything."""
+        st, r = self.call(OP_CHANGES, Writer().u64(since).u32(limit).b)
+        nxt, lapped = r.u64(), r.u8() != 0
+        events = [SimpleNamespace(seq=r.u64(), type=r.u8(), key=r.str(), delta=r.i32(), stock=r.i32(), amount=r.u64())
+                  for _ in range(r.u32())]
+        return SimpleNamespace(next=nxt, lapped=lapped, events=events)
+
+    def shutdown(self):
+        return reply(self.call(OP_SHUTDOWN)[0])
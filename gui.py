@@ -1,91 +1,17 @@
-import re
+import sys
 import tkinter as tk
-from tkinter import ttk, messagebox, simpledialog
-from collections import defaultdict
-from datetime import datetime
-from copy import deepcopy
-
-# Models
-class Product:
-    def __init__(self, barcode, name, price, stock, expiry, category):
-        self.barcode = barcode
-        self.name = name
-        self.price = float(price)
-        self.stock = int(stock)
-        self.expiry = expiry
-        self.category = category
-
-class Customer:
-    def __init__(self, cid, name, ctype='walk-in'):
-        self.id = cid
-        self.name = name
-        self.type = ctype  # 'walk-in', 'online', 'special-needs'
-        self.cart = ShoppingCart()
-
-class ShoppingCart:
-    def __init__(self):
-        self.items = {}  # barcode -> qty
-        self.history = []
-    
-    def add(self, barcode, qty):
-        self.history.append(('add', barcode, qty))
-        self.items[barcode] = self.items.get(barcode, 0) + qty
-    
-    def remove(self, barcode, qty):
-        if barcode in self.items:
-            self.history.append(('remove', barcode, qty))
-            self.items[barcode] -= qty
-            if self.items[barcode] <= 0:
-                del self.items[barcode]
-    
-    def undo(self, catalog):
-        if not self.history:
-            return False
-        op, bc, qty = self.history.pop()
-        if op == 'add':
-            self.items[bc] -= qty
-            if self.items[bc] <= 0:
-                del self.items[bc]
-            if bc in catalog:
-                catalog[bc].stock += qty
-        else:  # remove
-            self.items[bc] = self.items.get(bc, 0) + qty
-            if bc in catalog:
-                catalog[bc].stock -= qty
-        return True
-    
-    def clear(self):
-        self.items.clear()
-        self.history.clear()
-    
-    def total(self, catalog):
-        tot = 0.0
-        for bc, q in self.items.items():
-            p = catalog.get(bc)
-            if p: tot += p.price * q
-        return tot
-    
-    def items_list(self):
-        return list(self.items.items())
-
-class SaleRecord:
-    def __init__(self, sale_id, customer_id, items, total, is_online=False):
-        self.sale_id = sale_id
-        self.customer_id = customer_id
-        self.items = list(items)
-        self.total = total
-        self.is_online = is_online
-        self.timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
-
-class Cashier:
-    def __init__(self, cid):
-        self.id = cid
-        self.queue = []
-        self.undo_stack = []
+from tkinter import ttk, messagebox
+import engine_client as ec
+
+# A view over the C++ engine: every product, cart, queue, coupon and sale lives
+# in the engine process, reached through engine_client.py. Start it first:
+#   main.exe --serve supermarket.sock     (Windows: main.exe --serve 127.0.0.1:7070)
+#   python gui.py [ADDRESS]
 
 class App:
-    def __init__(self, root):
+    def __init__(self, root, engine):
         self.root = root
+        self.engine = engine
         root.title('Supermarket System GUI')
         root.geometry('1200x700')
         icon = tk.PhotoImage(file='supermarket.png')
@@ -99,25 +25,7 @@ class App:
         style.configure('TLabel', background='#F0F0F0')
         style.map('TNotebook.Tab', background=[('selected', '#059E94')], foreground=[('selected', 'white')])
 
-        self.catalog = {}
-        self.customers = {}
-        self.cashiers = [Cashier(f"CASH{i+1}") for i in range(3)]
-        self.special_cashier = Cashier("SPECIAL")
-        self.online_queue = []
-        self.sales = []
-        self.next_sale = 1
-        
-        # Valid coupons: code -> discount_percentage (e.g., "SAVE10" -> 10)
-        self.valid_coupons = {
-            "SAVE10": 10,
-            "SAVE15": 15,
-            "SAVE20": 20,
-            "LOVEEGYPT": 5,
-            "VIP25": 25
-        }
-        self.used_coupons = set()  # Track used coupon codes
-
-        self.load_products_from_system_h()
+        self.lanes = [lane for lane, _ in engine.queues()]  # CASH1.., SPECIAL, ONLINE
 
         # Create red header bar
         header = tk.Frame(root, bg='#FF3333', height=60)
@@ -127,6 +35,7 @@ class App:
                                font=('Arial', 18, 'bold'), 
                                bg='#FF3333', fg='white', padx=20, pady=10)
         title_label.pack(side='left', padx=20)
+        tk.Label(header, text=f'engine: {engine.address}', bg='#FF3333', fg='white').pack(side='right', padx=20)
 
         # Create main notebook
         self.notebook = ttk.Notebook(root)
@@ -157,18 +66,24 @@ class App:
         self.notebook.add(self.tab_sales, text='Sales Report')
         self.setup_sales_tab()
 
-    def load_products_from_system_h(self):
+        self.refresh_customers_list()
+
+        # other tills change stock and sales too: follow the engine's change feed
+        self.feed_pos = engine.changes().next
+        self.root.after(1000, self.follow_changes)
+
+    def follow_changes(self):
         try:
-            with open('system.h', 'r', encoding='utf-8') as f:
-                content = f.read()
-        except Exception as e:
-            messagebox.showerror('Error', f'Cannot open system.h: {e}')
-            return
-        pattern = re.compile(r'inventory\.add_product\(Product\("([^"]+)"\s*,\s*"([^"]+)"\s*,\s*([0-9]+(?:\.[0-9]+)?)\s*,\s*([0-9]+)\s*,\s*"([^"]*)"\s*,\s*"?([^"\)]*)"?\)\)', re.M)
-        for m in pattern.finditer(content):
-            bc, name, price, stock, expiry, cat = m.groups()
-            prod = Product(bc.strip(), name.strip(), float(price), int(stock), expiry.strip(), cat.strip())
-            self.catalog[bc] = prod
+            ch = self.engine.changes(self.feed_pos)
+        except OSError:
+            return  # engine gone; keep the last view
+        self.feed_pos = ch.next
+        types = {e.type for e in ch.events}
+        if ch.lapped or types & {ec.CHANGE_STOCK, ec.CHANGE_PRODUCT, ec.CHANGE_RESYNC}:
+            self.refresh_product_list(self.product_sort)
+        if ch.lapped or types & {ec.CHANGE_SALE, ec.CHANGE_VOID, ec.CHANGE_RESYNC}:
+            self.refresh_sales_report()
+        self.root.after(1000, self.follow_changes)
 
     # ===== BROWSE TAB =====
     def setup_browse_tab(self):
@@ -199,18 +114,17 @@ class App:
         ttk.Button(right, text='Product Details', command=self.show_product_details).pack(pady=4, fill='x')
 
     def refresh_product_list(self, sort_by='barcode'):
+        self.product_sort = sort_by
         self.prod_list.delete(0, tk.END)
-        products = list(self.catalog.values())
-        
-        # Sort products
-        if sort_by == 'price_asc':
-            products.sort(key=lambda p: p.price)
-        elif sort_by == 'price_desc':
-            products.sort(key=lambda p: p.price, reverse=True)
+        # price and category orders come sorted from the engine
+        if sort_by in ('price_asc', 'price_desc'):
+            products = self.engine.products(ec.ORDER_PRICE)
+            if sort_by == 'price_desc':
+                products.reverse()
         elif sort_by == 'category':
-            products.sort(key=lambda p: (p.category, p.name))
+            products = self.engine.products(ec.ORDER_CATEGORY)
         else:  # barcode
-            products.sort(key=lambda p: p.barcode)
+            products = sorted(self.engine.products(), key=lambda p: p.barcode)
         
         for p in products:
             self.prod_list.insert(tk.END, f"{p.barcode} | {p.name} | LE{p.price:.2f} | stock: {p.stock} | {p.category}")
@@ -222,9 +136,12 @@ class App:
             return
         line = self.prod_list.get(sel[0])
         barcode = line.split('|')[0].strip()
-        p = self.catalog.get(barcode)
-        if p:
+        r = self.engine.product(barcode)
+        if r.ok:
+            p = r.product
             messagebox.showinfo('Product Details', f"Barcode: {p.barcode}\nName: {p.name}\nPrice: LE{p.price:.2f}\nStock: {p.stock}\nExpiry: {p.expiry}\nCategory: {p.category}")
+        else:
+            messagebox.showerror('Error', r.message)
 
     # ===== CUSTOMERS TAB =====
     def setup_customers_tab(self):
@@ -260,18 +177,19 @@ class App:
         if not cid or not name:
             messagebox.showinfo('Info', 'Enter ID and Name')
             return
-        if cid in self.customers:
-            messagebox.showerror('Error', 'Customer already exists')
+        kind = {'online': ec.KIND_ONLINE, 'special-needs': ec.KIND_SPECIAL}.get(ctype, ec.KIND_WALKIN)
+        r = self.engine.add_customer(kind, cid, name)
+        if not r.ok:
+            messagebox.showerror('Error', r.message)
             return
-        self.customers[cid] = Customer(cid, name, ctype)
         self.refresh_customers_list()
         self.cust_id_var.set('')
         self.cust_name_var.set('')
 
     def refresh_customers_list(self):
         self.cust_list.delete(0, tk.END)
-        for cid, c in self.customers.items():
-            self.cust_list.insert(tk.END, f"{cid} | {c.name} | {c.type} | Cart: {len(c.cart.items)} items")
+        for c in sorted(self.engine.customers(), key=lambda c: c.id):
+            self.cust_list.insert(tk.END, f"{c.id} | {c.name} | {c.type} | Cart: {c.cart_lines} items")
 
     # ===== CART TAB =====
     def setup_cart_tab(self):
@@ -322,90 +240,90 @@ class App:
         ttk.Entry(coupon_frame, textvariable=self.coupon_var, width=15).pack(side='left', padx=2)
         ttk.Button(coupon_frame, text='Valid Coupons', command=self.show_valid_coupons).pack(side='left', padx=4)
 
+    def customer_choices(self):
+        return [f"{c.id} ({c.name})" for c in sorted(self.engine.customers(), key=lambda c: c.id)]
+
     def refresh_cust_combo(self):
-        self.sel_cust_combo['values'] = [f"{cid} ({c.name})" for cid, c in self.customers.items()]
+        self.sel_cust_combo['values'] = self.customer_choices()
 
     def get_selected_customer(self):
         sel = self.sel_cust_var.get()
         if not sel or '(' not in sel:
             messagebox.showinfo('Info', 'Select a customer')
             return None
-        cid = sel.split('(')[0].strip()
-        return self.customers.get(cid)
+        return sel.split('(')[0].strip()
 
     def add_to_cart(self):
-        c = self.get_selected_customer()
-        if not c: return
+        cid = self.get_selected_customer()
+        if not cid: return
         bc = self.add_barcode_var.get()
-        qty = self.add_qty_var.get()
+        try:
+            qty = self.add_qty_var.get()
+        except tk.TclError:
+            qty = 0
         if not bc or qty <= 0:
             messagebox.showinfo('Info', 'Enter valid barcode and qty')
             return
-        p = self.catalog.get(bc)
-        if not p:
-            messagebox.showerror('Error', f'Product {bc} not found')
+        r = self.engine.cart_add(cid, bc, qty)
+        if r.status == ec.STATUS_OUT_OF_STOCK:
+            messagebox.showerror('Error', f'Not enough stock (available {r.available})')
             return
-        if p.stock < qty:
-            messagebox.showerror('Error', f'Not enough stock (available {p.stock})')
+        if not r.ok:
+            messagebox.showerror('Error', r.message)
             return
-        p.stock -= qty
-        c.cart.add(bc, qty)
         self.refresh_product_list()
         self.refresh_cart_list()
         self.add_barcode_var.set('')
 
     def refresh_cart_list(self):
-        c = self.get_selected_customer()
-        if not c: return
+        cid = self.get_selected_customer()
+        if not cid: return
         self.cart_list.delete(0, tk.END)
-        for bc, q in c.cart.items_list():
-            p = self.catalog.get(bc)
-            name = p.name if p else '<unknown>'
-            price = p.price if p else 0.0
-            self.cart_list.insert(tk.END, f"{bc} | {name} | qty: {q} | unit: LE{price:.2f}")
+        for l in self.engine.cart_view(cid).lines:
+            self.cart_list.insert(tk.END, f"{l.barcode} | {l.name} | qty: {l.qty} | unit: LE{l.unit_price:.2f}")
 
     def remove_from_cart(self):
-        c = self.get_selected_customer()
-        if not c: return
+        cid = self.get_selected_customer()
+        if not cid: return
         sel = self.cart_list.curselection()
         if not sel:
             messagebox.showinfo('Info', 'Select item')
             return
         line = self.cart_list.get(sel[0])
         bc = line.split('|')[0].strip()
-        if bc in c.cart.items:
-            qty = c.cart.items[bc]
-            c.cart.remove(bc, qty)
-            if bc in self.catalog:
-                self.catalog[bc].stock += qty
+        qty = int(line.split('qty:')[1].split('|')[0])
+        r = self.engine.cart_remove(cid, bc, qty)
+        if not r.ok:
+            messagebox.showerror('Error', r.message)
         self.refresh_product_list()
         self.refresh_cart_list()
 
     def undo_cart(self):
-        c = self.get_selected_customer()
-        if not c: return
-        if c.cart.undo(self.catalog):
+        cid = self.get_selected_customer()
+        if not cid: return
+        r = self.engine.cart_undo(cid)
+        if r.ok:
             messagebox.showinfo('Info', 'Undid last action')
         else:
-            messagebox.showinfo('Info', 'Nothing to undo')
+            messagebox.showinfo('Info', r.message)
         self.refresh_product_list()
         self.refresh_cart_list()
 
     def clear_cart(self):
-        c = self.get_selected_customer()
-        if not c: return
-        for bc, q in list(c.cart.items_list()):
-            if bc in self.catalog:
-                self.catalog[bc].stock += q
-        c.cart.clear()
+        cid = self.get_selected_customer()
+        if not cid: return
+        self.engine.cart_remove_all(cid, self.engine.cart_view(cid).lines)
         self.refresh_product_list()
         self.refresh_cart_list()
 
     def view_cart_total(self):
-        c = self.get_selected_customer()
-        if not c: return
-        tot = c.cart.total(self.catalog)
-        messagebox.showinfo('Cart Total', f"Current total: LE {tot:.2f}")
+        cid = self.get_selected_customer()
+        if not cid: return
+        r = self.engine.cart_view(cid)
+        if not r.ok:
+            messagebox.showerror('Error', r.message)
+            return
+        messagebox.showinfo('Cart Total', f"Current total: LE {r.subtotal:.2f}")
 
     # ===== QUEUES TAB =====
     def setup_queues_tab(self):
@@ -419,14 +337,14 @@ class App:
         self.enq_cust_combo = ttk.Combobox(f, textvariable=self.enq_cust_var, values=[], width=20, state='readonly')
         self.enq_cust_combo.pack(side='left', padx=4)
         ttk.Button(f, text='Enqueue', command=self.enqueue_customer).pack(side='left', padx=4)
-        ttk.Button(f, text='Refresh', command=lambda: self.enq_cust_combo.config(values=[f"{cid} ({c.name})" for cid, c in self.customers.items()])).pack(side='left', padx=4)
+        ttk.Button(f, text='Refresh', command=lambda: self.enq_cust_combo.config(values=self.customer_choices())).pack(side='left', padx=4)
 
         # Checkout section
         mid = ttk.Frame(self.tab_queues, padding=8)
         mid.pack(fill='x')
         ttk.Label(mid, text='Process Checkout from:', font=('Arial', 10, 'bold')).pack(side='left', padx=4)
         self.cashier_var = tk.StringVar(value='CASH1')
-        ttk.Combobox(mid, textvariable=self.cashier_var, values=['CASH1', 'CASH2', 'CASH3', 'SPECIAL'], width=12, state='readonly').pack(side='left', padx=4)
+        ttk.Combobox(mid, textvariable=self.cashier_var, values=[l for l in self.lanes if l != 'ONLINE'], width=12, state='readonly').pack(side='left', padx=4)
         ttk.Button(mid, text='Checkout', command=self.process_checkout).pack(side='left', padx=4)
         ttk.Button(mid, text='Undo last bill', command=self.undo_bill).pack(side='left', padx=4)
 
@@ -451,149 +369,65 @@ class App:
             messagebox.showinfo('Info', 'Select a customer')
             return
         cid = sel.split('(')[0].strip()
-        c = self.customers.get(cid)
-        if not c: return
-        if c.type == 'special-needs':
-            self.special_cashier.queue.append(c)
-            messagebox.showinfo('Info', f"{c.name} enqueued to SPECIAL cashier")
-        elif c.type == 'online':
-            self.online_queue.append(c)
-            messagebox.showinfo('Info', f"{c.name} added to online queue")
-        else:  # walk-in
-            self.cashiers[0].queue.append(c)  # use first cashier for simplicity
-            messagebox.showinfo('Info', f"{c.name} enqueued to CASH1")
-        self.refresh_queue_status()
-
-    def process_checkout(self):
-        cashier_id = self.cashier_var.get()
-        if cashier_id == 'SPECIAL':
-            cashier = self.special_cashier
+        # online customers place an order; everyone else joins the shortest till
+        online = any(c.id == cid and c.type == 'Online' for c in self.engine.customers())
+        r = self.engine.place_online(cid) if online else self.engine.enqueue(cid)
+        if not r.ok:
+            messagebox.showerror('Error', r.message)
+        elif r.lane == 'ONLINE':
+            messagebox.showinfo('Info', f"{r.customer_name} added to online queue (priority {r.priority})")
         else:
-            idx = int(cashier_id[-1]) - 1
-            cashier = self.cashiers[idx]
+            messagebox.showinfo('Info', f"{r.customer_name} enqueued to {r.lane}")
+        self.refresh_queue_status()
 
-        if not cashier.queue:
-            messagebox.showinfo('Info', 'Queue is empty')
-            return
+    def selected_lane(self):
+        lane = self.cashier_var.get()
+        return ec.LANE_SPECIAL if lane == 'SPECIAL' else self.lanes.index(lane)
 
-        c = cashier.queue.pop(0)
-        if not c.cart.items:
-            messagebox.showinfo('Info', f"{c.name} has empty cart")
+    def show_checkout(self, r, title):
+        if not r.ok:
+            messagebox.showinfo('Info', f"{r.customer_name}: {r.message}" if r.customer_name else r.message)
             return
-
-        # Apply discounts
-        tot = c.cart.total(self.catalog)
-        coupon_discount = 0.0
-        
-        # Apply coupon if provided
-        coupon_code = self.coupon_var.get().strip().upper()
-        if coupon_code:
-            if coupon_code in self.valid_coupons and coupon_code not in self.used_coupons:
-                coupon_discount = tot * (self.valid_coupons[coupon_code] / 100.0)
-                tot -= coupon_discount
-                self.used_coupons.add(coupon_code)
-                messagebox.showinfo('Coupon Applied', f'Coupon {coupon_code} applied: -LE {coupon_discount:.2f}')
-            elif coupon_code in self.used_coupons:
-                messagebox.showwarning('Coupon', f'Coupon {coupon_code} already used')
-            else:
-                messagebox.showwarning('Coupon', f'Invalid coupon: {coupon_code}')
-        
-        # Apply special-needs 10% discount
-        if c.type == 'special-needs':
-            discount = tot * 0.10
-            tot -= discount
-        
-        # Apply bulk discount 5% for >= 1000
-        if tot >= 1000.0:
-            tot = tot * 0.95
-
-        sid = f"S{self.next_sale}"
-        self.next_sale += 1
-        rec = SaleRecord(sid, c.id, c.cart.items_list(), tot, c.type == 'online')
-        self.sales.append(rec)
-        cashier.undo_stack.append(rec)
-
-        messagebox.showinfo('Checkout', f'Sale {sid} complete.\nCustomer: {c.name}\nTotal: LE {tot:.2f}')
-        c.cart.clear()
+        coupon = self.coupon_var.get().strip().upper()
+        if coupon and not r.coupon_applied:
+            messagebox.showwarning('Coupon', ec.status_message(r.coupon_status))
+        text = f'Sale {r.sale_id} complete.\nCustomer: {r.customer_name}\nSubtotal: LE {r.subtotal:.2f}'
+        if r.coupon_applied:
+            text += f'\nAfter coupon {coupon}: LE {r.after_coupon:.2f}'
+        if r.special_discount > 0:
+            text += f'\nSpecial-needs discount: -LE {r.special_discount:.2f}'
+        if r.bulk_discount:
+            text += '\nBulk discount: 5%'
+        text += f'\nTotal: LE {r.total:.2f}'
+        messagebox.showinfo(title, text)
         self.coupon_var.set('')
+
+    def process_checkout(self):
+        r = self.engine.checkout(self.selected_lane(), self.coupon_var.get().strip().upper())
+        self.show_checkout(r, 'Checkout')
         self.refresh_queue_status()
 
     def undo_bill(self):
-        cashier_id = self.cashier_var.get()
-        if cashier_id == 'SPECIAL':
-            cashier = self.special_cashier
-        else:
-            idx = int(cashier_id[-1]) - 1
-            cashier = self.cashiers[idx]
-
-        if not cashier.undo_stack:
-            messagebox.showinfo('Info', 'No bills to undo')
+        r = self.engine.undo_bill(self.selected_lane())
+        if not r.ok:
+            messagebox.showinfo('Info', r.message)
             return
-
-        rec = cashier.undo_stack.pop()
-        for bc, q in rec.items:
-            if bc in self.catalog:
-                self.catalog[bc].stock += q
-        self.sales = [s for s in self.sales if s.sale_id != rec.sale_id]
-
-        messagebox.showinfo('Undo', f'Undid sale {rec.sale_id} and restored stock')
+        messagebox.showinfo('Undo', f'Undid sale {r.sale_id} and restored stock')
         self.refresh_queue_status()
 
     def refresh_queue_status(self):
         self.queue_text.delete(1.0, tk.END)
         text = "=== CASHIER QUEUES ===\n"
-        for i, cs in enumerate(self.cashiers):
-            text += f"\n{cs.id} ({len(cs.queue)} customers):\n"
-            for c in cs.queue:
-                text += f"  - {c.id} | {c.name} | Cart items: {len(c.cart.items)}\n"
-        text += f"\nSPECIAL ({len(self.special_cashier.queue)} customers):\n"
-        for c in self.special_cashier.queue:
-            text += f"  - {c.id} | {c.name} | Cart items: {len(c.cart.items)}\n"
-        text += f"\nONLINE ({len(self.online_queue)} orders):\n"
-        for c in self.online_queue:
-            text += f"  - {c.id} | {c.name} | Cart items: {len(c.cart.items)}\n"
+        for lane, waiting in self.engine.queues():
+            noun = 'orders' if lane == 'ONLINE' else 'customers'
+            text += f"\n{lane} ({len(waiting)} {noun}):\n"
+            for c in waiting:
+                text += f"  - {c.id} | {c.name} | Cart items: {c.cart_lines}\n"
         self.queue_text.insert(1.0, text)
 
     def process_online_order(self):
-        if not self.online_queue:
-            messagebox.showinfo('Info', 'No online orders in queue')
-            return
-
-        c = self.online_queue.pop(0)
-        if not c.cart.items:
-            messagebox.showinfo('Info', f"{c.name} has empty cart")
-            return
-
-        # Apply discounts (no special-needs discount for online customers)
-        tot = c.cart.total(self.catalog)
-        coupon_discount = 0.0
-        
-        # Apply coupon if provided
-        coupon_code = self.coupon_var.get().strip().upper()
-        if coupon_code:
-            if coupon_code in self.valid_coupons and coupon_code not in self.used_coupons:
-                coupon_discount = tot * (self.valid_coupons[coupon_code] / 100.0)
-                tot -= coupon_discount
-                self.used_coupons.add(coupon_code)
-                messagebox.showinfo('Coupon Applied', f'Coupon {coupon_code} applied: -LE {coupon_discount:.2f}')
-            elif coupon_code in self.used_coupons:
-                messagebox.showwarning('Coupon', f'Coupon {coupon_code} already used')
-            else:
-                messagebox.showwarning('Coupon', f'Invalid coupon: {coupon_code}')
-        
-        if tot >= 1000.0:
-            tot = tot * 0.95
-
-        sid = f"S{self.next_sale}"
-        self.next_sale += 1
-        rec = SaleRecord(sid, c.id, c.cart.items_list(), tot, is_online=True)
-        self.sales.append(rec)
-        if self.cashiers:
-            self.cashiers[0].undo_stack.append(rec)
-
-        messagebox.showinfo('Online Order Processed', f'Sale {sid} complete.\nCustomer: {c.name}\nTotal: LE {tot:.2f}')
-        c.cart.clear()
-        self.coupon_var.set('')
+        r = self.engine.checkout(ec.LANE_ONLINE, self.coupon_var.get().strip().upper())
+        self.show_checkout(r, 'Online Order Processed')
         self.refresh_queue_status()
 
     # ===== SALES TAB =====
@@ -615,59 +449,60 @@ class App:
         self.sales_top_text.pack(fill='both', expand=True)
 
     def refresh_sales_report(self):
+        products = {p.barcode: p for p in self.engine.products()}
         # Sales records
         self.sales_records_text.delete(1.0, tk.END)
         text = "=== SALES RECORDS ===\n"
-        for s in self.sales:
-            text += f"{s.sale_id} | Cust: {s.customer_id} | {'Online' if s.is_online else 'Walk-in'} | LE {s.total:.2f} | {s.timestamp}\n"
+        for s in self.engine.sales():
+            text += f"{s.sale_id} | Cust: {s.customer_id} | {'Online' if s.online else s.cashier_id} | LE {s.total:.2f} | {s.time}\n"
             for bc, q in s.items:
-                p = self.catalog.get(bc)
+                p = products.get(bc)
                 name = p.name if p else '<unknown>'
                 text += f"   - {bc} ({name}) x{q}\n"
         self.sales_records_text.insert(1.0, text)
 
         # Top sold products
         self.sales_top_text.delete(1.0, tk.END)
-        tally = defaultdict(int)
-        for s in self.sales:
-            for bc, q in s.items:
-                tally[bc] += q
-
-        rows = []
-        for bc, q in tally.items():
-            p = self.catalog.get(bc)
+        rep = self.engine.report()
+        top_text = f"=== TOP SOLD PRODUCTS === ({rep.sale_count} sales, revenue LE {rep.revenue:.2f})\n"
+        for i, (bc, q) in enumerate(rep.by_product[:10], 1):
+            p = products.get(bc)
             name = p.name if p else '<unknown>'
             revenue = (p.price if p else 0.0) * q
-            rows.append((bc, name, q, revenue))
-        rows.sort(key=lambda x: x[2], reverse=True)
-
-        top_text = "=== TOP SOLD PRODUCTS ===\n"
-        for i, (bc, name, q, rev) in enumerate(rows[:10], 1):
-            top_text += f"{i}. {bc} | {name} | qty: {q} | revenue: LE {rev:.2f}\n"
+            top_text += f"{i}. {bc} | {name} | qty: {q} | revenue: LE {revenue:.2f}\n"
         self.sales_top_text.insert(1.0, top_text)
 
     def export_sales_csv(self):
-        if not self.sales:
+        sales = self.engine.sales()
+        if not sales:
             messagebox.showinfo('Info', 'No sales to export')
             return
         try:
             with open('sales_export.csv', 'w', encoding='utf-8') as f:
                 f.write('Sale ID,Customer ID,Type,Total (LE),Timestamp,Items\n')
-                for s in self.sales:
+                for s in sales:
                     items_str = ';'.join([f"{bc}x{q}" for bc, q in s.items])
-                    f.write(f'{s.sale_id},{s.customer_id},{"Online" if s.is_online else "Walk-in"},{s.total:.2f},{s.timestamp},{items_str}\n')
+                    f.write(f'{s.sale_id},{s.customer_id},{"Online" if s.online else "Walk-in"},{s.total:.2f},{s.time},{items_str}\n')
             messagebox.showinfo('Success', 'Exported to sales_export.csv')
         except Exception as e:
             messagebox.showerror('Error', f'Export failed: {e}')
 
     def show_valid_coupons(self):
-        msg = "Valid Coupons (each can be used once):\n\n"
-        for code, discount in self.valid_coupons.items():
-            status = "(USED)" if code in self.used_coupons else "(Available)"
-            msg += f"• {code}: {discount}% off {status}\n"
+        msg = "Valid Coupons (one per bill):\n\n"
+        for code, discount in self.engine.coupons():
+            msg += f"• {code}: {discount:g}% off\n"
         messagebox.showinfo('Available Coupons', msg)
 
 if __name__ == '__main__':
+    address = sys.argv[1] if len(sys.argv) > 1 else ec.default_address()
+    try:
+        engine = ec.EngineClient(address)
+    except OSError as e:
+        root = tk.Tk()
+        root.withdraw()
+        messagebox.showerror('Engine not running',
+                             f'Cannot reach the engine at {address}: {e}\n\nStart it with\n  main.exe --serve {address}')
+        sys.exit(1)
     root = tk.Tk()
-    app = App(root)
+    app = App(root, engine)
     root.mainloop()
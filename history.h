@@ -0,0 +1,125 @@
+// history.h
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include "sales.h"
+#include "inventory.h"
+#include "report.h"
+using namespace std;
+
+enum class LoyaltyTier { Bronze, Silver, Gold, Platinum };
+
+inline string tier_name(LoyaltyTier t) {
+    switch (t) {
+        case LoyaltyTier::Silver: return "Silver";
+        case LoyaltyTier::Gold: return "Gold";
+        case LoyaltyTier::Platinum: return "Platinum";
+        default: return "Bronze";
+    }
+}
+
+// everything we know about one customer's purchases, kept up to date at commit/undo
+struct CustomerHistory {
+    vector<const SaleRecord*> sales;        // live sales of the current day, oldest first
+    long long lifetimeSpend = 0;            // piasters, survives close of day
+    int visits = 0;
+    string lastVisit;
+    unordered_map<string, int> categoryUnits;
+    string favouriteCategory;
+    int favouriteUnits = 0;
+
+    void refresh_favourite() {
+        favouriteCategory = ""; favouriteUnits = 0;
+        for (auto &kv : categoryUnits) {
+            if (kv.second > favouriteUnits || (kv.second == favouriteUnits && kv.first < favouriteCategory)) {
+                favouriteCategory = kv.first; favouriteUnits = kv.second;
+            }
+        }
+    }
+};
+
+class CustomerIndex {
+private:
+    unordered_map<string, CustomerHistory> byCustomer;
+
+    static string category_of(const Inventory& inv, const string& barcode) {
+        const Product* p = inv.peek(barcode);
+        return p ? p->category : string("Unknown");
+    }
+
+public:
+    void on_sale(const SaleRecord& s, const Inventory& inv) {
+        CustomerHistory& h = byCustomer[s.customerId];
+        h.sales.push_back(&s);
+        h.lifetimeSpend += to_piasters(s.total);
+        h.visits++;
+        h.lastVisit = s.time;
+        for (auto &it : s.items) {
+            string cat = category_of(inv, it.first);
+            int units = (h.categoryUnits[cat] += it.second);
+            if (units > h.favouriteUnits) { h.favouriteUnits = units; h.favouriteCategory = cat; }
+        }
+    }
+
+    // must run before the record is deleted
+    void on_undo(const SaleRecord& s, const Inventory& inv) {
+        auto f = byCustomer.find(s.customerId);
+        if (f == byCustomer.end()) return;
+        CustomerHistory& h = f->second;
+        auto it = find(h.sales.begin(), h.sales.end(), &s);
+        if (it == h.sales.end()) return;
+        h.sales.erase(it);
+        h.lifetimeSpend -= to_piasters(s.total);
+        h.visits--;
+        if (!h.sales.empty()) h.lastVisit = h.sales.back()->time;
+        else if (h.visits == 0) h.lastVisit = "";
+        for (auto &item : s.items) h.categoryUnits[category_of(inv, item.first)] -= item.second;
+        h.refresh_favourite();
+    }
+
+    // the ledger was archived: drop the handles, keep the aggregates
+    void forget_sales() {
+        for (auto &kv : byCustomer) kv.second.sales.clear();
+    }
+
+    // the customer was forgotten; a later one given the same id starts clean
+    void forget(const string& customerId) { byCustomer.erase(customerId); }
+
+    // start over from a ledger (newest first, as SalesList::ledger() returns it)
+    void rebuild(const vector<const SaleRecord*>& ledger, const Inventory& inv) {
+        byCustomer.clear();
+        for (size_t i = ledger.size(); i-- > 0;) on_sale(*ledger[i], inv);
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("purchase history");
+        m.elements = byCustomer.size();
+        account_hash(m, byCustomer);
+        for (auto &kv : byCustomer) {
+            const CustomerHistory& h = kv.second;
+            account_string(m, kv.first);
+            account_vector(m, h.sales);
+            account_string(m, h.lastVisit);
+            account_string(m, h.favouriteCategory);
+            account_hash(m, h.categoryUnits);
+            for (auto &c : h.categoryUnits) account_string(m, c.first);
+        }
+        return m;
+    }
+
+    const CustomerHistory* find_history(const string& customerId) const {
+        auto f = byCustomer.find(customerId);
+        return f == byCustomer.end() ? nullptr : &f->second;
+    }
+
+    LoyaltyTier tier(const string& customerId) const {
+        const CustomerHistory* h = find_history(customerId);
+        long long spend = h ? h->lifetimeSpend : 0;
+        if (spend >= 2000000) return LoyaltyTier::Platinum; // LE 20,000
+        if (spend >= 500000) return LoyaltyTier::Gold;      // LE 5,000
+        if (spend >= 100000) return LoyaltyTier::Silver;    // LE 1,000
+        return LoyaltyTier::Bronze;
+    }
+};
@@ -4,33 +4,201 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <bitset>
+#include <cmath>
+#include <memory>
 #include "product.h"
+#include "changefeed.h"
+#include "metrics.h"
+#include "default_catalog.h"
+#include "output.h"
 using namespace std;
 
+inline const LineTemplate PRODUCT_ROW("{0} | {1} | {2} LE  | stock: {3} | expiry: {4} | {5}\n");
+
+inline void write_product(OutBuffer& out, const Product& p) {
+    PRODUCT_ROW.render(out, {p.barcode, p.name, Money{p.price}, p.stock, p.expiry, p.category});
+}
+
+// A catalog several inventories start from (the stores of a chain, chain.h):
+// names, prices, categories and opening stock are held once, read-only, and
+// a store copies a row into its own table only when it first touches it,
+// the same way the built-in catalog works.
+struct SharedCatalog {
+    vector<Product> rows;
+    unordered_map<string, uint32_t> index; // barcode : row
+
+    explicit SharedCatalog(vector<Product> products) : rows(move(products)) {
+        index.reserve(rows.size());
+        for (uint32_t i = 0; i < rows.size(); ++i) index.emplace(rows[i].barcode, i);
+    }
+    int find(const string& barcode) const {
+        auto it = index.find(barcode);
+        return it == index.end() ? -1 : (int)it->second;
+    }
+    size_t size() const { return rows.size(); }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("shared catalog");
+        m.elements = rows.size();
+        account_vector(m, rows);
+        for (auto &p : rows) account_product(m, p);
+        account_hash(m, index);
+        for (auto &kv : index) account_string(m, kv.first);
+        return m;
+    }
+};
+
 class Inventory {
 private:
-    unordered_map<string, Product> table; // barcode : product
+    // barcode : product. Rows of the built-in or shared catalog are copied in
+    // by find(), the first time a caller may change them; peek() reads them
+    // where they are.
+    unordered_map<string, Product> table;
+    bool useDefault = false;
+    bitset<DEFAULT_CATALOG_SIZE> copied;    // default rows already in table
+    shared_ptr<const SharedCatalog> shared; // null unless use_shared_catalog() was called
+    vector<bool> sharedCopied;              // shared rows already in table
+    size_t sharedCopiedCount = 0;
+    ChangeFeed* feed = nullptr; // stock and product events go here when set
+
+    void publish_stock(const Product& p, int delta) const {
+        if (feed) feed->publish(ChangeType::StockChanged, p.barcode, delta, p.stock, 0);
+    }
+    void publish_added(const Product& p) const {
+        if (feed) feed->publish(ChangeType::ProductAdded, p.barcode, 0, p.stock, llround(p.price * 100.0));
+    }
+
+    static Product default_row(size_t i) {
+        const CatalogEntry& e = DEFAULT_CATALOG[i];
+        return Product(string(e.barcode), string(e.name), e.price, e.stock, string(e.expiry),
+                       string(DEFAULT_CATEGORIES[e.category]));
+    }
+    // the built-in catalog as Products, built on the first peek() and never changed
+    static const vector<Product>& default_rows() {
+        static const vector<Product> rows = [] {
+            vector<Product> v;
+            v.reserve(DEFAULT_CATALOG_SIZE);
+            for (size_t i = 0; i < DEFAULT_CATALOG_SIZE; ++i) v.push_back(default_row(i));
+            return v;
+        }();
+        return rows;
+    }
+    Product* from_default(const string& barcode) {
+        if (shared) {
+            int row = shared->find(barcode);
+            if (row < 0 || sharedCopied[row]) return nullptr;
+            sharedCopied[row] = true;
+            sharedCopiedCount++;
+            return &table.emplace(barcode, shared->rows[row]).first->second;
+        }
+        if (!useDefault) return nullptr;
+        int row = default_catalog_find(barcode);
+        if (row < 0 || copied[row]) return nullptr;
+        copied.set(row);
+        return &table.emplace(barcode, default_row(row)).first->second;
+    }
+    bool known(const string& barcode) const {
+        if (table.count(barcode)) return true;
+        if (shared) {
+            int row = shared->find(barcode);
+            return row >= 0 && !sharedCopied[row];
+        }
+        if (!useDefault) return false;
+        int row = default_catalog_find(barcode);
+        return row >= 0 && !copied[row];
+    }
+
 public:
+    void set_feed(ChangeFeed* f) { feed = f; }
+    ChangeFeed* change_feed() const { return feed; }
+
+    // starts from the compiled-in catalog without building anything
+    void use_default_catalog() {
+        clear();
+        useDefault = true;
+    }
+    // starts from a catalog shared with other inventories (see SharedCatalog)
+    void use_shared_catalog(shared_ptr<const SharedCatalog> c) {
+        clear();
+        shared = move(c);
+        if (shared) sharedCopied.assign(shared->size(), false);
+    }
+    const SharedCatalog* shared_catalog() const { return shared.get(); }
+    // rows of the shared catalog this inventory holds a copy of
+    size_t shared_rows_copied() const { return sharedCopiedCount; }
+    // true while the products are exactly the built-in catalog (stock may differ)
+    bool only_default_catalog() const { return useDefault && table.size() == copied.count(); }
+    // live copy of a built-in catalog row
+    Product default_product(size_t row) const {
+        if (copied[row]) return table.find(string(DEFAULT_CATALOG[row].barcode))->second;
+        return default_row(row);
+    }
+
     bool add_product(const Product& p) {
-        if (table.count(p.barcode)) {
+        if (known(p.barcode)) {
             return false;
         }
         else{
             table[p.barcode] = p;
+            publish_added(p);
         return true;
         }
     }
 
+    // bulk loaders hand over their freshly parsed products
+    bool add_product(Product&& p) {
+        if ((useDefault || shared) && known(p.barcode)) return false;
+        auto slot = table.try_emplace(p.barcode);
+        if (!slot.second) return false;
+        slot.first->second = move(p);
+        publish_added(slot.first->second);
+        return true;
+    }
+
+    void reserve(size_t n) { table.reserve(n); }
+    void clear() {
+        table.clear(); useDefault = false; copied.reset();
+        shared.reset(); sharedCopied.clear(); sharedCopiedCount = 0;
+    }
+    size_t size() const {
+        return table.size() + (useDefault ? DEFAULT_CATALOG_SIZE - copied.count() : 0)
+             + (shared ? shared->size() - sharedCopiedCount : 0);
+    }
+
     Product* find(const string& barcode) {
+        METRIC_SCOPE_SAMPLED(Metric::InventoryFind, 64);
         auto it = table.find(barcode);
         if (it == table.end()){
-            return nullptr;
+            return from_default(barcode);
         } 
         else{
             return &(it->second);
         }
     }
 
+    // the product as it stands, without copying a catalog row in: several
+    // threads may peek while nothing writes. The pointer is good until the
+    // next call that changes the inventory.
+    const Product* peek(const string& barcode) const {
+        METRIC_SCOPE_SAMPLED(Metric::InventoryFind, 64);
+        auto it = table.find(barcode);
+        if (it != table.end()) return &it->second;
+        if (shared) {
+            int row = shared->find(barcode);
+            return row >= 0 && !sharedCopied[row] ? &shared->rows[row] : nullptr;
+        }
+        if (!useDefault) return nullptr;
+        int row = default_catalog_find(barcode);
+        return row >= 0 && !copied[row] ? &default_rows()[row] : nullptr;
+    }
+
+    // shelf stock; -1 for an unknown barcode
+    int stock_of(const string& barcode) const {
+        const Product* p = peek(barcode);
+        return p ? p->stock : -1;
+    }
+
     bool update_stock(const string& barcode, int delta) {
         auto p = find(barcode);
         if (!p){
@@ -43,26 +211,74 @@ public:
                 return false;
             }
             else{
+                publish_stock(*p, delta);
                 return true;
             }
         }  
     }
 
+    // applies delta to a product already looked up (no second find)
+    void move_stock(Product& p, int delta) {
+        p.stock += delta;
+        publish_stock(p, delta);
+    }
+
+    // the table and its text; built-in rows never touched are compile-time
+    // data, and a shared catalog is reported on its own
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("inventory");
+        m.elements = size();
+        account_hash(m, table);
+        for (auto &kv : table) {
+            account_string(m, kv.first);
+            account_product(m, kv.second);
+        }
+        m.add(sharedCopied.size() / 8, heap_block((sharedCopied.capacity() + 7) / 8));
+        return m;
+    }
+
     vector<Product> all_products() const {
-        vector<Product> v; v.reserve(table.size());
+        vector<Product> v; v.reserve(size());
         for(auto it = table.begin(); it != table.end(); ++it)
          {
             v.push_back(it->second);
          }
+        if (useDefault)
+            for (size_t i = 0; i < DEFAULT_CATALOG_SIZE; ++i) if (!copied[i]) v.push_back(default_row(i));
+        if (shared)
+            for (size_t i = 0; i < shared->size(); ++i) if (!sharedCopied[i]) v.push_back(shared->rows[i]);
         return v;
     }
 
-    void print_all() const {
-        cout << "Inventory:\n";
-        for (auto &kv : table) {
-            const Product &p = kv.second;
-            cout << p.barcode << " | " << p.name << " | " << p.price << " LE "
-                 << " | stock: " << p.stock << " | expiry: " << p.expiry << " | " << p.category << '\n';
-        }
+    // f(product) for rows first, first + 1, ... in all_products() order until
+    // f returns false. Earlier rows are only counted, and built-in rows are
+    // built just for the rows visited.
+    template<typename F> void for_each(size_t first, F f) const {
+        size_t row = 0;
+        for (auto it = table.begin(); it != table.end(); ++it, ++row)
+            if (row >= first && !f(it->second)) return;
+        if (useDefault)
+            for (size_t i = 0; i < DEFAULT_CATALOG_SIZE; ++i) {
+                if (copied[i]) continue;
+                if (row++ >= first && !f(default_row(i))) return;
+            }
+        if (shared)
+            for (size_t i = 0; i < shared->size(); ++i)
+                if (!sharedCopied[i] && row++ >= first && !f(shared->rows[i])) return;
+    }
+
+    // rows in all_products() order; rows outside the window are not formatted
+    void write_all(OutBuffer& out, RowWindow w = RowWindow()) const {
+        out.text("Inventory:\n");
+        size_t left = w.count;
+        for_each(w.first, [&](const Product& p) {
+            if (left == 0) return false;
+            write_product(out, p);
+            return --left > 0;
+        });
+    }
+    void print_all(const OutputSink& sink = console_sink()) const {
+        OutBuffer out(sink);
+        write_all(out);
     }
 };
@@ -0,0 +1,87 @@
+// latency.h
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+// Log-linear latency histogram in nanoseconds: values are grouped by power of
+// two, and every power of two is split into 8 equal sub-buckets, so any
+// recorded value is reported within 12.5%. Fixed size, no allocation, and two
+// histograms merge by adding their counters.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 3;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BUCKETS = 64 * SUB;
+
+    static int bucket_of(uint64_t v) {
+        if (v < SUB) return (int)v;
+        int msb = 63 - __builtin_clzll(v);
+        int sub = (int)((v >> (msb - SUB_BITS)) & (SUB - 1));
+        return (msb - SUB_BITS + 1) * SUB + sub;
+    }
+
+    // exclusive upper edge of a bucket, used when reporting percentiles
+    static uint64_t bucket_high(int b) {
+        if (b < SUB) return (uint64_t)b + 1;
+        int msb = b / SUB + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(b % SUB);
+        return ((uint64_t)SUB + sub + 1) << (msb - SUB_BITS);
+    }
+
+private:
+    uint64_t counts[BUCKETS];
+    uint64_t n = 0;
+    uint64_t maxValue = 0;
+    uint64_t sum = 0;
+
+public:
+    LatencyHistogram() { clear(); }
+
+    void clear() {
+        memset(counts, 0, sizeof(counts));
+        n = 0; maxValue = 0; sum = 0;
+    }
+
+    void record(uint64_t ns) {
+        counts[bucket_of(ns)]++;
+        n++;
+        sum += ns;
+        if (ns > maxValue) maxValue = ns;
+    }
+
+    // adds counts gathered elsewhere in the same bucket layout (see metrics.h)
+    void add_bucket(int b, uint64_t c) { counts[b] += c; n += c; }
+    void add_totals(uint64_t sumNs, uint64_t maxNs) { sum += sumNs; maxValue = max(maxValue, maxNs); }
+
+    void merge(const LatencyHistogram& o) {
+        for (int i = 0; i < BUCKETS; ++i) counts[i] += o.counts[i];
+        n += o.n;
+        sum += o.sum;
+        maxValue = max(maxValue, o.maxValue);
+    }
+
+    uint64_t count() const { return n; }
+    uint64_t max_ns() const { return maxValue; }
+    double mean_ns() const { return n ? (double)sum / (double)n : 0.0; }
+
+    // p in [0,100]
+    uint64_t percentile(double p) const {
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)(n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return min(bucket_high(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    // calls f(lowNs, highNs, count) for every non-empty bucket
+    template<typename F>
+    void for_each_bucket(F f) const {
+        for (int i = 0; i < BUCKETS; ++i)
+            if (counts[i]) f(i == 0 ? 0 : bucket_high(i - 1), bucket_high(i), counts[i]);
+    }
+};
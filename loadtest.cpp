@@ -0,0 +1,122 @@
+// loadtest.cpp - load test for the engine server (server.h)
+//   g++ -std=c++17 -O2 -pthread -o loadtest.exe loadtest.cpp        (add -lws2_32 on Windows)
+//   .\loadtest.exe [ADDRESS] [--clients N] [--seconds S] [--depth D]
+//
+// Without ADDRESS an engine is started in this process on a local socket, so
+// the run measures the protocol and the engine rather than a remote setup.
+// Every client registers a walk-in customer and then sends pipelined batches
+// of D requests, cycling through a one-unit cart add, its remove and a product
+// lookup, so stock stays level however long it runs. A request's latency runs
+// from sending its batch to reading its reply.
+#include "server.h"
+#include "latency.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+struct LoadResult {
+    LatencyHistogram latency;
+    uint64_t requests = 0;
+    uint64_t errors = 0; // replies that were not Ok or came back out of order
+    string failure;      // connection problem, if any
+};
+
+static void run_client(const string& address, int index, int depth, chrono::steady_clock::time_point until, LoadResult& res) {
+    EngineClient cl;
+    if (!cl.connect(address, &res.failure)) return;
+    string cust = "LT" + to_string(index);
+    vector<string> barcodes;
+    for (size_t i = 0; i < 16; ++i) barcodes.push_back(string(DEFAULT_CATALOG[(index * 7 + i * 5) % size(DEFAULT_CATALOG)].barcode));
+
+    uint32_t id = cl.queue(ServerOp::AddCustomer, [&](WalBuffer& b) {
+        b.put_u8(0); b.put_str(cust); b.put_str("Load test " + to_string(index)); b.put_str(""); b.put_str(""); b.put_i32(0);
+    });
+    uint32_t gotId; Status s; WalCursor payload(nullptr, 0);
+    if (!cl.send() || !cl.reply(gotId, s, payload) || gotId != id) { res.failure = "lost connection while registering"; return; }
+
+    vector<uint32_t> ids(depth);
+    uint64_t step = 0;
+    while (chrono::steady_clock::now() < until) {
+        for (int i = 0; i < depth; ++i, ++step) {
+            // add a unit, put it back, look the product up: the shelf ends as it started
+            const string& bc = barcodes[(step / 3) % barcodes.size()];
+            if (step % 3 == 2) {
+                ids[i] = cl.queue(ServerOp::GetProduct, [&](WalBuffer& b) { b.put_str(bc); });
+            } else {
+                ServerOp op = step % 3 == 0 ? ServerOp::CartAdd : ServerOp::CartRemove;
+                ids[i] = cl.queue(op, [&](WalBuffer& b) { b.put_str(cust); b.put_str(bc); b.put_i32(1); });
+            }
+        }
+        auto sent = chrono::steady_clock::now();
+        if (!cl.send()) { res.failure = "send failed"; return; }
+        for (int i = 0; i < depth; ++i) {
+            if (!cl.reply(gotId, s, payload)) { res.failure = "lost connection"; return; }
+            res.latency.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - sent).count());
+            if (gotId != ids[i] || s != Status::Ok) res.errors++;
+            res.requests++;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    string address;
+    int clients = 8, depth = 32;
+    double seconds = 3.0;
+    for (int i = 1; i < argc; ++i) {
+        string k = argv[i];
+        if (k.rfind("--", 0) != 0) { address = k; continue; }
+        if (i + 1 >= argc) { cerr << "missing value for " << k << '\n'; return 1; }
+        if (k == "--clients") clients = max(1, atoi(argv[++i]));
+        else if (k == "--seconds") seconds = atof(argv[++i]);
+        else if (k == "--depth") depth = max(1, atoi(argv[++i]));
+        else { cerr << "usage: loadtest [ADDRESS] [--clients N] [--seconds S] [--depth D]\n"; return 1; }
+    }
+
+    unique_ptr<SupermarketSystem> sys;
+    unique_ptr<EngineServer> server;
+    thread serverThread;
+    if (address.empty()) {
+#ifdef _WIN32
+        address = "127.0.0.1:7171";
+#else
+        address = "loadtest.sock";
+#endif
+        sys = make_unique<SupermarketSystem>(3);
+        server = make_unique<EngineServer>(*sys);
+        string err;
+        if (!server->listen(address, &err)) { cerr << "Server: " << err << '\n'; return 1; }
+        serverThread = thread([&] { server->run(); });
+    }
+
+    auto until = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+    vector<LoadResult> results(clients);
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < clients; ++i) threads.emplace_back(run_client, address, i + 1, depth, until, ref(results[i]));
+    for (auto &t : threads) t.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    LoadResult total;
+    for (auto &r : results) {
+        total.latency.merge(r.latency);
+        total.requests += r.requests;
+        total.errors += r.errors;
+        if (!r.failure.empty()) cerr << "client: " << r.failure << '\n';
+    }
+    if (server) {
+        server->stop();
+        serverThread.join();
+        const ServerStats& s = server->stats();
+        cerr << "server: " << s.requests << " requests in " << s.batches << " batches, "
+             << s.bytesIn << " bytes in, " << s.bytesOut << " bytes out\n";
+    }
+
+    cout << "clients,depth,requests,errors,seconds,req_per_s,p50_us,p99_us,p999_us,max_us\n";
+    cout << clients << ',' << depth << ',' << total.requests << ',' << total.errors << ',' << elapsed << ','
+         << (uint64_t)(total.requests / max(elapsed, 1e-9)) << ','
+         << total.latency.percentile(50) / 1000.0 << ',' << total.latency.percentile(99) / 1000.0 << ','
+         << total.latency.percentile(99.9) / 1000.0 << ',' << total.latency.max_ns() / 1000.0 << '\n';
+    return total.errors == 0 && total.requests > 0 ? 0 : 1;
+}
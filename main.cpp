@@ -1,12 +1,70 @@
 // main.cpp - thin entrypoint
-#include "system.h"
+//   main.exe [--catalog FILE] [--export-catalog FILE] [--wal DIR] [--serve ADDRESS]
+//     --catalog         start from a CSV or .smc catalog instead of the built-in one
+//     --export-catalog  write the catalog (.smc = binary, else CSV) and exit
+//     --wal             log every change to DIR and recover from it on start
+//     --serve           serve the engine on a socket path or host:port (server.h)
+//                       instead of running the console
+#include "server.h"
 #include <iostream>
+#include <csignal>
 using namespace std;
 
-int main() {
+static EngineServer* activeServer = nullptr;
+static void stop_server(int) { if (activeServer) activeServer->stop(); }
+
+static int usage() {
+    cerr << "usage: main [--catalog FILE] [--export-catalog FILE] [--wal DIR] [--serve ADDRESS]\n";
+    return 1;
+}
+
+int main(int argc, char** argv) {
     SupermarketSystem sys(3);
+    string catalogPath, exportPath, walDir, serveAddress;
+    for (int i = 1; i < argc; i += 2) {
+        string k = argv[i];
+        if (i + 1 == argc) { cerr << "missing value for " << k << '\n'; return usage(); }
+        if (k == "--catalog") catalogPath = argv[i + 1];
+        else if (k == "--export-catalog") exportPath = argv[i + 1];
+        else if (k == "--wal") walDir = argv[i + 1];
+        else if (k == "--serve") serveAddress = argv[i + 1];
+        else { cerr << "unknown option " << k << '\n'; return usage(); }
+    }
+    if (!catalogPath.empty()) {
+        CatalogLoadStats st; string err;
+        if (!sys.import_catalog(catalogPath, st, true, &err)) { cerr << "Catalog: " << err << '\n'; return 1; }
+        cout << "Loaded " << st.loaded << " of " << st.rows << " products in " << st.millis << " ms ("
+             << st.duplicates << " duplicates, " << st.rejected << " rejected)\n";
+        for (auto &p : st.problems) cout << "  " << p << '\n';
+    }
+    if (!exportPath.empty()) {
+        if (!sys.export_catalog(exportPath)) { cerr << "Cannot write " << exportPath << '\n'; return 1; }
+        cout << "Catalog written to " << exportPath << '\n';
+        return 0;
+    }
+    if (!walDir.empty()) {
+        RecoveryStats st; string err;
+        if (!sys.open_wal(walDir, WalOptions(), &st, &err)) { cerr << "Write-ahead log: " << err << '\n'; return 1; }
+        if (st.fromSnapshot)
+            cout << "Recovered " << st.sales << " sales (" << st.recordsReplayed << " log records, "
+                 << st.unitsReturned << " units back from open carts) in " << st.millis << " ms\n";
+    }
+    if (!serveAddress.empty()) {
+        EngineServer server(sys);
+        string err;
+        if (!server.listen(serveAddress, &err)) { cerr << "Server: " << err << '\n'; return 1; }
+        activeServer = &server;
+        signal(SIGINT, stop_server);
+        signal(SIGTERM, stop_server);
+        cout << "Serving on " << serveAddress << " (Ctrl+C to stop)" << endl;
+        server.run();
+        activeServer = nullptr;
+        const ServerStats& s = server.stats();
+        cout << "Server stopped: " << s.connections << " connections, " << s.requests << " requests in "
+             << s.batches << " batches\n";
+        return 0;
+    }
     cout << "Supermarket sys started.\n";
     sys.interactive_console();
     return 0;
 }
-
@@ -0,0 +1,101 @@
+// memory.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <algorithm>
+using namespace std;
+
+// Heap accounting for the engine's structures. bytes is what a structure has
+// allocated; overhead is the part of it that holds no data: allocator headers
+// and rounding, node links, hash buckets, spare capacity and blocks kept for
+// reuse. Nothing is measured at run time; sizes follow a typical 64-bit malloc
+// (an 8-byte header, 16-byte granules, 32 bytes at least), so figures compare
+// across structures and runs rather than match the allocator to the byte.
+struct MemoryUsage {
+    string name;
+    size_t elements = 0;
+    size_t bytes = 0;
+    size_t overhead = 0;
+
+    MemoryUsage() = default;
+    explicit MemoryUsage(const string& n) : name(n) {}
+
+    // allocated bytes of which payload hold data
+    void add(size_t payload, size_t allocated) {
+        bytes += allocated;
+        overhead += allocated - min(payload, allocated);
+    }
+    void merge(const MemoryUsage& o) { elements += o.elements; bytes += o.bytes; overhead += o.overhead; }
+    double overhead_percent() const { return bytes ? 100.0 * overhead / bytes : 0.0; }
+};
+
+// what malloc(n) really takes
+inline size_t heap_block(size_t n) {
+    return n == 0 ? 0 : max<size_t>(32, (n + 8 + 15) & ~size_t(15));
+}
+
+// one allocation per element, each holding payload bytes of a node of nodeBytes
+inline void account_nodes(MemoryUsage& m, size_t count, size_t payload, size_t nodeBytes) {
+    m.add(count * payload, count * heap_block(nodeBytes));
+}
+
+// a string's characters; nothing while they fit its inline buffer
+inline void account_string(MemoryUsage& m, const string& s) {
+    const char* d = s.data();
+    if (d >= (const char*)&s && d < (const char*)&s + sizeof(s)) return;
+    m.add(s.size(), heap_block(s.capacity() + 1));
+}
+
+template<typename T> void account_vector(MemoryUsage& m, const vector<T>& v) {
+    m.add(v.size() * sizeof(T), heap_block(v.capacity() * sizeof(T)));
+}
+
+// unordered_map / unordered_set: the bucket array and one node per element
+// (the value, a next link and the cached hash); keys' and values' own heap is
+// up to the caller
+template<typename H> void account_hash(MemoryUsage& m, const H& h) {
+    typedef typename H::value_type V;
+    m.add(0, heap_block(h.bucket_count() * sizeof(void*)));
+    account_nodes(m, h.size(), sizeof(V), sizeof(V) + 2 * sizeof(void*));
+}
+
+struct MemoryReport {
+    vector<MemoryUsage> parts;
+
+    MemoryUsage total() const {
+        MemoryUsage t("total");
+        for (auto &p : parts) t.merge(p);
+        return t;
+    }
+};
+
+inline void print_memory_table(ostream& os, const MemoryReport& r) {
+    char row[160];
+    snprintf(row, sizeof(row), "%-20s %12s %14s %14s %9s\n", "structure", "elements", "bytes", "overhead", "overhead%");
+    os << row;
+    auto line = [&](const MemoryUsage& u) {
+        snprintf(row, sizeof(row), "%-20s %12zu %14zu %14zu %8.1f%%\n", u.name.c_str(), u.elements, u.bytes,
+                 u.overhead, u.overhead_percent());
+        os << row;
+    };
+    for (auto &p : r.parts) line(p);
+    line(r.total());
+}
+
+inline void write_memory_json(ostream& os, const MemoryReport& r) {
+    auto obj = [&](const MemoryUsage& u) {
+        os << "{\"name\":\"" << u.name << "\",\"elements\":" << u.elements << ",\"bytes\":" << u.bytes
+           << ",\"overhead\":" << u.overhead << '}';
+    };
+    os << "{\"structures\":[";
+    for (size_t i = 0; i < r.parts.size(); ++i) {
+        os << (i ? "," : "") << "\n  ";
+        obj(r.parts[i]);
+    }
+    os << "\n],\"total\":";
+    obj(r.total());
+    os << "}\n";
+}
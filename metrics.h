@@ -0,0 +1,191 @@
+// metrics.h
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <ostream>
+#include <cstdio>
+#include "latency.h"
+using namespace std;
+
+// Hot-path instrumentation: per-operation call counters and latency
+// histograms. Each thread writes only its own block (relaxed single-writer
+// atomics, so no locked instructions); readers sum all blocks. Build with
+// -DSUPERMARKET_NO_METRICS to compile every probe down to nothing.
+enum class Metric {
+    CartAdd,
+    CartUndo,
+    OnlineOrder,
+    CheckoutCashier,
+    CheckoutSpecial,
+    CheckoutOnline,
+    RebuildBst,
+    TallyProducts,
+    InventoryFind,
+    WaveBuild,
+    WaveCommit,
+    StockAudit,
+    ScanBatch,
+    COUNT
+};
+
+inline const char* metric_name(Metric m) {
+    static const char* names[] = {"cart_add", "cart_undo", "online_order", "checkout_cashier", "checkout_special",
+                                  "checkout_online", "rebuild_bst", "tally_products", "inventory_find",
+                                  "wave_build", "wave_commit", "stock_audit", "scan_batch"};
+    return names[(int)m];
+}
+
+const int METRIC_COUNT = (int)Metric::COUNT;
+
+struct MetricsBlock {
+    atomic<uint64_t> calls[METRIC_COUNT];
+    atomic<uint64_t> sumNs[METRIC_COUNT];
+    atomic<uint64_t> maxNs[METRIC_COUNT];
+    atomic<uint64_t> buckets[METRIC_COUNT][LatencyHistogram::BUCKETS];
+
+    MetricsBlock() {
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            calls[m] = 0; sumNs[m] = 0; maxNs[m] = 0;
+            for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) buckets[m][b] = 0;
+        }
+    }
+};
+
+// only the owning thread writes, so load + store is enough
+inline void metric_bump(atomic<uint64_t>& a, uint64_t by = 1) {
+    a.store(a.load(memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+class MetricsRegistry {
+private:
+    mutex lock;
+    vector<unique_ptr<MetricsBlock>> blocks; // kept after threads exit so their counts still add up
+
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry r;
+        return r;
+    }
+
+    MetricsBlock* new_block() {
+        lock_guard<mutex> g(lock);
+        blocks.push_back(make_unique<MetricsBlock>());
+        return blocks.back().get();
+    }
+
+    static MetricsBlock& local() {
+        thread_local MetricsBlock* mine = instance().new_block();
+        return *mine;
+    }
+
+    struct Summary {
+        Metric metric;
+        uint64_t calls;
+        LatencyHistogram latency; // over the timed calls only
+    };
+
+    vector<Summary> snapshot() {
+        vector<Summary> out;
+        lock_guard<mutex> g(lock);
+        for (int m = 0; m < METRIC_COUNT; ++m) {
+            Summary s;
+            s.metric = (Metric)m;
+            s.calls = 0;
+            for (auto &b : blocks) {
+                s.calls += b->calls[m].load(memory_order_relaxed);
+                for (int k = 0; k < LatencyHistogram::BUCKETS; ++k) {
+                    uint64_t c = b->buckets[m][k].load(memory_order_relaxed);
+                    if (c) s.latency.add_bucket(k, c);
+                }
+                s.latency.add_totals(b->sumNs[m].load(memory_order_relaxed), b->maxNs[m].load(memory_order_relaxed));
+            }
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    void reset() {
+        lock_guard<mutex> g(lock);
+        for (auto &b : blocks) {
+            for (int m = 0; m < METRIC_COUNT; ++m) {
+                b->calls[m] = 0; b->sumNs[m] = 0; b->maxNs[m] = 0;
+                for (int k = 0; k < LatencyHistogram::BUCKETS; ++k) b->buckets[m][k] = 0;
+            }
+        }
+    }
+};
+
+// Counts every call; times one call in `sampleEvery` (1 = all of them) so very
+// cheap operations like Inventory::find don't pay two clock reads each.
+class MetricScope {
+private:
+    MetricsBlock& block;
+    int m;
+    bool timing;
+    chrono::steady_clock::time_point start;
+
+public:
+    MetricScope(Metric metric, uint64_t sampleEvery = 1) : block(MetricsRegistry::local()), m((int)metric) {
+        uint64_t n = block.calls[m].load(memory_order_relaxed);
+        block.calls[m].store(n + 1, memory_order_relaxed);
+        timing = sampleEvery <= 1 || n % sampleEvery == 0;
+        if (timing) start = chrono::steady_clock::now();
+    }
+    ~MetricScope() {
+        if (!timing) return;
+        uint64_t ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        metric_bump(block.sumNs[m], ns);
+        metric_bump(block.buckets[m][LatencyHistogram::bucket_of(ns)]);
+        if (ns > block.maxNs[m].load(memory_order_relaxed)) block.maxNs[m].store(ns, memory_order_relaxed);
+    }
+};
+
+#define METRIC_CONCAT_(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_(a, b)
+#ifdef SUPERMARKET_NO_METRICS
+#define METRIC_SCOPE(m) ((void)0)
+#define METRIC_SCOPE_SAMPLED(m, every) ((void)0)
+const bool METRICS_ENABLED = false;
+#else
+#define METRIC_SCOPE(m) MetricScope METRIC_CONCAT(metricScope_, __LINE__)(m)
+#define METRIC_SCOPE_SAMPLED(m, every) MetricScope METRIC_CONCAT(metricScope_, __LINE__)(m, every)
+const bool METRICS_ENABLED = true;
+#endif
+
+inline void print_metrics_table(ostream& os) {
+    if (!METRICS_ENABLED) { os << "Metrics are compiled out (SUPERMARKET_NO_METRICS)\n"; return; }
+    char row[160];
+    snprintf(row, sizeof(row), "%-18s %12s %10s %10s %10s %10s\n", "operation", "calls", "mean_ns", "p50_ns", "p99_ns", "max_ns");
+    os << row;
+    for (auto &s : MetricsRegistry::instance().snapshot()) {
+        snprintf(row, sizeof(row), "%-18s %12llu %10llu %10llu %10llu %10llu\n", metric_name(s.metric),
+                 (unsigned long long)s.calls, (unsigned long long)s.latency.mean_ns(),
+                 (unsigned long long)s.latency.percentile(50), (unsigned long long)s.latency.percentile(99),
+                 (unsigned long long)s.latency.max_ns());
+        os << row;
+    }
+}
+
+inline void write_metrics_json(ostream& os) {
+    os << "{\"enabled\":" << (METRICS_ENABLED ? "true" : "false") << ",\"operations\":[";
+    bool first = true;
+    for (auto &s : MetricsRegistry::instance().snapshot()) {
+        if (!METRICS_ENABLED) break;
+        os << (first ? "" : ",") << "\n  {\"name\":\"" << metric_name(s.metric) << "\",\"calls\":" << s.calls
+           << ",\"timed\":" << s.latency.count() << ",\"mean_ns\":" << (uint64_t)s.latency.mean_ns()
+           << ",\"p50_ns\":" << s.latency.percentile(50) << ",\"p90_ns\":" << s.latency.percentile(90)
+           << ",\"p99_ns\":" << s.latency.percentile(99) << ",\"max_ns\":" << s.latency.max_ns() << ",\"buckets\":[";
+        bool firstBucket = true;
+        s.latency.for_each_bucket([&](uint64_t lo, uint64_t hi, uint64_t n) {
+            os << (firstBucket ? "" : ",") << '[' << lo << ',' << hi << ',' << n << ']';
+            firstBucket = false;
+        });
+        os << "]}";
+        first = false;
+    }
+    os << "\n]}\n";
+}
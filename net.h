@@ -0,0 +1,190 @@
+// net.h
+#pragma once
+// Include this before system.h: on Windows winsock2.h has to come before windows.h.
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include "output.h"
+using namespace std;
+
+// Thin socket layer shared by the engine server and its clients. An address is
+// either a filesystem path (Unix domain socket) or "host:port" (TCP, meant for
+// 127.0.0.1). Windows builds link with -lws2_32 and only take host:port, which
+// is also what Python's socket module offers there.
+#ifdef _WIN32
+typedef SOCKET sock_t;
+const sock_t BAD_SOCKET = INVALID_SOCKET;
+typedef WSAPOLLFD net_pollfd;
+inline int net_poll(net_pollfd* fds, size_t n, int ms) { return WSAPoll(fds, (ULONG)n, ms); }
+inline void net_close(sock_t s) { closesocket(s); }
+inline bool net_would_block() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+inline string net_error() { return "socket error " + to_string(WSAGetLastError()); }
+#else
+typedef int sock_t;
+const sock_t BAD_SOCKET = -1;
+typedef pollfd net_pollfd;
+inline int net_poll(net_pollfd* fds, size_t n, int ms) { return ::poll(fds, (nfds_t)n, ms); }
+inline void net_close(sock_t s) { ::close(s); }
+inline bool net_would_block() { return errno == EAGAIN || errno == EWOULDBLOCK; }
+inline string net_error() { return strerror(errno); }
+#endif
+
+// WSAStartup once per process; a no-op elsewhere
+inline bool net_init() {
+#ifdef _WIN32
+    static bool ok = [] { WSADATA d; return WSAStartup(MAKEWORD(2, 2), &d) == 0; }();
+    return ok;
+#else
+    return true;
+#endif
+}
+
+inline bool net_set_nonblocking(sock_t s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int fl = fcntl(s, F_GETFL, 0);
+    return fl >= 0 && fcntl(s, F_SETFL, fl | O_NONBLOCK) == 0;
+#endif
+}
+
+inline long net_send(sock_t s, const char* p, size_t n) {
+#if defined(_WIN32)
+    return ::send(s, p, (int)min(n, (size_t)1 << 30), 0);
+#elif defined(MSG_NOSIGNAL)
+    return ::send(s, p, n, MSG_NOSIGNAL); // a vanished peer must not kill the server
+#else
+    return ::send(s, p, n, 0);
+#endif
+}
+
+inline long net_recv(sock_t s, char* p, size_t n) {
+#ifdef _WIN32
+    return ::recv(s, p, (int)min(n, (size_t)1 << 30), 0);
+#else
+    return ::recv(s, p, n, 0);
+#endif
+}
+
+// "host:port" -> TCP; anything else is a socket path
+inline bool net_is_tcp(const string& address, string& host, int& port) {
+    size_t colon = address.rfind(':');
+    if (colon == string::npos || colon + 1 >= address.size()) return false;
+    for (size_t i = colon + 1; i < address.size(); ++i) if (address[i] < '0' || address[i] > '9') return false;
+    host = colon == 0 ? string("127.0.0.1") : address.substr(0, colon);
+    port = atoi(address.c_str() + colon + 1);
+    return true;
+}
+
+// sockaddr for address; len is set to the bytes actually used
+inline bool net_sockaddr(const string& address, sockaddr_storage& sa, socklen_t& len, string* err) {
+    memset(&sa, 0, sizeof(sa));
+    string host; int port = 0;
+    if (net_is_tcp(address, host, port)) {
+        if (host == "localhost") host = "127.0.0.1";
+        sockaddr_in* in = (sockaddr_in*)&sa;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        if (inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1) { if (err) *err = "bad IPv4 address " + host; return false; }
+        len = sizeof(sockaddr_in);
+        return true;
+    }
+#ifdef _WIN32
+    if (err) *err = "Unix sockets are not supported on Windows; use 127.0.0.1:PORT";
+    return false;
+#else
+    sockaddr_un* un = (sockaddr_un*)&sa;
+    if (address.empty() || address.size() >= sizeof(un->sun_path)) { if (err) *err = "bad socket path " + address; return false; }
+    un->sun_family = AF_UNIX;
+    memcpy(un->sun_path, address.data(), address.size());
+    len = (socklen_t)(offsetof(sockaddr_un, sun_path) + address.size() + 1);
+    return true;
+#endif
+}
+
+// TCP_NODELAY: replies are already coalesced, so Nagle only adds latency
+inline void net_no_delay(sock_t s, const sockaddr_storage& sa) {
+    if (sa.ss_family != AF_INET) return;
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+}
+
+inline sock_t net_listen(const string& address, string* err = nullptr) {
+    if (!net_init()) { if (err) *err = "WSAStartup failed"; return BAD_SOCKET; }
+    sockaddr_storage sa; socklen_t len = 0;
+    if (!net_sockaddr(address, sa, len, err)) return BAD_SOCKET;
+    sock_t s = ::socket(sa.ss_family, SOCK_STREAM, 0);
+    if (s == BAD_SOCKET) { if (err) *err = net_error(); return BAD_SOCKET; }
+    if (sa.ss_family == AF_INET) {
+        int on = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+    }
+#ifndef _WIN32
+    else ::unlink(address.c_str()); // a stale socket file from an earlier run
+#endif
+    if (::bind(s, (sockaddr*)&sa, len) != 0 || ::listen(s, 128) != 0 || !net_set_nonblocking(s)) {
+        if (err) *err = "cannot listen on " + address + ": " + net_error();
+        net_close(s);
+        return BAD_SOCKET;
+    }
+    return s;
+}
+
+// blocking client connection
+inline sock_t net_connect(const string& address, string* err = nullptr) {
+    if (!net_init()) { if (err) *err = "WSAStartup failed"; return BAD_SOCKET; }
+    sockaddr_storage sa; socklen_t len = 0;
+    if (!net_sockaddr(address, sa, len, err)) return BAD_SOCKET;
+    sock_t s = ::socket(sa.ss_family, SOCK_STREAM, 0);
+    if (s == BAD_SOCKET) { if (err) *err = net_error(); return BAD_SOCKET; }
+    if (::connect(s, (sockaddr*)&sa, len) != 0) {
+        if (err) *err = "cannot connect to " + address + ": " + net_error();
+        net_close(s);
+        return BAD_SOCKET;
+    }
+    net_no_delay(s, sa);
+    return s;
+}
+
+inline bool net_send_all(sock_t s, const char* p, size_t n) {
+    while (n > 0) {
+        long w = net_send(s, p, n);
+        if (w <= 0) return false;
+        p += w; n -= (size_t)w;
+    }
+    return true;
+}
+
+// listings, reports and receipts (output.h) to a blocking socket, a chunk per send
+inline OutputSink socket_sink(sock_t s) {
+    return [s](const char* p, size_t n) { return net_send_all(s, p, n); };
+}
+
+inline bool net_recv_all(sock_t s, char* p, size_t n) {
+    while (n > 0) {
+        long r = net_recv(s, p, n);
+        if (r <= 0) return false;
+        p += r; n -= (size_t)r;
+    }
+    return true;
+}
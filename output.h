@@ -0,0 +1,198 @@
+// output.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+using namespace std;
+
+// Text output for listings, reports and receipts. Rows are formatted into a
+// reusable buffer (numbers with to_chars, no locale, no stream state) and
+// handed to the sink in large chunks, so dumping a big catalog or a day's
+// sales is a few hundred writes instead of millions of operator<< calls.
+
+// where formatted text goes; returns false once the sink has failed
+typedef function<bool(const char*, size_t)> OutputSink;
+
+inline OutputSink stream_sink(ostream& os) {
+    return [&os](const char* p, size_t n) { os.write(p, (streamsize)n); return (bool)os; };
+}
+inline OutputSink file_sink(FILE* f) {
+    return [f](const char* p, size_t n) { return fwrite(p, 1, n, f) == n; };
+}
+// the console; text already sent through cout stays in order
+inline const OutputSink& console_sink() {
+    static const OutputSink s = [](const char* p, size_t n) { cout.write(p, (streamsize)n); return (bool)cout; };
+    return s;
+}
+
+// LE amounts, shown with two decimals
+struct Money { double le; };
+// exact amounts kept in piasters (report.h)
+struct Piasters { long long p; };
+
+class OutBuffer {
+public:
+    static const size_t CHUNK = 64 * 1024; // flushed to the sink at this size
+
+private:
+    // buffers go back to a per-thread pool, so a listing allocates nothing once warm
+    static vector<vector<char>>& pool() {
+        static thread_local vector<vector<char>> p;
+        return p;
+    }
+
+    OutputSink sink;
+    vector<char> buf;
+    size_t used = 0;
+    bool ok = true;
+
+    char* room(size_t n) {
+        if (used + n > buf.size()) {
+            if (used >= CHUNK) flush();
+            if (used + n > buf.size()) buf.resize(max(buf.size() * 2, used + n));
+        }
+        return buf.data() + used;
+    }
+
+public:
+    explicit OutBuffer(OutputSink s) : sink(move(s)) {
+        if (!pool().empty()) { buf = move(pool().back()); pool().pop_back(); }
+        if (buf.size() < CHUNK + 256) buf.resize(CHUNK + 256);
+    }
+    OutBuffer(const OutBuffer&) = delete;
+    OutBuffer& operator=(const OutBuffer&) = delete;
+    ~OutBuffer() {
+        flush();
+        pool().push_back(move(buf));
+    }
+
+    void flush() {
+        if (used == 0) return;
+        if (ok) ok = sink(buf.data(), used);
+        used = 0;
+    }
+    bool good() const { return ok; }
+
+    OutBuffer& text(string_view s) {
+        char* p = room(s.size());
+        if (!s.empty()) memcpy(p, s.data(), s.size());
+        used += s.size();
+        if (used >= CHUNK) flush();
+        return *this;
+    }
+    OutBuffer& ch(char c) {
+        *room(1) = c;
+        if (++used >= CHUNK) flush();
+        return *this;
+    }
+    OutBuffer& num(long long v) {
+        char* p = room(24);
+        used = to_chars(p, p + 24, v).ptr - buf.data();
+        return *this;
+    }
+    // like ostream's default for doubles: six significant digits
+    OutBuffer& real(double v) {
+        char* p = room(32);
+        used = to_chars(p, p + 32, v, chars_format::general, 6).ptr - buf.data();
+        return *this;
+    }
+    OutBuffer& money(Piasters v) {
+        long long p = v.p < 0 ? -v.p : v.p;
+        if (v.p < 0) ch('-');
+        num(p / 100).ch('.');
+        int c = (int)(p % 100);
+        return ch((char)('0' + c / 10)).ch((char)('0' + c % 10));
+    }
+    OutBuffer& money(Money v) { return money(Piasters{llround(v.le * 100.0)}); }
+};
+
+// One value for a template slot; built implicitly from what the rows hold.
+struct Field {
+    enum Kind : uint8_t { Text, Int, Real, Amount };
+    Kind kind;
+    string_view s;
+    long long i = 0;
+    double d = 0;
+
+    Field(string_view v) : kind(Text), s(v) {}
+    Field(const string& v) : kind(Text), s(v) {}
+    Field(const char* v) : kind(Text), s(v) {}
+    Field(int v) : kind(Int), i(v) {}
+    Field(long v) : kind(Int), i(v) {}
+    Field(long long v) : kind(Int), i(v) {}
+    Field(unsigned v) : kind(Int), i(v) {}
+    Field(unsigned long v) : kind(Int), i((long long)v) {}
+    Field(unsigned long long v) : kind(Int), i((long long)v) {}
+    Field(double v) : kind(Real), d(v) {}
+    Field(Money v) : kind(Amount), i(llround(v.le * 100.0)) {}
+    Field(Piasters v) : kind(Amount), i(v.p) {}
+
+    void write(OutBuffer& out) const {
+        switch (kind) {
+            case Text: out.text(s); break;
+            case Int: out.num(i); break;
+            case Real: out.real(d); break;
+            case Amount: out.money(Piasters{i}); break;
+        }
+    }
+};
+
+// A row layout parsed once: literal text with {0}, {1}, ... slots. Rendering
+// copies the literals and formats the fields, with no parsing per row.
+class LineTemplate {
+private:
+    struct Piece { uint32_t at, len; int slot; }; // slot -1: literal text[at, at + len)
+    string layout;
+    vector<Piece> pieces;
+
+public:
+    explicit LineTemplate(string l) : layout(move(l)) {
+        size_t lit = 0;
+        for (size_t i = 0; i < layout.size(); ++i) {
+            if (layout[i] != '{') continue;
+            size_t close = layout.find('}', i);
+            if (close == string::npos || close == i + 1) continue;
+            int slot = 0;
+            bool digits = true;
+            for (size_t j = i + 1; j < close; ++j) {
+                if (layout[j] < '0' || layout[j] > '9') { digits = false; break; }
+                slot = slot * 10 + (layout[j] - '0');
+            }
+            if (!digits) continue;
+            if (i > lit) pieces.push_back(Piece{(uint32_t)lit, (uint32_t)(i - lit), -1});
+            pieces.push_back(Piece{0, 0, slot});
+            lit = close + 1;
+            i = close;
+        }
+        if (lit < layout.size()) pieces.push_back(Piece{(uint32_t)lit, (uint32_t)(layout.size() - lit), -1});
+    }
+
+    // slots without a field are left empty
+    void render(OutBuffer& out, initializer_list<Field> fields) const {
+        const Field* f = fields.begin();
+        for (const Piece& p : pieces) {
+            if (p.slot < 0) out.text(string_view(layout.data() + p.at, p.len));
+            else if ((size_t)p.slot < fields.size()) f[p.slot].write(out);
+        }
+    }
+};
+
+// Rows [first, first + count) of a listing. Callers walk every row but format
+// only the ones in the window, so a page of a large listing costs one page.
+struct RowWindow {
+    size_t first = 0;
+    size_t count = SIZE_MAX;
+
+    bool shows(size_t row) const { return row >= first && row - first < count; }
+    // every later row is outside the window too
+    bool done(size_t row) const { return row >= first && row - first >= count; }
+};
@@ -57,6 +57,23 @@ class MyPriorityQueue {
             }
             return head->data;
         }
+        // visits in pop order without popping
+        template<typename F>
+        void for_each(F f) const {
+            for (Node* current = head; current != nullptr; current = current->next) f(current->data);
+        }
+        // drops every element pred accepts; returns how many went
+        template<typename F>
+        size_t remove_if(F pred) {
+            size_t removed = 0;
+            Node** link = &head;
+            while (*link != nullptr) {
+                Node* current = *link;
+                if (pred(current->data)) { *link = current->next; delete current; removed++; }
+                else link = &current->next;
+            }
+            return removed;
+        }
         size_t size() const {
             size_t count = 0;
             Node* current = head;
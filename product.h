@@ -2,6 +2,7 @@
 #pragma once
 #include <string>
 #include <utility>
+#include "memory.h"
 using namespace std;
 //adding product category
 struct Product {
@@ -29,3 +30,11 @@ struct Product {
         category = move(c);
     }
 };
+
+// heap behind a product's text; the Product itself is up to whoever holds it
+inline void account_product(MemoryUsage& m, const Product& p) {
+    account_string(m, p.barcode);
+    account_string(m, p.name);
+    account_string(m, p.category);
+    account_string(m, p.expiry);
+}
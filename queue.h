@@ -28,6 +28,8 @@ class MyQueue {
         bool isEmpty() const {
             return frontNode == nullptr;
         }
+        // one allocation of this size per element
+        static size_t node_bytes() { return sizeof(Node); }
         void enqueue(const T& val) {
             Node* newNode = new Node(val);
             if (isEmpty()) {
@@ -65,6 +67,28 @@ class MyQueue {
             }
             return count;
         }
+        // visits front to back without dequeuing
+        template<typename F>
+        void for_each(F f) const {
+            for (Node* current = frontNode; current != nullptr; current = current->next) f(current->data);
+        }
+        // drops every element pred accepts, keeping the order of the rest; returns how many went
+        template<typename F>
+        size_t remove_if(F pred) {
+            size_t removed = 0;
+            Node* prev = nullptr;
+            for (Node* current = frontNode; current != nullptr;) {
+                Node* next = current->next;
+                if (pred(current->data)) {
+                    if (prev) prev->next = next; else frontNode = next;
+                    if (rearNode == current) rearNode = prev;
+                    delete current;
+                    removed++;
+                } else prev = current;
+                current = next;
+            }
+            return removed;
+        }
         T& back() {
             if (isEmpty()) {
                 throw runtime_error("Queue is empty. No back element.");
@@ -0,0 +1,254 @@
+// replay.cpp - drives SupermarketSystem from a command trace and reports numbers
+//   g++ -std=c++17 -O2 -pthread -o replay.exe replay.cpp
+//   .\replay.exe gen [--catalog N] [--customers-per-hour N] [--hours N] [--basket-mean N]
+//                    [--online-share F] [--cashiers N] [--seed N] > day.trace
+//   .\replay.exe run day.trace [--histogram] [--metrics metrics.json]
+//
+// Trace format: one command per line, fields separated by spaces, '#' starts a comment.
+//   K <cashiers>                          lane count (first command)
+//   P <barcode> <name> <price> <stock> <category>
+//   W|S <custId> <name>                   walk-in / special-needs arrival
+//   O <custId> <name> <priority>          online customer
+//   A|R <custId> <barcode> <qty>          cart add / remove
+//   U <custId>                            undo last cart action
+//   Q <custId>                            join a cashier queue
+//   N <custId>                            place online order
+//   C <cashierIndex> [coupon]             checkout at a regular cashier
+//   X [coupon]                            checkout at the special-needs cashier
+//   L [coupon]                            process next online order
+//   B <cashierIndex>                      undo last bill at a cashier
+//   E <custId> [1]                        end the visit, cart back to the shelf (1: forget the customer)
+#include "system.h"
+#include "latency.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+using namespace std;
+
+enum ReplayOp { OP_PRODUCT, OP_WALKIN, OP_SPECIAL, OP_ONLINE_CUSTOMER, OP_ADD, OP_REMOVE, OP_UNDO, OP_ENQUEUE,
+                OP_ORDER, OP_CHECKOUT, OP_SPECIAL_CHECKOUT, OP_ONLINE_CHECKOUT, OP_UNDO_BILL, OP_END_SESSION, OP_COUNT };
+
+static const char* op_name(int op) {
+    static const char* names[OP_COUNT] = {"product", "walkin", "special", "online_customer", "cart_add", "cart_remove",
+                                          "cart_undo", "enqueue", "online_order", "checkout", "special_checkout",
+                                          "online_checkout", "undo_bill", "end_session"};
+    return names[op];
+}
+
+struct ReplayCommand {
+    ReplayOp op;
+    string a, b, c;   // ids / names / coupon, depending on op
+    int n = 0;        // qty, cashier index or priority
+    double price = 0;
+    int stock = 0;
+};
+
+static bool parse_trace(istream& in, vector<ReplayCommand>& out, int& cashiers, string& err) {
+    string line;
+    size_t lineNo = 0;
+    while (getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#') continue;
+        istringstream ss(line);
+        string tag;
+        ss >> tag;
+        ReplayCommand c;
+        bool ok = true;
+        if (tag == "K") { ok = (bool)(ss >> cashiers); if (ok) continue; }
+        else if (tag == "P") { c.op = OP_PRODUCT; ok = (bool)(ss >> c.a >> c.b >> c.price >> c.stock >> c.c); }
+        else if (tag == "W") { c.op = OP_WALKIN; ok = (bool)(ss >> c.a >> c.b); }
+        else if (tag == "S") { c.op = OP_SPECIAL; ok = (bool)(ss >> c.a >> c.b); }
+        else if (tag == "O") { c.op = OP_ONLINE_CUSTOMER; ok = (bool)(ss >> c.a >> c.b >> c.n); }
+        else if (tag == "A") { c.op = OP_ADD; ok = (bool)(ss >> c.a >> c.b >> c.n); }
+        else if (tag == "R") { c.op = OP_REMOVE; ok = (bool)(ss >> c.a >> c.b >> c.n); }
+        else if (tag == "U") { c.op = OP_UNDO; ok = (bool)(ss >> c.a); }
+        else if (tag == "Q") { c.op = OP_ENQUEUE; ok = (bool)(ss >> c.a); }
+        else if (tag == "N") { c.op = OP_ORDER; ok = (bool)(ss >> c.a); }
+        else if (tag == "C") { c.op = OP_CHECKOUT; ok = (bool)(ss >> c.n); ss >> c.c; }
+        else if (tag == "X") { c.op = OP_SPECIAL_CHECKOUT; ss >> c.c; }
+        else if (tag == "L") { c.op = OP_ONLINE_CHECKOUT; ss >> c.c; }
+        else if (tag == "B") { c.op = OP_UNDO_BILL; ok = (bool)(ss >> c.n); }
+        else if (tag == "E") { c.op = OP_END_SESSION; ok = (bool)(ss >> c.a); ss >> c.n; }
+        else ok = false;
+        if (!ok) { err = "bad trace line " + to_string(lineNo) + ": " + line; return false; }
+        out.push_back(c);
+    }
+    return true;
+}
+
+// returns true if the engine accepted the command
+static bool execute(SupermarketSystem& sys, const ReplayCommand& c) {
+    switch (c.op) {
+        case OP_PRODUCT: return sys.add_product(Product(c.a, c.b, c.price, c.stock, "2030-01-01", c.c)) == Status::Ok;
+        case OP_WALKIN: return sys.add_walkin_customer(c.a, c.b) == Status::Ok;
+        case OP_SPECIAL: return sys.add_special_customer(c.a, c.b) == Status::Ok;
+        case OP_ONLINE_CUSTOMER: return sys.add_online_customer(c.a, c.b, "-", "card", c.n) == Status::Ok;
+        case OP_ADD: return sys.customer_add_to_cart(c.a, c.b, c.n).status == Status::Ok;
+        case OP_REMOVE: return sys.customer_remove_from_cart(c.a, c.b, c.n).status == Status::Ok;
+        case OP_UNDO: return sys.customer_undo(c.a).status == Status::Ok;
+        case OP_ENQUEUE: return sys.enqueue_walkin_to_cashier(c.a).status == Status::Ok;
+        case OP_ORDER: return sys.place_online_order(c.a).status == Status::Ok;
+        case OP_CHECKOUT: return sys.process_checkout_at_cashier(c.n, c.c).status == Status::Ok;
+        case OP_SPECIAL_CHECKOUT: return sys.process_checkout_at_specialneedscashier(c.c).status == Status::Ok;
+        case OP_ONLINE_CHECKOUT: return sys.process_next_online_order(c.c).status == Status::Ok;
+        case OP_UNDO_BILL: return sys.cashier_undo_last_bill(c.n).status == Status::Ok;
+        case OP_END_SESSION: return sys.end_session(c.a, c.n != 0).status == Status::Ok;
+        default: return false;
+    }
+}
+
+static int run_trace(const string& path, bool histogram, const string& metricsPath) {
+    ifstream in(path);
+    if (!in) { cerr << "cannot open " << path << '\n'; return 1; }
+    vector<ReplayCommand> cmds;
+    int cashiers = 3;
+    string err;
+    if (!parse_trace(in, cmds, cashiers, err)) { cerr << err << '\n'; return 1; }
+
+    SupermarketSystem sys(cashiers);
+    LatencyHistogram hist[OP_COUNT];
+    size_t rejected[OP_COUNT] = {0};
+    auto start = chrono::steady_clock::now();
+    for (const ReplayCommand& c : cmds) {
+        auto t0 = chrono::steady_clock::now();
+        bool ok = execute(sys, c);
+        auto t1 = chrono::steady_clock::now();
+        hist[c.op].record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+        if (!ok) rejected[c.op]++;
+    }
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "replay,metric,value\n";
+    cout << "replay,commands," << cmds.size() << '\n';
+    cout << "replay,seconds," << secs << '\n';
+    cout << "replay,commands_per_sec," << (secs > 0 ? cmds.size() / secs : 0) << '\n';
+    cout << "replay,peak_memory_mb," << peak_memory_bytes() / (1024.0 * 1024.0) << '\n';
+    cout << "op,count,rejected,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+    for (int op = 0; op < OP_COUNT; ++op) {
+        const LatencyHistogram& h = hist[op];
+        if (h.count() == 0) continue;
+        cout << op_name(op) << ',' << h.count() << ',' << rejected[op] << ',' << (uint64_t)h.mean_ns() << ','
+             << h.percentile(50) << ',' << h.percentile(90) << ',' << h.percentile(99) << ','
+             << h.percentile(99.9) << ',' << h.max_ns() << '\n';
+    }
+    if (histogram) {
+        cout << "op,low_ns,high_ns,count\n";
+        for (int op = 0; op < OP_COUNT; ++op)
+            hist[op].for_each_bucket([&](uint64_t lo, uint64_t hi, uint64_t n) {
+                cout << op_name(op) << ',' << lo << ',' << hi << ',' << n << '\n';
+            });
+    }
+    if (!metricsPath.empty()) {
+        ofstream out(metricsPath);
+        write_metrics_json(out);
+        if (!out) { cerr << "cannot write " << metricsPath << '\n'; return 1; }
+    }
+    return 0;
+}
+
+// Synthesises one trading day. The generator mirrors the engine's lane rule
+// (shortest queue, lowest index on ties) so every checkout it emits hits a
+// lane that really has someone waiting.
+struct TraceParams {
+    int catalog = 2000;
+    int customersPerHour = 600;
+    int hours = 12;
+    double basketMean = 8;
+    double onlineShare = 0.2;
+    int cashiers = 3;
+    unsigned seed = 1;
+};
+
+static int generate_trace(const TraceParams& p) {
+    static const char* cats[] = {"Dairy","Meat","Produce","Snacks","Beverages","Household","Bakery","Toys"};
+    static const char* coupons[] = {"LOVEEGYPT", "SAVE5", "OFFER20", "BLACKFRIDAY"};
+    mt19937 rng(p.seed);
+    uniform_real_distribution<double> u(0.0, 1.0);
+    geometric_distribution<int> basket(1.0 / max(1.0, p.basketMean));
+    uniform_int_distribution<int> sku(0, p.catalog - 1), qty(1, 3), prio(1, 10);
+    uniform_real_distribution<double> price(5.0, 400.0);
+
+    ostream& out = cout;
+    out << "# synthetic store day: catalog=" << p.catalog << " customers/h=" << p.customersPerHour << " hours=" << p.hours
+        << " basket=" << p.basketMean << " online=" << p.onlineShare << " cashiers=" << p.cashiers << " seed=" << p.seed << '\n';
+    out << "K " << p.cashiers << '\n';
+    long long customers = (long long)p.customersPerHour * p.hours;
+    for (int i = 0; i < p.catalog; ++i)
+        out << "P G" << i << " Item" << i << ' ' << (int)(price(rng) * 100) / 100.0 << ' ' << customers * 4 << ' ' << cats[i % 8] << '\n';
+
+    vector<int> lane(p.cashiers, 0);
+    int special = 0, online = 0;
+    auto serve_some = [&](double rate) {
+        for (int l = 0; l < p.cashiers; ++l)
+            if (lane[l] > 0 && u(rng) < rate) {
+                out << "C " << l;
+                if (u(rng) < 0.1) out << ' ' << coupons[rng() % 4];
+                out << '\n';
+                lane[l]--;
+                if (u(rng) < 0.01) out << "B " << l << '\n';
+            }
+        if (special > 0 && u(rng) < rate) { out << "X\n"; special--; }
+        if (online > 0 && u(rng) < rate) { out << "L\n"; online--; }
+    };
+
+    for (long long c = 0; c < customers; ++c) {
+        string id = "C" + to_string(c);
+        double r = u(rng);
+        bool isOnline = r < p.onlineShare;
+        bool isSpecial = !isOnline && r < p.onlineShare + 0.03;
+        if (isOnline) out << "O " << id << " Cust" << c << ' ' << prio(rng) << '\n';
+        else out << (isSpecial ? "S " : "W ") << id << " Cust" << c << '\n';
+        int items = basket(rng) + 1;
+        for (int i = 0; i < items; ++i) {
+            out << "A " << id << " G" << sku(rng) << ' ' << qty(rng) << '\n';
+            if (u(rng) < 0.04) out << "U " << id << '\n';
+        }
+        if (!isOnline && u(rng) < 0.02) out << "E " << id << " 1\n"; // walks out, cart left behind
+        else if (isOnline) { out << "N " << id << '\n'; online++; }
+        else if (isSpecial) { out << "Q " << id << '\n'; special++; }
+        else {
+            int best = 0;
+            for (int l = 1; l < p.cashiers; ++l) if (lane[l] < lane[best]) best = l;
+            out << "Q " << id << '\n';
+            lane[best]++;
+        }
+        serve_some(0.9);
+    }
+    while (online > 0 || special > 0 || count_if(lane.begin(), lane.end(), [](int q){ return q > 0; }) > 0) serve_some(1.0);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "run" && argc > 2) {
+        bool histogram = false;
+        string metricsPath;
+        for (int i = 3; i < argc; ++i) {
+            string k = argv[i];
+            if (k == "--histogram") histogram = true;
+            else if (k == "--metrics" && i + 1 < argc) metricsPath = argv[++i];
+            else { cerr << "unknown option " << k << '\n'; return 1; }
+        }
+        return run_trace(argv[2], histogram, metricsPath);
+    }
+    if (mode == "gen") {
+        TraceParams p;
+        for (int i = 2; i + 1 < argc; i += 2) {
+            string k = argv[i], v = argv[i + 1];
+            if (k == "--catalog") p.catalog = max(1, atoi(v.c_str()));
+            else if (k == "--customers-per-hour") p.customersPerHour = max(1, atoi(v.c_str()));
+            else if (k == "--hours") p.hours = max(1, atoi(v.c_str()));
+            else if (k == "--basket-mean") p.basketMean = atof(v.c_str());
+            else if (k == "--online-share") p.onlineShare = atof(v.c_str());
+            else if (k == "--cashiers") p.cashiers = max(1, atoi(v.c_str()));
+            else if (k == "--seed") p.seed = (unsigned)atoi(v.c_str());
+            else { cerr << "unknown option " << k << '\n'; return 1; }
+        }
+        return generate_trace(p);
+    }
+    cerr << "usage: replay gen [options] > file.trace | replay run file.trace [--histogram] [--metrics file.json]\n";
+    return 1;
+}
@@ -0,0 +1,123 @@
+// report.h
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <cmath>
+#include "sales.h"
+using namespace std;
+
+// money is summed in whole piasters so the parallel merge gives the exact same
+// numbers as the serial pass (double sums would depend on the chunk order)
+inline long long to_piasters(double le) { return llround(le * 100.0); }
+
+// thread-local partial result for one chunk of the ledger
+struct SalesAggregate {
+    unordered_map<string, long long> productQty;    // barcode : units
+    unordered_map<string, long long> categoryQty;   // category : units
+    unordered_map<string, long long> customerSpend; // customerId : piasters
+    unordered_map<string, long long> cashierSales;  // cashierId : piasters
+    long long saleCount = 0;
+    long long revenue = 0; // piasters
+
+    void add(const SaleRecord& s, const unordered_map<string, string>& categoryOf) {
+        long long amount = to_piasters(s.total);
+        ++saleCount;
+        revenue += amount;
+        customerSpend[s.customerId] += amount;
+        cashierSales[s.cashierId] += amount;
+        for (auto &it : s.items) {
+            productQty[it.first] += it.second;
+            auto c = categoryOf.find(it.first);
+            categoryQty[c == categoryOf.end() ? string("Unknown") : c->second] += it.second;
+        }
+    }
+
+    void merge(const SalesAggregate& o) {
+        for (auto &kv : o.productQty) productQty[kv.first] += kv.second;
+        for (auto &kv : o.categoryQty) categoryQty[kv.first] += kv.second;
+        for (auto &kv : o.customerSpend) customerSpend[kv.first] += kv.second;
+        for (auto &kv : o.cashierSales) cashierSales[kv.first] += kv.second;
+        saleCount += o.saleCount;
+        revenue += o.revenue;
+    }
+};
+
+struct SalesReport {
+    vector<pair<string, long long>> byProduct;  // units, highest first
+    vector<pair<string, long long>> byCategory; // units, highest first
+    vector<pair<string, long long>> byCustomer; // piasters, highest first
+    vector<pair<string, long long>> byCashier;  // piasters, highest first
+    long long saleCount = 0;
+    long long revenue = 0;
+
+    bool operator==(const SalesReport& o) const {
+        return saleCount == o.saleCount && revenue == o.revenue && byProduct == o.byProduct
+            && byCategory == o.byCategory && byCustomer == o.byCustomer && byCashier == o.byCashier;
+    }
+};
+
+// sorts by value (desc) then key (asc) so the output never depends on hash order
+inline vector<pair<string, long long>> ranked(const unordered_map<string, long long>& m) {
+    vector<pair<string, long long>> v(m.begin(), m.end());
+    sort(v.begin(), v.end(), [](const pair<string, long long>& a, const pair<string, long long>& b) {
+        if (a.second != b.second) return a.second > b.second;
+        return a.first < b.first;
+    });
+    return v;
+}
+
+inline SalesReport finish_report(const SalesAggregate& a) {
+    SalesReport r;
+    r.byProduct = ranked(a.productQty);
+    r.byCategory = ranked(a.categoryQty);
+    r.byCustomer = ranked(a.customerSpend);
+    r.byCashier = ranked(a.cashierSales);
+    r.saleCount = a.saleCount;
+    r.revenue = a.revenue;
+    return r;
+}
+
+class ReportEngine {
+private:
+    const unordered_map<string, string>& categoryOf; // barcode : category, read-only while running
+    unsigned threads;
+    size_t minChunk;
+
+public:
+    ReportEngine(const unordered_map<string, string>& cat, unsigned t = 0, size_t minChunkSize = 16384)
+        : categoryOf(cat) {
+        threads = t != 0 ? t : max(1u, thread::hardware_concurrency());
+        minChunk = minChunkSize;
+    }
+
+    SalesReport run_serial(const vector<const SaleRecord*>& ledger) const {
+        SalesAggregate a;
+        for (const SaleRecord* s : ledger) a.add(*s, categoryOf);
+        return finish_report(a);
+    }
+
+    // splits the ledger into one contiguous chunk per worker, aggregates each chunk
+    // into its own maps and merges the partials in chunk order
+    SalesReport run(const vector<const SaleRecord*>& ledger) const {
+        size_t n = ledger.size();
+        size_t parts = min<size_t>(threads, (n + minChunk - 1) / minChunk);
+        if (parts <= 1) return run_serial(ledger);
+
+        vector<SalesAggregate> partial(parts);
+        vector<thread> workers;
+        size_t chunk = (n + parts - 1) / parts;
+        for (size_t p = 0; p < parts; ++p) {
+            size_t lo = p * chunk, hi = min(n, lo + chunk);
+            workers.emplace_back([&, p, lo, hi]() {
+                for (size_t i = lo; i < hi; ++i) partial[p].add(*ledger[i], categoryOf);
+            });
+        }
+        for (auto &w : workers) w.join();
+        for (size_t p = 1; p < parts; ++p) partial[0].merge(partial[p]);
+        return finish_report(partial[0]);
+    }
+};
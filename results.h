@@ -0,0 +1,126 @@
+// results.h
+#pragma once
+#include <string>
+#include <vector>
+using namespace std;
+
+// Outcome of every engine operation. The engine never prints; callers (the
+// console, the replay driver, ...) turn these into text if they want to.
+enum class Status {
+    Ok,
+    CustomerNotFound,
+    CustomerExists,
+    NotOnlineCustomer,
+    ProductNotFound,
+    ProductExists,
+    InvalidProduct,
+    InvalidQuantity,
+    OutOfStock,
+    NotInCart,
+    NothingToUndo,
+    InvalidCashier,
+    QueueEmpty,
+    EmptyCart,
+    InvalidCoupon,
+    CouponAlreadyApplied,
+    BadRequest,
+    StoreNotFound,
+    LogFailed
+};
+
+inline const char* status_message(Status s) {
+    switch (s) {
+        case Status::Ok: return "OK";
+        case Status::CustomerNotFound: return "Customer not found";
+        case Status::CustomerExists: return "Customer exists";
+        case Status::NotOnlineCustomer: return "Not an online customer";
+        case Status::ProductNotFound: return "Product not found";
+        case Status::ProductExists: return "Product already exists";
+        case Status::InvalidProduct: return "Invalid product";
+        case Status::InvalidQuantity: return "Quantity must be positive.";
+        case Status::OutOfStock: return "Not enough stock";
+        case Status::NotInCart: return "No such item in cart";
+        case Status::NothingToUndo: return "No actions to undo";
+        case Status::InvalidCashier: return "Invalid cashier";
+        case Status::QueueEmpty: return "No customers in queue";
+        case Status::EmptyCart: return "Customer has empty cart";
+        case Status::InvalidCoupon: return "Invalid coupon code.";
+        case Status::CouponAlreadyApplied: return "A coupon has already been applied.";
+        case Status::BadRequest: return "Malformed or unknown request";
+        case Status::StoreNotFound: return "Store not found";
+        case Status::LogFailed: return "Write-ahead log failed; sales are not being saved";
+    }
+    return "Unknown status";
+}
+
+struct CartResult {
+    Status status = Status::Ok;
+    string productName;
+    string customerName;
+    int qty = 0;       // units actually moved
+    int available = 0; // stock left on the shelf (or on OutOfStock, what there was)
+};
+
+// undo of the last cart action
+struct CartUndoResult {
+    Status status = Status::Ok;
+    bool wasAdd = false; // true: an add was undone and stock restored
+    string barcode;
+    int qty = 0;
+};
+
+struct EnqueueResult {
+    Status status = Status::Ok;
+    string customerName;
+    string laneId;     // cashier id, or "ONLINE"
+    bool special = false;
+    int priority = 0;  // online orders only
+    long long promisedBy = 0; // online orders: unix time their delivery slot closes
+};
+
+struct ReceiptLine {
+    string barcode;
+    string name;
+    string category;
+    double unitPrice = 0.0;
+    int qty = 0;
+};
+
+struct CheckoutResult {
+    Status status = Status::Ok;
+    Status couponStatus = Status::Ok; // only meaningful when a coupon was given
+    string saleId;
+    string customerId;
+    string customerName;
+    string laneId;
+    bool online = false;
+    bool couponApplied = false;
+    double subtotal = 0.0;        // before any discount
+    double afterCoupon = 0.0;
+    double specialDiscount = 0.0; // special-needs 10%
+    bool bulkDiscount = false;    // 5% off bills of LE 1000 and over
+    double total = 0.0;
+    vector<ReceiptLine> lines;
+};
+
+// a visit ended without a sale
+struct SessionEndResult {
+    Status status = Status::Ok;
+    string customerName;
+    int lines = 0;  // cart lines put back on the shelf
+    int units = 0;
+    bool forgotten = false; // the customer was removed from the registry
+};
+
+struct BillUndoResult {
+    Status status = Status::Ok;
+    string saleId;
+    bool inLedger = true; // false if the sale had already left the sales list
+};
+
+// stock moved between two stores of a chain (chain.h)
+struct TransferResult {
+    Status status = Status::Ok;
+    int fromStock = 0; // left at the sending store
+    int toStock = 0;   // now at the receiving store
+};
@@ -1,11 +1,15 @@
 // sales.h
 #pragma once
 #include <string>
+#include <iostream>
 #include <vector>
 #include <utility>
 #include <algorithm>
 #include <unordered_map>
 #include "utils.h"
+#include "metrics.h"
+#include "memory.h"
+#include "output.h"
 using namespace std;
 
 struct SaleRecord {
@@ -15,25 +19,65 @@ struct SaleRecord {
     vector<pair<string,int>> items;
     double total;
     string time;
+    string cashierId; // lane that rang the sale up ("ONLINE" for online orders)
     SaleRecord* next;
-    SaleRecord(const string& sid, const string& cid, bool ol, const vector<pair<string,int>>& it, double tot){
+    SaleRecord(const string& sid, const string& cid, bool ol, const vector<pair<string,int>>& it, double tot, const string& cash = ""){
         saleId = sid;
         customerId = cid;
         online = ol;
         items = it;
         total = tot;
         time = now_string();
+        cashierId = cash;
         next = nullptr;
     }
 
 };
 
+// units on the bill, over all lines
+inline int sale_units(const SaleRecord& s) {
+    int n = 0;
+    for (auto &it : s.items) n += it.second;
+    return n;
+}
+
+// heap behind a sale's text and lines; the SaleRecord itself is up to whoever holds it
+inline void account_sale(MemoryUsage& m, const SaleRecord& s) {
+    account_string(m, s.saleId);
+    account_string(m, s.customerId);
+    account_string(m, s.time);
+    account_string(m, s.cashierId);
+    account_vector(m, s.items);
+    for (auto &it : s.items) account_string(m, it.first);
+}
+
+inline const LineTemplate SALE_ROW("{0} | Cust: {1} | {2} | LE {3} | {4}\n");
+inline const LineTemplate SALE_LINE_ROW("   - {0} x{1}\n");
+
+// rows of the window are whole sales, each with its lines
+inline void write_sale_records(OutBuffer& out, const vector<const SaleRecord*>& ledger, RowWindow w = RowWindow()) {
+    out.text("Sales records:\n");
+    for (size_t i = 0; i < ledger.size() && !w.done(i); ++i) {
+        if (!w.shows(i)) continue;
+        const SaleRecord* s = ledger[i];
+        SALE_ROW.render(out, {s->saleId, s->customerId, s->online ? "Online" : "Walk-in", Money{s->total}, s->time});
+        for (auto &it : s->items) SALE_LINE_ROW.render(out, {it.first, it.second});
+    }
+}
+
+inline void print_sale_records(const vector<const SaleRecord*>& ledger, const OutputSink& sink = console_sink()) {
+    OutBuffer out(sink);
+    write_sale_records(out, ledger);
+}
+
 class SalesList {
 private:
     SaleRecord* head = nullptr;
 public:
     SalesList() = default;
-    ~SalesList() {
+    ~SalesList() { clear(); }
+
+    void clear() {
         while (head != nullptr) {
             SaleRecord* t = head;
              head = head->next;
@@ -60,19 +104,27 @@ public:
         return false;
     }
 
-    void print_sales() const {
-        cout << "Sales records:\n";
-        SaleRecord* cur = head;
-        while (cur) {
-            cout << cur->saleId << " | Cust: " << cur->customerId
-                 << " | " << (cur->online ? "Online" : "Walk-in")
-                 << " | LE " << cur->total << " | " << cur->time << '\n';
-            for (auto &it : cur->items) cout << "   - " << it.first << " x" << it.second << '\n';
-            cur = cur->next;
+    // flat view of the ledger (newest first) so reports can partition it into chunks
+    vector<const SaleRecord*> ledger() const {
+        vector<const SaleRecord*> v;
+        for (SaleRecord* cur = head; cur != nullptr; cur = cur->next) v.push_back(cur);
+        return v;
+    }
+
+    void print_sales() const { print_sale_records(ledger()); }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("sales ledger");
+        for (SaleRecord* cur = head; cur != nullptr; cur = cur->next) {
+            m.elements++;
+            account_nodes(m, 1, sizeof(SaleRecord) - sizeof(SaleRecord*), sizeof(SaleRecord));
+            account_sale(m, *cur);
         }
+        return m;
     }
 
     vector<pair<string,int>> tally_products() const {
+        METRIC_SCOPE(Metric::TallyProducts);
         unordered_map<string,int> tally;
         SaleRecord* cur = head;
         while (cur != nullptr) {
@@ -0,0 +1,245 @@
+// scan.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "results.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+using namespace std;
+
+// Scanner input. A till or handheld sends one read per line (or, framed, a
+// length byte then the code). Reads are taken off the stream in large blocks,
+// checked, and packed into integer keys before anything touches the catalog:
+//
+//   - a code is 1 to 16 digits; anything else is malformed
+//   - 13 digits (EAN-13) and 12 digits (UPC-A) must carry a valid check
+//     digit; UPC-A is the EAN-13 with a leading 0 and packs the same way
+//   - shorter codes are in-store numbers (the catalog's "0001") with no check
+//
+// A key is the code's value with its length in the top byte, so "0001" and
+// "001" stay apart and the text comes back with scan_barcode().
+
+enum class ScanFraming { Lines, LengthPrefixed };
+
+inline uint64_t scan_key(unsigned len, uint64_t value) { return (uint64_t)len << 56 | value; }
+inline unsigned scan_key_length(uint64_t key) { return (unsigned)(key >> 56); }
+
+inline string scan_barcode(uint64_t key) {
+    unsigned len = scan_key_length(key);
+    uint64_t v = key & ((uint64_t(1) << 56) - 1);
+    string s(len, '0');
+    for (unsigned i = len; i-- > 0 && v; v /= 10) s[i] = (char)('0' + v % 10);
+    return s;
+}
+
+enum ScanCheck : uint8_t { ScanValid, ScanBadCheckDigit, ScanMalformed };
+
+// One code right-aligned in 16 bytes, '0' in front of it. Weights run 1, 3,
+// 1, 3 ... from the last digit, so the zero padding leaves the EAN/UPC check
+// sum alone and one routine covers both. Scalar version; see below.
+inline ScanCheck scan_decode_scalar(const char* slot, unsigned len, uint64_t& key) {
+    uint64_t v = 0;
+    unsigned sum = 0;
+    for (int i = 0; i < 16; ++i) {
+        unsigned d = (unsigned char)slot[i] - '0';
+        if (d > 9) return ScanMalformed;
+        v = v * 10 + d;
+        sum += (i & 1) ? d : 3 * d;
+    }
+    if ((len == 12 || len == 13) && sum % 10 != 0) return ScanBadCheckDigit;
+    key = scan_key(len == 12 ? 13 : len, v);
+    return ScanValid;
+}
+
+#ifdef SCAN_SSE2
+// SSE2: one compare for the digit test, two SADs for the weighted sum and
+// three multiply-adds folding 16 digits into two 8-digit halves.
+inline ScanCheck scan_decode(const char* slot, unsigned len, uint64_t& key) {
+    const __m128i zero = _mm_setzero_si128(), nine = _mm_set1_epi8(9);
+    __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)slot), _mm_set1_epi8('0'));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(d, nine), nine)) != 0xFFFF) return ScanMalformed;
+    if (len == 12 || len == 13) {
+        // weight 3 on the even lanes: every digit once, the even ones twice more
+        const __m128i even = _mm_set_epi8(0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1, 0, -1);
+        __m128i e = _mm_sad_epu8(_mm_and_si128(d, even), zero);
+        __m128i t = _mm_add_epi64(_mm_sad_epu8(d, zero), _mm_add_epi64(e, e));
+        unsigned sum = (unsigned)_mm_cvtsi128_si32(t) + (unsigned)_mm_cvtsi128_si32(_mm_unpackhi_epi64(t, t));
+        if (sum % 10 != 0) return ScanBadCheckDigit;
+    }
+    const __m128i w10 = _mm_set_epi16(1, 10, 1, 10, 1, 10, 1, 10);
+    const __m128i w100 = _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100);
+    const __m128i w10k = _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000);
+    __m128i p2 = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(d, zero), w10),
+                                 _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), w10)); // 8 x 2 digits
+    __m128i p4 = _mm_madd_epi16(p2, w100);                                          // 4 x 4 digits
+    __m128i p8 = _mm_madd_epi16(_mm_packs_epi32(p4, p4), w10k);                    // 2 x 8 digits
+    uint64_t hi = (uint32_t)_mm_cvtsi128_si32(p8), lo = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(p8, 4));
+    key = scan_key(len == 12 ? 13 : len, hi * 100000000ULL + lo);
+    return ScanValid;
+}
+#else
+inline ScanCheck scan_decode(const char* slot, unsigned len, uint64_t& key) {
+    return scan_decode_scalar(slot, len, key);
+}
+#endif
+
+// the reads of one block, checked
+struct ScanBatch {
+    vector<uint64_t> keys; // valid reads, in stream order
+    size_t reads = 0;      // records taken off the stream (blank lines are not reads)
+    size_t badCheck = 0;
+    size_t malformed = 0;
+
+    void clear() { keys.clear(); reads = badCheck = malformed = 0; }
+};
+
+// Reads a scan stream from a FILE (file, pipe) or from memory. Records are
+// framed straight out of a large block, staged into 16-byte slots and decoded
+// in one pass per batch; a record cut by the block's end is carried over.
+class ScanReader {
+private:
+    FILE* f = nullptr;
+    ScanFraming framing;
+    bool vectorized = true;
+    vector<char> block;
+    const char* data = nullptr; // bytes [pos, end) not yet framed
+    size_t pos = 0, end = 0;
+    bool eof = false;
+    bool skipLine = false; // the rest of an overlong line is still to come
+    vector<char> slots; // 16 bytes per staged record
+    vector<uint8_t> lens;
+
+    // false at the end of the stream
+    bool refill() {
+        if (eof) return false;
+        size_t left = end - pos;
+        if (left == block.size()) {
+            // one record fills the block: it cannot be a code, drop it
+            left = 0;
+            if (framing == ScanFraming::Lines) skipLine = true;
+        }
+        memmove(block.data(), block.data() + pos, left);
+        size_t got = fread(block.data() + left, 1, block.size() - left, f);
+        pos = 0;
+        end = left + got;
+        if (got == 0) eof = true;
+        return got > 0 || left > 0;
+    }
+
+    // next record into [rec, rec + len); false if the block holds no whole record
+    bool frame(const char*& rec, size_t& len) {
+        if (pos >= end) return false;
+        const char* p = data + pos;
+        size_t n = end - pos;
+        if (framing == ScanFraming::LengthPrefixed) {
+            size_t l = (unsigned char)p[0];
+            if (n < l + 1) {
+                if (!eof) return false;
+                pos = end; rec = p + 1; len = n - 1; // truncated tail
+                return true;
+            }
+            rec = p + 1; len = l;
+            pos += l + 1;
+            return true;
+        }
+        const char* nl = (const char*)memchr(p, '\n', n);
+        if (!nl) {
+            if (!eof) return false;
+            nl = p + n; // last line without a newline
+        }
+        rec = p; len = (size_t)(nl - p);
+        pos += len + (nl < p + n ? 1 : 0);
+        if (len && rec[len - 1] == '\r') len--;
+        if (skipLine) { skipLine = false; len = SIZE_MAX; } // tail of a dropped line: one malformed read
+        return true;
+    }
+
+public:
+    static const size_t BLOCK = 1 << 20;
+
+    ScanReader(FILE* file, ScanFraming fr = ScanFraming::Lines, size_t blockSize = BLOCK)
+        : f(file), framing(fr), block(max<size_t>(blockSize, 1024)) {
+        data = block.data();
+    }
+    // a stream already in memory
+    explicit ScanReader(string_view bytes, ScanFraming fr = ScanFraming::Lines)
+        : framing(fr), data(bytes.data()), end(bytes.size()), eof(true) {}
+
+    // scalar decoding instead of SSE2 (the benchmark compares the two)
+    void set_vectorized(bool v) { vectorized = v; }
+
+    // the next batch of at most max reads; false once the stream is exhausted
+    bool next(ScanBatch& b, size_t max = 4096) {
+        b.clear();
+        slots.resize(max * 16);
+        lens.clear();
+        while (b.reads < max) {
+            const char* rec;
+            size_t len;
+            if (!frame(rec, len)) {
+                if (!f || !refill()) break;
+                continue;
+            }
+            if (len == 0 && framing == ScanFraming::Lines) continue;
+            b.reads++;
+            if (len == 0 || len > 16) { b.malformed++; continue; } // SIZE_MAX too
+            char* s = slots.data() + lens.size() * 16;
+            memset(s, '0', 16 - len);
+            memcpy(s + 16 - len, rec, len);
+            lens.push_back((uint8_t)len);
+        }
+        b.keys.reserve(lens.size());
+        const char* s = slots.data();
+        for (size_t i = 0; i < lens.size(); ++i, s += 16) {
+            uint64_t key;
+            ScanCheck c = vectorized ? scan_decode(s, lens[i], key) : scan_decode_scalar(s, lens[i], key);
+            if (c == ScanValid) b.keys.push_back(key);
+            else if (c == ScanBadCheckDigit) b.badCheck++;
+            else b.malformed++;
+        }
+        return b.reads > 0;
+    }
+};
+
+// what one stream did to a cart
+struct ScanIngest {
+    Status status = Status::Ok; // CustomerNotFound: nothing was read
+    size_t reads = 0;
+    size_t valid = 0;
+    size_t badCheck = 0;
+    size_t malformed = 0;
+    size_t unknown = 0;    // valid codes the catalog does not have (reads)
+    size_t outOfStock = 0; // units refused for lack of stock
+    size_t units = 0;      // units put in the cart
+    size_t adds = 0;       // cart operations they took
+    uint64_t elapsedNs = 0;
+};
+
+// A batch's keys merged by code, in order of first read, so a run of the same
+// item is one cart add.
+class ScanCoalescer {
+private:
+    unordered_map<uint64_t, uint32_t> at;
+
+public:
+    vector<pair<uint64_t, int>> lines;
+
+    const vector<pair<uint64_t, int>>& merge(const vector<uint64_t>& keys) {
+        at.clear();
+        lines.clear();
+        for (uint64_t k : keys) {
+            auto slot = at.try_emplace(k, (uint32_t)lines.size());
+            if (slot.second) lines.push_back({k, 1});
+            else lines[slot.first->second].second++;
+        }
+        return lines;
+    }
+};
@@ -0,0 +1,185 @@
+// scheduler.h
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include "customer.h"
+using namespace std;
+
+// Online order scheduling: priority with aging, plus earliest-deadline-first
+// for orders whose promised delivery slot is about to close.
+//
+// Aging: an order gains one priority step for every agingSeconds it waits.
+// Every waiting order ages at the same rate, so aging never changes the order
+// of two waiting orders; it only lets an old order outrank one placed later.
+// The rank is therefore a fixed key, placed + priority * agingSeconds, and
+// nothing is ever re-sorted as time passes.
+//
+// Deadlines: every order is promised a delivery slot. A second heap keeps
+// the orders by slot end. Once the earliest of them is within urgentSeconds
+// of it, that order goes first, whatever its rank. Taking an order from one
+// heap leaves a stale entry in the other; entries carry the generation of
+// their slot and are dropped when they reach the top.
+struct SchedulerOptions {
+    int agingSeconds = 300;  // waiting this long is worth one priority step (0: no aging)
+    int urgentSeconds = 900; // slack at which an order jumps the line (0: no deadline rule)
+    int slotMinutes = 60;    // delivery slots start on multiples of this
+    int leadMinutes = 30;    // earliest slot starts at least this long after the order
+};
+
+struct ScheduledOrder {
+    VisitRef customer;
+    int priority = 5;       // lower = served first
+    int64_t placed = 0;     // unix seconds
+    int64_t deadline = 0;   // end of the promised delivery slot
+};
+
+struct SchedulerStats {
+    uint64_t served = 0;
+    uint64_t onTime = 0;    // served before the slot closed
+    int64_t maxWait = 0;    // seconds
+    int64_t totalWait = 0;
+    double on_time_percent() const { return served ? 100.0 * onTime / served : 100.0; }
+    double mean_wait() const { return served ? (double)totalWait / served : 0.0; }
+};
+
+class OnlineScheduler {
+private:
+    struct Entry {
+        ScheduledOrder order;
+        uint32_t gen = 0;
+        bool live = false;
+    };
+    struct HeapItem {
+        int64_t key;
+        uint32_t slot;
+        uint32_t gen;
+        bool operator<(const HeapItem& o) const { return key > o.key || (key == o.key && slot > o.slot); } // min-heap
+    };
+    SchedulerOptions opt;
+    vector<Entry> entries;
+    vector<uint32_t> freeSlots;
+    vector<HeapItem> byRank, byDeadline;
+    size_t live = 0;
+    SchedulerStats st;
+
+    int64_t rank_key(const ScheduledOrder& o) const {
+        if (opt.agingSeconds <= 0) return (int64_t)o.priority * (int64_t(1) << 40) + o.placed;
+        return o.placed + (int64_t)o.priority * opt.agingSeconds;
+    }
+    bool current(const HeapItem& h) const { return entries[h.slot].live && entries[h.slot].gen == h.gen; }
+    void drop_stale(vector<HeapItem>& heap) {
+        while (!heap.empty() && !current(heap.front())) { pop_heap(heap.begin(), heap.end()); heap.pop_back(); }
+    }
+    // stale entries never outnumber live ones by much
+    void compact(vector<HeapItem>& heap) {
+        if (heap.size() < 64 || heap.size() < 2 * live) return;
+        heap.erase(std::remove_if(heap.begin(), heap.end(), [&](const HeapItem& h) { return !current(h); }), heap.end());
+        make_heap(heap.begin(), heap.end());
+    }
+    void release(uint32_t slot) {
+        entries[slot].live = false;
+        entries[slot].gen++;
+        freeSlots.push_back(slot);
+        live--;
+    }
+    // which heap the next order comes from
+    vector<HeapItem>* next_heap(int64_t now) {
+        drop_stale(byRank);
+        drop_stale(byDeadline);
+        if (byRank.empty()) return nullptr;
+        if (opt.urgentSeconds > 0 && !byDeadline.empty() && byDeadline.front().key - now <= opt.urgentSeconds) return &byDeadline;
+        return &byRank;
+    }
+
+public:
+    OnlineScheduler() = default;
+    explicit OnlineScheduler(const SchedulerOptions& o) : opt(o) {}
+
+    const SchedulerOptions& options() const { return opt; }
+    // applies to orders placed from now on; waiting ones keep their keys
+    void set_options(const SchedulerOptions& o) { opt = o; }
+
+    // end of the first slot that starts leadMinutes or more after placed
+    int64_t default_deadline(int64_t placed) const {
+        int64_t slot = max(1, opt.slotMinutes) * 60LL;
+        int64_t start = (placed + opt.leadMinutes * 60LL + slot - 1) / slot * slot;
+        return start + slot;
+    }
+
+    void push(const ScheduledOrder& o) {
+        uint32_t slot;
+        if (freeSlots.empty()) { slot = (uint32_t)entries.size(); entries.emplace_back(); }
+        else { slot = freeSlots.back(); freeSlots.pop_back(); }
+        Entry& e = entries[slot];
+        e.order = o;
+        if (e.order.deadline == 0) e.order.deadline = default_deadline(o.placed);
+        e.live = true;
+        live++;
+        byRank.push_back(HeapItem{rank_key(e.order), slot, e.gen});
+        push_heap(byRank.begin(), byRank.end());
+        byDeadline.push_back(HeapItem{e.order.deadline, slot, e.gen});
+        push_heap(byDeadline.begin(), byDeadline.end());
+    }
+
+    bool isEmpty() const { return live == 0; }
+    size_t size() const { return live; }
+    // freed slots and heap entries not yet dropped are overhead
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("online queue");
+        m.elements = live;
+        m.add(live * sizeof(Entry), heap_block(entries.capacity() * sizeof(Entry)));
+        m.add(0, heap_block(freeSlots.capacity() * sizeof(uint32_t)));
+        m.add(live * sizeof(HeapItem), heap_block(byRank.capacity() * sizeof(HeapItem)));
+        m.add(live * sizeof(HeapItem), heap_block(byDeadline.capacity() * sizeof(HeapItem)));
+        return m;
+    }
+
+    // the order pop(now) would hand out; only valid while !isEmpty()
+    const ScheduledOrder& peek(int64_t now) {
+        return entries[next_heap(now)->front().slot].order;
+    }
+
+    // takes the next order to fulfil at time now; served = false drops it
+    // without counting it (an order whose visit has ended)
+    bool pop(int64_t now, ScheduledOrder& out, bool served = true) {
+        vector<HeapItem>* heap = next_heap(now);
+        if (heap == nullptr) return false;
+        uint32_t slot = heap->front().slot;
+        pop_heap(heap->begin(), heap->end()); heap->pop_back();
+        out = entries[slot].order;
+        release(slot);
+        compact(byRank);
+        compact(byDeadline);
+        if (!served) return true;
+        int64_t wait = max<int64_t>(0, now - out.placed);
+        st.served++;
+        st.totalWait += wait;
+        st.maxWait = max(st.maxWait, wait);
+        if (now <= out.deadline) st.onTime++;
+        return true;
+    }
+
+    // takes out, without serving, every waiting order pred accepts
+    template<typename F>
+    size_t remove_if(F pred) {
+        size_t removed = 0;
+        for (uint32_t i = 0; i < entries.size(); ++i)
+            if (entries[i].live && pred(entries[i].order)) { release(i); removed++; }
+        if (removed) { compact(byRank); compact(byDeadline); }
+        return removed;
+    }
+
+    // waiting orders by rank (display only: sorts a copy)
+    template<typename F>
+    void for_each(F f) const {
+        vector<HeapItem> v;
+        for (const HeapItem& h : byRank) if (current(h)) v.push_back(h);
+        sort(v.begin(), v.end(), [](const HeapItem& a, const HeapItem& b) { return b < a; });
+        for (const HeapItem& h : v) f(entries[h.slot].order);
+    }
+
+    const SchedulerStats& stats() const { return st; }
+    void reset_stats() { st = SchedulerStats(); }
+};
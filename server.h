@@ -0,0 +1,552 @@
+// server.h
+#pragma once
+#include "net.h"
+#include "system.h"
+#include <atomic>
+#include <chrono>
+using namespace std;
+
+// Engine server: one in-memory SupermarketSystem shared by any number of local
+// clients (tills, the GUI, kiosks) over a Unix socket or loopback TCP (net.h).
+//
+// Every message is a frame, integers little-endian:
+//   request  = u32 len | u32 requestId | u8 op     | payload
+//   response = u32 len | u32 requestId | u8 status | payload
+// len counts the bytes after itself. Payloads use the encoding of wal.h:
+// strings are u32 length + bytes, prices f64, quantities i32. status is a
+// Status (results.h) and result payloads are sent whatever the status, so a
+// refused cart add still says how much stock there was.
+//
+// Replies come back in request order, so clients pipeline: write a batch of
+// requests, then read the replies. The server runs every complete request it
+// has read before it writes, and sends all of their replies in one go.
+// A single poll() loop owns the engine, so requests never interleave.
+//
+// Listings that grow with the store (products, customers, the ledger) come in
+// pages: the request ends in u32 offset, u32 limit (0 = no limit) and the
+// reply starts with u32 total, u32 n, then rows [offset, offset + n). A page
+// also ends once it passes SERVER_PAGE_BYTES, so a client asks again from
+// offset + n until it has total rows. Pages are separate requests: what
+// changes between them shifts the rows that follow. Other replies are not
+// paged; EngineClient takes frames up to SERVER_MAX_REPLY.
+enum class ServerOp : uint8_t {
+    Ping = 1,     // -> (empty)
+    GetProduct,   // str barcode -> product
+    ListProducts, // u8 order (0 catalog, 1 price, 2 category), page -> page of products
+    AddProduct,   // product -> (empty)
+    AddCustomer,  // u8 kind (0 walk-in, 1 special, 2 online), str id, str name, str address, str payment, i32 priority
+    ListCustomers,// page -> page of (str id, str name, str type, u32 cart lines)
+    CartAdd,      // str customer, str barcode, i32 qty -> str product, str customer name, i32 qty, i32 available
+    CartRemove,   // as CartAdd
+    CartUndo,     // str customer -> u8 wasAdd, str barcode, i32 qty
+    CartView,     // str customer -> u32 n, n receipt lines, f64 subtotal
+    Enqueue,      // str customer -> str name, str lane, u8 special, i32 priority, u64 delivery slot end (online, else 0)
+    PlaceOnline,  // as Enqueue
+    Checkout,     // i32 lane (>= 0 cashier, -1 special needs, -2 online), str coupon -> checkout result
+    UndoBill,     // i32 lane (>= 0 cashier, -1 special needs) -> str saleId, u8 inLedger
+    QueueStatus,  // -> u32 lanes, each str lane, u32 n, n x (str id, str name, u32 cart lines)
+    SalesLedger,  // page -> page of sales (wal.h layout), newest first
+    SalesReport,  // -> u64 sales, u64 revenue (piasters), then product units, category units,
+                  //    customer piasters, cashier piasters: each u32 n, n x (str, u64)
+    Coupons,      // -> u32 n, n x (str code, f64 percent)
+    Shutdown,     // -> (empty); the server stops once the batch is answered
+    Changes,      // u64 from (0 = from now), u32 max -> u64 next, u8 lapped, u32 n, n x
+                  //    (u64 seq, u8 type, str key, i32 delta, i32 stock, u64 amount); see changefeed.h
+    BeginSession, // str customer -> (empty)
+    EndSession    // str customer, u8 forget -> str name, i32 lines, i32 units returned to stock, u8 forgotten
+};
+
+// product = str barcode, str name, f64 price, i32 stock, str expiry, str category
+// receipt line = str barcode, str name, str category, f64 unit price, i32 qty
+// checkout result = u8 couponStatus, str saleId, str customerId, str customerName,
+//   str lane, u8 online, u8 couponApplied, f64 subtotal, f64 afterCoupon,
+//   f64 specialDiscount, u8 bulkDiscount, f64 total, u32 n, n receipt lines
+
+const uint32_t SERVER_MAX_FRAME = 1u << 20;       // larger requests drop the connection
+const uint32_t SERVER_MAX_REPLY = 256u << 20;     // larger replies drop EngineClient's connection
+const size_t SERVER_PAGE_BYTES = 512u << 10;      // a page of a listing ends once past this
+const size_t SERVER_MAX_PENDING = 8u << 20;       // stop reading a client that does not read its replies
+const size_t SERVER_FRAME_HEADER = 9;             // len + requestId + op/status
+
+struct ServerStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t batches = 0;  // reads that ran at least one request
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+};
+
+// starts a frame in b; frame_end(b, at) fills in its length
+inline size_t frame_begin(WalBuffer& b, uint32_t requestId, uint8_t opOrStatus) {
+    size_t at = b.size();
+    b.put_u32(0);
+    b.put_u32(requestId);
+    b.put_u8(opOrStatus);
+    return at;
+}
+
+inline void frame_end(WalBuffer& b, size_t at) { b.patch_u32(at, (uint32_t)(b.size() - at - 4)); }
+
+inline void put_receipt_lines(WalBuffer& b, const vector<ReceiptLine>& lines) {
+    b.put_u32((uint32_t)lines.size());
+    for (auto &l : lines) { b.put_str(l.barcode); b.put_str(l.name); b.put_str(l.category); b.put_f64(l.unitPrice); b.put_i32(l.qty); }
+}
+
+inline void put_ranking(WalBuffer& b, const vector<pair<string, long long>>& v) {
+    b.put_u32((uint32_t)v.size());
+    for (auto &kv : v) { b.put_str(kv.first); b.put_u64((uint64_t)kv.second); }
+}
+
+// One page of a listing reply: u32 total, u32 n, then the rows. Always takes
+// the first row, so a client paging through always gets somewhere.
+class ReplyPage {
+private:
+    WalBuffer& out;
+    size_t countAt, start;
+    uint32_t limit, n = 0;
+
+public:
+    ReplyPage(WalBuffer& o, size_t total, uint32_t lim) : out(o), limit(lim ? lim : UINT32_MAX) {
+        out.put_u32((uint32_t)total);
+        countAt = out.size();
+        out.put_u32(0);
+        start = out.size();
+    }
+    bool full() const { return n >= limit || (n > 0 && out.size() - start >= SERVER_PAGE_BYTES); }
+    void added() { out.patch_u32(countAt, ++n); }
+};
+
+class EngineServer {
+private:
+    struct Client {
+        sock_t fd = BAD_SOCKET;
+        vector<char> in; // bytes of frames not complete yet
+        WalBuffer out;   // replies not sent yet, from outSent on
+        size_t outSent = 0;
+        bool closing = false;
+    };
+
+    SupermarketSystem& sys;
+    sock_t listener = BAD_SOCKET;
+    string unixPath; // removed again on close
+    vector<Client> clients;
+    atomic<bool> stopping{false};
+    ServerStats st;
+    // a sorted listing, kept while the change feed shows nothing new, so
+    // paging through it sorts once
+    vector<Product> sorted;
+    uint8_t sortedOrder = 0;
+    uint64_t sortedAt = UINT64_MAX;
+
+    void accept_clients();
+    void read_client(Client& c);
+    void run_frames(Client& c);
+    void flush_client(Client& c);
+    Status execute(ServerOp op, WalCursor& in, WalBuffer& out);
+
+public:
+    explicit EngineServer(SupermarketSystem& s) : sys(s) {}
+    ~EngineServer() { close(); }
+    EngineServer(const EngineServer&) = delete;
+    EngineServer& operator=(const EngineServer&) = delete;
+
+    bool listen(const string& address, string* err = nullptr);
+    void run();                    // serves until stop() or a Shutdown request
+    void stop() { stopping = true; } // safe from another thread; noticed within 100 ms
+    void close();
+    const ServerStats& stats() const { return st; }
+};
+
+inline bool EngineServer::listen(const string& address, string* err) {
+    if (!sys.change_feed()) sys.enable_change_feed(); // clients refresh from it instead of rescanning
+    listener = net_listen(address, err);
+    if (listener == BAD_SOCKET) return false;
+    string host; int port = 0;
+    if (!net_is_tcp(address, host, port)) unixPath = address;
+    return true;
+}
+
+inline void EngineServer::close() {
+    for (auto &c : clients) net_close(c.fd);
+    clients.clear();
+    if (listener != BAD_SOCKET) net_close(listener);
+    listener = BAD_SOCKET;
+#ifndef _WIN32
+    if (!unixPath.empty()) ::unlink(unixPath.c_str());
+#endif
+    unixPath.clear();
+}
+
+inline void EngineServer::run() {
+    vector<net_pollfd> fds;
+    while (!stopping && listener != BAD_SOCKET) {
+        fds.clear();
+        net_pollfd l; l.fd = listener; l.events = POLLIN; l.revents = 0;
+        fds.push_back(l);
+        for (auto &c : clients) {
+            net_pollfd p; p.fd = c.fd; p.events = 0; p.revents = 0;
+            size_t pending = c.out.size() - c.outSent;
+            if (pending < SERVER_MAX_PENDING) p.events |= POLLIN;
+            if (pending > 0) p.events |= POLLOUT;
+            fds.push_back(p);
+        }
+        if (net_poll(fds.data(), fds.size(), 100) < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) continue;
+#endif
+            break;
+        }
+        size_t known = clients.size(); // accepted clients are polled next round
+        if (fds[0].revents & POLLIN) accept_clients();
+        for (size_t i = 0; i < known; ++i) {
+            Client& c = clients[i];
+            short ev = fds[i + 1].revents;
+            if (ev & (POLLIN | POLLHUP | POLLERR)) read_client(c);
+            if (!c.closing && c.outSent < c.out.size()) flush_client(c);
+        }
+        sys.publish_snapshot(); // what this round changed becomes visible to snapshot readers
+        size_t kept = 0;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            if (clients[i].closing) { net_close(clients[i].fd); continue; }
+            if (kept != i) clients[kept] = move(clients[i]);
+            kept++;
+        }
+        clients.resize(kept);
+    }
+}
+
+inline void EngineServer::accept_clients() {
+    for (;;) {
+        sock_t s = ::accept(listener, nullptr, nullptr);
+        if (s == BAD_SOCKET) return;
+        net_set_nonblocking(s);
+        int on = 1; // harmless on Unix sockets, where it just fails
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+        Client c;
+        c.fd = s;
+        clients.push_back(move(c));
+        st.connections++;
+    }
+}
+
+// reads what is there, runs every complete frame, then answers the lot at once
+inline void EngineServer::read_client(Client& c) {
+    char buf[64 * 1024];
+    bool eof = false;
+    for (;;) {
+        long n = net_recv(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.in.insert(c.in.end(), buf, buf + n);
+            st.bytesIn += (uint64_t)n;
+            if ((size_t)n < sizeof(buf)) break;
+            continue;
+        }
+        if (n < 0 && net_would_block()) break;
+#ifndef _WIN32
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        eof = true;
+        break;
+    }
+    run_frames(c);
+    if (!c.closing && c.outSent < c.out.size()) flush_client(c);
+    if (eof) c.closing = true;
+}
+
+inline void EngineServer::run_frames(Client& c) {
+    size_t pos = 0;
+    bool ran = false;
+    while (!stopping && c.in.size() - pos >= 4) {
+        uint32_t len;
+        memcpy(&len, c.in.data() + pos, 4);
+        if (len < SERVER_FRAME_HEADER - 4 || len > SERVER_MAX_FRAME) { c.closing = true; break; }
+        if (c.in.size() - pos - 4 < len) break;
+        uint32_t requestId;
+        memcpy(&requestId, c.in.data() + pos + 4, 4);
+        ServerOp op = (ServerOp)(uint8_t)c.in[pos + 8];
+        WalCursor req(c.in.data() + pos + SERVER_FRAME_HEADER, len - (SERVER_FRAME_HEADER - 4));
+        size_t at = frame_begin(c.out, requestId, 0);
+        Status s = execute(op, req, c.out);
+        if (s == Status::BadRequest) c.out.bytes.resize(at + SERVER_FRAME_HEADER); // no half-written payload
+        c.out.bytes[at + 8] = (char)(uint8_t)s;
+        frame_end(c.out, at);
+        st.requests++;
+        ran = true;
+        pos += 4 + len;
+    }
+    if (ran) st.batches++;
+    c.in.erase(c.in.begin(), c.in.begin() + (ptrdiff_t)pos);
+}
+
+inline void EngineServer::flush_client(Client& c) {
+    while (c.outSent < c.out.size()) {
+        long n = net_send(c.fd, c.out.bytes.data() + c.outSent, c.out.size() - c.outSent);
+        if (n > 0) { c.outSent += (size_t)n; st.bytesOut += (uint64_t)n; continue; }
+        if (n < 0 && net_would_block()) return;
+        c.closing = true;
+        return;
+    }
+    c.out.clear();
+    c.outSent = 0;
+}
+
+// Arguments are decoded first and the engine only runs if they all arrived.
+inline Status EngineServer::execute(ServerOp op, WalCursor& in, WalBuffer& out) {
+    auto put_cart = [&](const CartResult& r) {
+        out.put_str(r.productName); out.put_str(r.customerName); out.put_i32(r.qty); out.put_i32(r.available);
+    };
+    auto put_enqueue = [&](const EnqueueResult& r) {
+        out.put_str(r.customerName); out.put_str(r.laneId); out.put_u8(r.special ? 1 : 0); out.put_i32(r.priority);
+        out.put_u64((uint64_t)r.promisedBy);
+    };
+    switch (op) {
+        case ServerOp::Ping:
+            return Status::Ok;
+        case ServerOp::GetProduct: {
+            string bc = in.str();
+            if (!in.ok) return Status::BadRequest;
+            const Product* p = sys.get_inventory().peek(bc);
+            if (p == nullptr) return Status::ProductNotFound;
+            wal_put_product(out, *p);
+            return Status::Ok;
+        }
+        case ServerOp::ListProducts: {
+            uint8_t order = in.u8();
+            uint32_t offset = in.u32(), limit = in.u32();
+            if (!in.ok || order > 2) return Status::BadRequest;
+            if (order == 0) {
+                const Inventory& inv = sys.get_inventory();
+                ReplyPage page(out, inv.size(), limit);
+                inv.for_each(offset, [&](const Product& p) {
+                    if (page.full()) return false;
+                    wal_put_product(out, p);
+                    page.added();
+                    return true;
+                });
+                return Status::Ok;
+            }
+            uint64_t at = sys.change_feed() ? sys.change_feed()->next_seq() : UINT64_MAX;
+            if (at == UINT64_MAX || at != sortedAt || order != sortedOrder) {
+                sorted = order == 1 ? sys.products_sorted_by_price() : sys.products_sorted_by_category();
+                sortedOrder = order;
+                sortedAt = at;
+            }
+            ReplyPage page(out, sorted.size(), limit);
+            for (size_t i = offset; i < sorted.size() && !page.full(); ++i) {
+                wal_put_product(out, sorted[i]);
+                page.added();
+            }
+            return Status::Ok;
+        }
+        case ServerOp::AddProduct: {
+            Product p = wal_get_product(in);
+            if (!in.ok) return Status::BadRequest;
+            return sys.add_product(p);
+        }
+        case ServerOp::AddCustomer: {
+            uint8_t kind = in.u8();
+            string id = in.str(), name = in.str(), addr = in.str(), pay = in.str();
+            int priority = in.i32();
+            if (!in.ok || kind > 2 || id.empty()) return Status::BadRequest;
+            if (kind == 1) return sys.add_special_customer(id, name);
+            if (kind == 2) return sys.add_online_customer(id, name, addr, pay, priority);
+            return sys.add_walkin_customer(id, name);
+        }
+        case ServerOp::ListCustomers: {
+            uint32_t offset = in.u32(), limit = in.u32();
+            if (!in.ok) return Status::BadRequest;
+            const CustomerRegistry& reg = sys.customer_registry();
+            vector<CustomerNo> v = sys.customer_list();
+            ReplyPage page(out, v.size(), limit);
+            for (size_t i = offset; i < v.size() && !page.full(); ++i) {
+                CustomerNo c = v[i];
+                out.put_str(reg.id(c)); out.put_str(reg.name(c)); out.put_str(kind_name(reg.kind(c)));
+                out.put_u32((uint32_t)reg.cart_lines(c));
+                page.added();
+            }
+            return Status::Ok;
+        }
+        case ServerOp::CartAdd:
+        case ServerOp::CartRemove: {
+            string cust = in.str(), bc = in.str();
+            int qty = in.i32();
+            if (!in.ok) return Status::BadRequest;
+            CartResult r = op == ServerOp::CartAdd ? sys.customer_add_to_cart(cust, bc, qty)
+                                                   : sys.customer_remove_from_cart(cust, bc, qty);
+            put_cart(r);
+            return r.status;
+        }
+        case ServerOp::CartUndo: {
+            string cust = in.str();
+            if (!in.ok) return Status::BadRequest;
+            CartUndoResult r = sys.customer_undo(cust);
+            out.put_u8(r.wasAdd ? 1 : 0); out.put_str(r.barcode); out.put_i32(r.qty);
+            return r.status;
+        }
+        case ServerOp::CartView: {
+            string cust = in.str();
+            if (!in.ok) return Status::BadRequest;
+            CustomerNo c = sys.find_customer(cust);
+            if (c == NO_CUSTOMER) return Status::CustomerNotFound;
+            const ShoppingCart* cart = sys.customer_registry().find_cart(c);
+            put_receipt_lines(out, cart ? cart->receipt_lines() : vector<ReceiptLine>());
+            out.put_f64(cart ? cart->subtotal() : 0.0);
+            return Status::Ok;
+        }
+        case ServerOp::Enqueue:
+        case ServerOp::PlaceOnline: {
+            string cust = in.str();
+            if (!in.ok) return Status::BadRequest;
+            EnqueueResult r = op == ServerOp::Enqueue ? sys.enqueue_walkin_to_cashier(cust) : sys.place_online_order(cust);
+            put_enqueue(r);
+            return r.status;
+        }
+        case ServerOp::Checkout: {
+            int lane = in.i32();
+            string coupon = in.str();
+            if (!in.ok) return Status::BadRequest;
+            CheckoutResult r = lane == -1 ? sys.process_checkout_at_specialneedscashier(coupon)
+                             : lane == -2 ? sys.process_next_online_order(coupon)
+                                          : sys.process_checkout_at_cashier(lane, coupon);
+            out.put_u8((uint8_t)r.couponStatus);
+            out.put_str(r.saleId); out.put_str(r.customerId); out.put_str(r.customerName); out.put_str(r.laneId);
+            out.put_u8(r.online ? 1 : 0); out.put_u8(r.couponApplied ? 1 : 0);
+            out.put_f64(r.subtotal); out.put_f64(r.afterCoupon); out.put_f64(r.specialDiscount);
+            out.put_u8(r.bulkDiscount ? 1 : 0); out.put_f64(r.total);
+            put_receipt_lines(out, r.lines);
+            return r.status;
+        }
+        case ServerOp::UndoBill: {
+            int lane = in.i32();
+            if (!in.ok) return Status::BadRequest;
+            BillUndoResult r = lane == -1 ? sys.cashier_undo_last_specialneedscashier_bill() : sys.cashier_undo_last_bill(lane);
+            out.put_str(r.saleId); out.put_u8(r.inLedger ? 1 : 0);
+            return r.status;
+        }
+        case ServerOp::QueueStatus: {
+            const CustomerRegistry& reg = sys.customer_registry();
+            vector<LaneView> lanes = sys.queue_status();
+            out.put_u32((uint32_t)lanes.size());
+            for (auto &l : lanes) {
+                out.put_str(l.laneId);
+                out.put_u32((uint32_t)l.waiting.size());
+                for (CustomerNo c : l.waiting) {
+                    out.put_str(reg.id(c)); out.put_str(reg.name(c));
+                    out.put_u32((uint32_t)reg.cart_lines(c));
+                }
+            }
+            return Status::Ok;
+        }
+        case ServerOp::SalesLedger: {
+            uint32_t offset = in.u32(), limit = in.u32();
+            if (!in.ok) return Status::BadRequest;
+            vector<const SaleRecord*> v = sys.sales_ledger();
+            ReplyPage page(out, v.size(), limit);
+            for (size_t i = offset; i < v.size() && !page.full(); ++i) {
+                wal_put_sale(out, *v[i]);
+                page.added();
+            }
+            return Status::Ok;
+        }
+        case ServerOp::SalesReport: {
+            SalesReport r = sys.sales_report();
+            out.put_u64((uint64_t)r.saleCount); out.put_u64((uint64_t)r.revenue);
+            put_ranking(out, r.byProduct); put_ranking(out, r.byCategory);
+            put_ranking(out, r.byCustomer); put_ranking(out, r.byCashier);
+            return Status::Ok;
+        }
+        case ServerOp::Coupons: {
+            const vector<Coupon>& v = ShoppingCart::coupons();
+            out.put_u32((uint32_t)v.size());
+            for (auto &c : v) { out.put_str(c.code); out.put_f64(c.discountRate); }
+            return Status::Ok;
+        }
+        case ServerOp::Shutdown:
+            stopping = true;
+            return Status::Ok;
+        case ServerOp::Changes: {
+            uint64_t from = in.u64();
+            uint32_t limit = in.u32();
+            if (!in.ok || sys.change_feed() == nullptr) return Status::BadRequest;
+            FeedSubscriber sub(*sys.change_feed(), from);
+            vector<ChangeEvent> ev(min<uint32_t>(limit, 4096));
+            bool lapped = false;
+            size_t n = sub.poll(ev.data(), ev.size(), &lapped);
+            out.put_u64(sub.position()); out.put_u8(lapped ? 1 : 0);
+            out.put_u32((uint32_t)n);
+            for (size_t i = 0; i < n; ++i) {
+                const ChangeEvent& e = ev[i];
+                out.put_u64(e.seq); out.put_u8((uint8_t)e.type); out.put_str(e.key_view());
+                out.put_i32(e.delta); out.put_i32(e.stock); out.put_u64((uint64_t)e.amount);
+            }
+            return Status::Ok;
+        }
+        case ServerOp::BeginSession: {
+            string cust = in.str();
+            if (!in.ok) return Status::BadRequest;
+            return sys.begin_session(cust);
+        }
+        case ServerOp::EndSession: {
+            string cust = in.str();
+            uint8_t forget = in.u8();
+            if (!in.ok) return Status::BadRequest;
+            SessionEndResult r = sys.end_session(cust, forget != 0);
+            out.put_str(r.customerName); out.put_i32(r.lines); out.put_i32(r.units); out.put_u8(r.forgotten ? 1 : 0);
+            return r.status;
+        }
+    }
+    return Status::BadRequest;
+}
+
+// Blocking client for C++ tools (loadtest.cpp). queue() frames a request,
+// send() writes everything queued in one go, reply() reads the next answer.
+class EngineClient {
+private:
+    sock_t fd = BAD_SOCKET;
+    WalBuffer pending;
+    vector<char> last; // payload of the latest reply
+    uint32_t nextId = 1;
+
+public:
+    EngineClient() = default;
+    ~EngineClient() { if (fd != BAD_SOCKET) net_close(fd); }
+    EngineClient(const EngineClient&) = delete;
+    EngineClient& operator=(const EngineClient&) = delete;
+
+    bool connect(const string& address, string* err = nullptr) {
+        fd = net_connect(address, err);
+        return fd != BAD_SOCKET;
+    }
+
+    // fill(WalBuffer&) writes the payload; returns the request id
+    template<typename F>
+    uint32_t queue(ServerOp op, F fill) {
+        uint32_t id = nextId++;
+        size_t at = frame_begin(pending, id, (uint8_t)op);
+        fill(pending);
+        frame_end(pending, at);
+        return id;
+    }
+    uint32_t queue(ServerOp op) { return queue(op, [](WalBuffer&) {}); }
+
+    bool send() {
+        bool ok = net_send_all(fd, pending.bytes.data(), pending.size());
+        pending.clear();
+        return ok;
+    }
+
+    // payload stays readable until the next reply()
+    bool reply(uint32_t& id, Status& status, WalCursor& payload) {
+        char head[SERVER_FRAME_HEADER];
+        if (!net_recv_all(fd, head, sizeof(head))) return false;
+        uint32_t len;
+        memcpy(&len, head, 4);
+        memcpy(&id, head + 4, 4);
+        status = (Status)(uint8_t)head[8];
+        if (len < SERVER_FRAME_HEADER - 4 || len > SERVER_MAX_REPLY) return false;
+        last.resize(len - (SERVER_FRAME_HEADER - 4));
+        if (!last.empty() && !net_recv_all(fd, last.data(), last.size())) return false;
+        payload = WalCursor(last.data(), last.size());
+        return true;
+    }
+};
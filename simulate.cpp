@@ -0,0 +1,93 @@
+// simulate.cpp - lane capacity planning: Monte Carlo runs of a day's checkouts
+//   g++ -std=c++17 -O2 -pthread -o simulate.exe simulate.cpp
+//   .\simulate.exe [--cashiers 1-6] [--reps N] [--threads N] [--hours N]
+//                  [--arrivals 90,150,240,...] [--basket poisson:12|geometric:12|fixed:12]
+//                  [--special-share F] [--online-share F] [--packers N]
+//                  [--scan-seconds F] [--pay-seconds F] [--pack-seconds F] [--seed N]
+//
+// --arrivals gives customers per hour for each hour of the day (the last value
+// holds for the rest). One CSV row per cashier count: waits in seconds across
+// every replication, till utilisation, and minutes past closing until the
+// last customer is done. See simulate.h for the model.
+#include "simulate.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+static bool parse_basket(const string& v, BasketSize& b) {
+    size_t colon = v.find(':');
+    string kind = v.substr(0, colon);
+    if (colon != string::npos) b.mean = atof(v.c_str() + colon + 1);
+    if (kind == "poisson") b.kind = BasketSize::Poisson;
+    else if (kind == "geometric") b.kind = BasketSize::Geometric;
+    else if (kind == "fixed") b.kind = BasketSize::Fixed;
+    else return false;
+    return b.mean > 0;
+}
+
+static int usage() {
+    cerr << "usage: simulate [--cashiers 1-6] [--reps N] [--threads N] [--hours N]\n"
+            "                [--arrivals 90,150,240,...] [--basket poisson:12|geometric:12|fixed:12]\n"
+            "                [--special-share F] [--online-share F] [--packers N]\n"
+            "                [--scan-seconds F] [--pay-seconds F] [--pack-seconds F] [--seed N]\n";
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    int minCashiers = 1, maxCashiers = 6;
+    size_t reps = 100;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i += 2) {
+        string k = argv[i];
+        if (i + 1 == argc) { cerr << "missing value for " << k << '\n'; return usage(); }
+        string v = argv[i + 1];
+        if (k == "--cashiers") {
+            size_t dash = v.find('-');
+            minCashiers = max(1, atoi(v.c_str()));
+            maxCashiers = dash == string::npos ? minCashiers : max(minCashiers, atoi(v.c_str() + dash + 1));
+        }
+        else if (k == "--reps") reps = max(1, atoi(v.c_str()));
+        else if (k == "--threads") threads = (unsigned)max(0, atoi(v.c_str()));
+        else if (k == "--hours") cfg.hours = atof(v.c_str());
+        else if (k == "--arrivals") {
+            cfg.arrivals.perHour.clear();
+            stringstream ss(v);
+            string part;
+            while (getline(ss, part, ',')) cfg.arrivals.perHour.push_back(max(0.0, atof(part.c_str())));
+        }
+        else if (k == "--basket") { if (!parse_basket(v, cfg.basket)) { cerr << "bad basket " << v << '\n'; return 1; } }
+        else if (k == "--special-share") cfg.specialShare = atof(v.c_str());
+        else if (k == "--online-share") cfg.onlineShare = atof(v.c_str());
+        else if (k == "--packers") cfg.packers = max(0, atoi(v.c_str()));
+        else if (k == "--scan-seconds") cfg.scanSeconds = atof(v.c_str());
+        else if (k == "--pay-seconds") cfg.paySeconds = atof(v.c_str());
+        else if (k == "--pack-seconds") cfg.packSeconds = atof(v.c_str());
+        else if (k == "--seed") cfg.seed = strtoull(v.c_str(), nullptr, 10);
+        else { cerr << "unknown option " << k << '\n'; return usage(); }
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    uint64_t events = 0;
+    vector<SimLaneResult> res = CheckoutSimulator(cfg).run(minCashiers, maxCashiers, reps, threads, &events);
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    cout << "sim,metric,value\n";
+    cout << "sim,replications," << reps * res.size() << '\n';
+    cout << "sim,events," << events << '\n';
+    cout << "sim,seconds," << secs << '\n';
+    cout << "sim,events_per_sec," << (secs > 0 ? events / secs : 0) << '\n';
+    cout << "cashiers,served_per_day,wait_mean_s,wait_p50_s,wait_p90_s,wait_p95_s,wait_p99_s,wait_max_s,"
+            "special_p95_s,online_p95_s,utilisation,overtime_min\n";
+    for (const SimLaneResult& r : res) {
+        cout << r.cashiers << ',' << (double)r.customers / r.replications << ','
+             << r.wait.mean_ns() / 1000.0 << ',' << r.wait_p(50) << ',' << r.wait_p(90) << ','
+             << r.wait_p(95) << ',' << r.wait_p(99) << ',' << SimLaneResult::seconds(r.wait.max_ns()) << ','
+             << SimLaneResult::seconds(r.specialWait.percentile(95)) << ','
+             << SimLaneResult::seconds(r.onlineWait.percentile(95)) << ','
+             << r.utilisation << ',' << r.overtimeMinutes << '\n';
+    }
+    return 0;
+}
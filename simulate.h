@@ -0,0 +1,245 @@
+// simulate.h
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <future>
+#include <cmath>
+#include <cstdint>
+#include <climits>
+#include "system.h"
+#include "latency.h"
+#include "wave.h"
+using namespace std;
+
+// Discrete-event simulation of a trading day, for sizing the cashier count.
+// Arrivals and service are simulated, everything in between is the engine:
+// customers are registered, fill a cart, and are put in line by
+// enqueue_walkin_to_cashier (shortest line, special-needs customers to their
+// own lane) or place_online_order, and a lane that comes free takes its next
+// customer through the real checkout. So a change to the lane rules shows up
+// here without touching the simulator.
+//
+// Time only moves from one event to the next, taken off a binary min-heap.
+// Replications are independent engines, run in parallel on a WorkerPool.
+// Replication r of every cashier count sees the same arrivals and baskets
+// (the seed depends on r only), so counts are compared on equal terms.
+//
+// The online queue orders by priority; its aging and delivery slots run on
+// the wall clock, which barely moves during a simulated day.
+
+// customers per hour, hour by hour; the last entry holds for the rest of the day
+struct ArrivalProfile {
+    vector<double> perHour = {120};
+    double rate(double seconds) const {
+        size_t h = (size_t)(seconds / 3600.0);
+        return perHour.empty() ? 0.0 : perHour[min(h, perHour.size() - 1)];
+    }
+};
+
+// items per basket, never below 1
+struct BasketSize {
+    enum Kind { Fixed, Poisson, Geometric };
+    Kind kind = Poisson;
+    double mean = 12;
+
+    int draw(mt19937_64& rng) const {
+        if (kind == Fixed) return max(1, (int)lround(mean));
+        if (kind == Geometric) return 1 + geometric_distribution<int>(1.0 / max(1.0, mean))(rng);
+        return max(1, poisson_distribution<int>(mean)(rng));
+    }
+};
+
+struct SimConfig {
+    ArrivalProfile arrivals;
+    BasketSize basket;
+    double hours = 8;              // doors close after this; queued customers are still served
+    double specialShare = 0.05;    // of arrivals, to the special-needs lane
+    double onlineShare = 0.0;      // of arrivals, as online orders
+    double scanSeconds = 3;        // per item at a till
+    double paySeconds = 30;        // per customer at a till
+    double specialFactor = 1.5;    // special-needs service takes this much longer
+    int packers = 1;               // staff working the online queue
+    double packSeconds = 8;        // per item of an online order
+    uint64_t seed = 1;
+};
+
+// one cashier count over every replication; waits in seconds
+struct SimLaneResult {
+    int cashiers = 0;
+    size_t replications = 0;
+    uint64_t customers = 0;        // served, summed over replications
+    LatencyHistogram wait;         // walk-ins, in milliseconds (percentiles within 12.5%)
+    LatencyHistogram specialWait;
+    LatencyHistogram onlineWait;
+    double utilisation = 0;        // share of till time busy, regular cashiers
+    double overtimeMinutes = 0;    // mean time past closing until the last till is done
+
+    static double seconds(uint64_t ms) { return ms / 1000.0; }
+    double wait_p(double p) const { return seconds(wait.percentile(p)); }
+};
+
+class CheckoutSimulator {
+private:
+    enum EventKind : uint8_t { Arrival, LaneFree };
+    struct Event {
+        double t;
+        uint64_t seq;  // ties go in scheduling order
+        EventKind kind;
+        int lane;
+        bool operator<(const Event& o) const { return t > o.t || (t == o.t && seq > o.seq); } // min-heap
+    };
+    struct RunStats {
+        LatencyHistogram wait, specialWait, onlineWait;
+        uint64_t served = 0;
+        double busy = 0;       // till seconds, regular cashiers
+        double end = 0;        // last event
+        uint64_t events = 0;
+    };
+
+    SimConfig cfg;
+
+    // seconds to the next arrival after t, piecewise by hour (memoryless, so
+    // a draw that crosses the hour restarts at the boundary with the new rate)
+    static double next_arrival(const ArrivalProfile& a, double t, double close, mt19937_64& rng) {
+        while (t < close) {
+            double edge = min(close, (floor(t / 3600.0) + 1) * 3600.0);
+            double rate = a.rate(t) / 3600.0;
+            if (rate > 0) {
+                double next = t + exponential_distribution<double>(rate)(rng);
+                if (next < edge) return next;
+            }
+            t = edge;
+        }
+        return -1;
+    }
+
+    RunStats run_once(int cashierCount, uint64_t seed) const {
+        RunStats st;
+        SupermarketSystem sys(cashierCount);
+        sys.add_product(Product("SIM", "Simulated item", 1.0, INT_MAX, "2099-12-31", "Simulated"));
+        mt19937_64 rng(seed);
+        uniform_real_distribution<double> u(0.0, 1.0);
+        const double close = cfg.hours * 3600.0;
+        const int special = cashierCount, firstPacker = cashierCount + 1;
+        const int lanes = firstPacker + max(0, cfg.packers);
+        vector<bool> busy((size_t)lanes, false);
+        vector<double> arrivedAt;
+        vector<int> basketOf;
+        vector<Event> heap;
+        uint64_t seq = 0;
+        auto schedule = [&](double t, EventKind k, int lane) {
+            heap.push_back(Event{t, seq++, k, lane});
+            push_heap(heap.begin(), heap.end());
+        };
+        // an idle lane takes its next customer through the real checkout
+        auto serve = [&](int lane, double now) {
+            if (busy[(size_t)lane]) return;
+            CheckoutResult r = lane < special ? sys.process_checkout_at_cashier(lane)
+                             : lane == special ? sys.process_checkout_at_specialneedscashier()
+                             : sys.process_next_online_order();
+            if (r.status != Status::Ok) return;
+            size_t c = (size_t)stoull(r.customerId.substr(1));
+            double wait = now - arrivedAt[c];
+            double service;
+            if (lane < special) {
+                st.wait.record((uint64_t)llround(wait * 1000.0));
+                service = cfg.paySeconds + cfg.scanSeconds * basketOf[c];
+                st.busy += service;
+            } else if (lane == special) {
+                st.specialWait.record((uint64_t)llround(wait * 1000.0));
+                service = (cfg.paySeconds + cfg.scanSeconds * basketOf[c]) * cfg.specialFactor;
+            } else {
+                st.onlineWait.record((uint64_t)llround(wait * 1000.0));
+                service = cfg.packSeconds * basketOf[c];
+            }
+            st.served++;
+            sys.remove_customer(r.customerId);
+            busy[(size_t)lane] = true;
+            schedule(now + service, LaneFree, lane);
+        };
+
+        double first = next_arrival(cfg.arrivals, 0.0, close, rng);
+        if (first >= 0) schedule(first, Arrival, -1);
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end());
+            Event e = heap.back();
+            heap.pop_back();
+            st.events++;
+            st.end = e.t;
+            if (e.kind == LaneFree) {
+                busy[(size_t)e.lane] = false;
+                serve(e.lane, e.t);
+                continue;
+            }
+            size_t c = arrivedAt.size();
+            string id = "C" + to_string(c);
+            double kind = u(rng);
+            int items = cfg.basket.draw(rng);
+            arrivedAt.push_back(e.t);
+            basketOf.push_back(items);
+            if (kind < cfg.onlineShare) {
+                sys.add_online_customer(id, "Sim", "-", "card", 1 + (int)(rng() % 10));
+                sys.customer_add_to_cart(id, "SIM", items);
+                sys.place_online_order(id);
+                for (int p = firstPacker; p < lanes; ++p) serve(p, e.t);
+            } else {
+                if (kind < cfg.onlineShare + cfg.specialShare) sys.add_special_customer(id, "Sim");
+                else sys.add_walkin_customer(id, "Sim");
+                sys.customer_add_to_cart(id, "SIM", items);
+                EnqueueResult q = sys.enqueue_walkin_to_cashier(id);
+                serve(q.special ? special : stoi(q.laneId.substr(4)) - 1, e.t);
+            }
+            double next = next_arrival(cfg.arrivals, e.t, close, rng);
+            if (next >= 0) schedule(next, Arrival, -1);
+        }
+        return st;
+    }
+
+public:
+    explicit CheckoutSimulator(const SimConfig& c) : cfg(c) {}
+
+    // one result per cashier count in [minCashiers, maxCashiers]; replications
+    // of every count share one pool (threads = 0: one per core)
+    vector<SimLaneResult> run(int minCashiers, int maxCashiers, size_t replications, unsigned threads = 0,
+                              uint64_t* events = nullptr) const {
+        int counts = max(0, maxCashiers - minCashiers + 1);
+        vector<RunStats> runs((size_t)counts * replications);
+        {
+            WorkerPool pool(threads);
+            vector<future<void>> done;
+            for (int k = 0; k < counts; ++k)
+                for (size_t r = 0; r < replications; ++r) {
+                    RunStats* out = &runs[(size_t)k * replications + r];
+                    int cashiers = minCashiers + k;
+                    uint64_t seed = cfg.seed * 1000003u + r;
+                    done.push_back(pool.submit([this, out, cashiers, seed] { *out = run_once(cashiers, seed); }));
+                }
+            for (auto &f : done) f.get();
+        }
+        vector<SimLaneResult> res((size_t)counts);
+        const double close = cfg.hours * 3600.0;
+        if (events) *events = 0;
+        for (int k = 0; k < counts; ++k) {
+            SimLaneResult& out = res[(size_t)k];
+            out.cashiers = minCashiers + k;
+            out.replications = replications;
+            double busy = 0, open = 0, over = 0;
+            for (size_t r = 0; r < replications; ++r) {
+                const RunStats& s = runs[(size_t)k * replications + r];
+                out.wait.merge(s.wait);
+                out.specialWait.merge(s.specialWait);
+                out.onlineWait.merge(s.onlineWait);
+                out.customers += s.served;
+                busy += s.busy;
+                open += max(close, s.end) * out.cashiers;
+                over += max(0.0, s.end - close);
+                if (events) *events += s.events;
+            }
+            out.utilisation = open > 0 ? busy / open : 0;
+            out.overtimeMinutes = replications ? over / replications / 60.0 : 0;
+        }
+        return res;
+    }
+};
@@ -0,0 +1,147 @@
+// sketches.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include "sales.h"
+using namespace std;
+
+// 64-bit FNV-1a followed by the splitmix64 finaliser so short, similar ids
+// ("C101", "C102") still spread over all bits
+inline uint64_t sketch_hash(const string& s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ULL; }
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// HyperLogLog distinct counter with 2^12 registers: 4 KB per sketch, standard
+// error 1.04/sqrt(4096) ~ 1.6% (so ~3.2% at 95% confidence). Merging two
+// sketches (other lanes, other days) is a register-wise max.
+class HyperLogLog {
+private:
+    static const int P = 12;
+    static const int M = 1 << P;
+    uint8_t reg[M];
+
+public:
+    HyperLogLog() { clear(); }
+
+    void clear() { fill(reg, reg + M, 0); }
+
+    void add(const string& key) {
+        uint64_t h = sketch_hash(key);
+        uint32_t idx = (uint32_t)(h >> (64 - P));
+        uint64_t rest = h << P;
+        uint8_t rank = rest == 0 ? (uint8_t)(64 - P + 1) : (uint8_t)(__builtin_clzll(rest) + 1);
+        if (rank > reg[idx]) reg[idx] = rank;
+    }
+
+    void merge(const HyperLogLog& o) {
+        for (int i = 0; i < M; ++i) reg[i] = max(reg[i], o.reg[i]);
+    }
+
+    double estimate() const {
+        double sum = 0; int zeros = 0;
+        for (int i = 0; i < M; ++i) { sum += ldexp(1.0, -reg[i]); if (reg[i] == 0) ++zeros; }
+        double alpha = 0.7213 / (1.0 + 1.079 / M);
+        double e = alpha * M * M / sum;
+        if (e <= 2.5 * M && zeros != 0) e = M * log((double)M / zeros); // linear counting for small sets
+        return e;
+    }
+};
+
+// Relative-error quantile sketch (DDSketch-style log buckets). Any quantile of
+// values between 0.01 and ~10^8 is returned within 1% of the true value; memory
+// is a fixed array of counters, and merging is bucket-wise addition. Unlike
+// t-digest/KLL, removal is exact too, so voided bills can be taken back out.
+class QuantileSketch {
+private:
+    static constexpr double ALPHA = 0.01;
+    static constexpr double MIN_VALUE = 0.01;
+    static const int BUCKETS = 2048;
+    double gamma;
+    double logGamma;
+    vector<uint64_t> counts;
+    uint64_t zeroCount = 0; // values below MIN_VALUE (free orders)
+    uint64_t n = 0;
+
+    int bucket_of(double v) const {
+        int b = (int)ceil(log(v / MIN_VALUE) / logGamma);
+        return min(max(b, 0), BUCKETS - 1);
+    }
+
+public:
+    QuantileSketch() : counts(BUCKETS, 0) {
+        gamma = (1 + ALPHA) / (1 - ALPHA);
+        logGamma = log(gamma);
+    }
+
+    void add(double v, int64_t times = 1) {
+        if (v < MIN_VALUE) zeroCount += times;
+        else counts[bucket_of(v)] += times;
+        n += times;
+    }
+    void remove(double v) { add(v, -1); }
+
+    void merge(const QuantileSketch& o) {
+        for (int i = 0; i < BUCKETS; ++i) counts[i] += o.counts[i];
+        zeroCount += o.zeroCount;
+        n += o.n;
+    }
+
+    uint64_t count() const { return n; }
+    size_t heap_bytes() const { return heap_block(counts.capacity() * sizeof(uint64_t)); }
+
+    // q in [0,1]; returns 0 for an empty sketch
+    double quantile(double q) const {
+        if (n == 0) return 0.0;
+        uint64_t rank = (uint64_t)(q * (double)(n - 1));
+        if (rank < zeroCount) return 0.0;
+        uint64_t seen = zeroCount;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen > rank) return MIN_VALUE * 2.0 * pow(gamma, i) / (gamma + 1.0);
+        }
+        return MIN_VALUE * pow(gamma, BUCKETS - 1);
+    }
+};
+
+// Live numbers for one cashier lane; lanes and days combine with merge().
+struct LiveDashboard {
+    map<string, HyperLogLog> customersByHour; // "YYYY-MM-DD HH"
+    HyperLogLog skus;
+    QuantileSketch basketValue;
+
+    void on_sale(const SaleRecord& s) {
+        customersByHour[s.time.substr(0, 13)].add(s.customerId);
+        for (auto &it : s.items) skus.add(it.first);
+        basketValue.add(s.total);
+    }
+
+    // distinct counts can't forget a key, so only the basket value is taken back
+    void on_undo(const SaleRecord& s) { basketValue.remove(s.total); }
+
+    // the sketches are fixed-size, so nothing here is overhead but the map's nodes
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("dashboards");
+        m.elements = customersByHour.size() + 2;
+        typedef map<string, HyperLogLog>::value_type Hour;
+        account_nodes(m, customersByHour.size(), sizeof(Hour), sizeof(Hour) + 4 * sizeof(void*));
+        for (auto &kv : customersByHour) account_string(m, kv.first);
+        m.add(sizeof(HyperLogLog), sizeof(HyperLogLog));
+        m.add(basketValue.heap_bytes(), basketValue.heap_bytes());
+        return m;
+    }
+
+    void merge(const LiveDashboard& o) {
+        for (auto &kv : o.customersByHour) customersByHour[kv.first].merge(kv.second);
+        skus.merge(o.skus);
+        basketValue.merge(o.basketValue);
+    }
+};
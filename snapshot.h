@@ -0,0 +1,364 @@
+// snapshot.h
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include "inventory.h"
+#include "sales.h"
+#include "report.h"
+#include "changefeed.h"
+using namespace std;
+
+// Read-copy-update snapshots of the catalog and the sales ledger, so reports
+// can run on any thread while the engine thread keeps selling.
+//
+// The engine thread is the only writer. At every sale and voided bill (and
+// whenever it is asked to) it publishes a new immutable EngineVersion; a
+// reader pins the newest one and may walk it for as long as it likes. Versions
+// share whatever did not change: products sit in chunks of 16 rows that are
+// copied only when one of their rows changes, and the ledger is a persistent
+// list, newest first, whose tail every later version shares.
+//
+// Old versions are reclaimed by epochs. A reader announces the global epoch
+// before it loads the current version; the writer retires a replaced version
+// with the epoch of the moment it was swapped out, and frees it (with the
+// chunks only it still used) once every pinned reader announced a later epoch.
+// Readers never take a lock or touch a reference count, and the writer never
+// waits for them.
+const size_t SNAP_CHUNK = 16; // products per chunk
+const size_t SNAP_DIR = 256;  // chunks per directory
+
+// gen is the version a block was built for; older blocks are frozen
+struct ProductChunk { Product rows[SNAP_CHUNK]; uint64_t gen = 0; };
+struct ProductDir { ProductChunk* chunks[SNAP_DIR] = {}; uint64_t gen = 0; };
+
+// one ledger entry; shared by every version published after it
+struct LedgerNode {
+    SaleRecord sale;
+    shared_ptr<LedgerNode> next;
+    LedgerNode(const SaleRecord& s, shared_ptr<LedgerNode> n) : sale(s), next(move(n)) { sale.next = nullptr; }
+    // unlinks iteratively: a long ledger must not recurse once per node
+    ~LedgerNode() {
+        shared_ptr<LedgerNode> n = move(next);
+        while (n && n.use_count() == 1) n = move(n->next);
+    }
+};
+
+// One consistent view. Nothing in it changes while it is pinned.
+struct EngineVersion {
+    uint64_t version = 0;          // 1, 2, 3, ... in publish order
+    uint64_t feedSeq = 0;          // reflects every change event before this one
+    size_t productCount = 0;
+    vector<const ProductDir*> dirs;
+    shared_ptr<LedgerNode> ledger; // newest first
+    size_t saleCount = 0;
+
+    const Product& product(size_t i) const {
+        return dirs[i / (SNAP_CHUNK * SNAP_DIR)]->chunks[(i / SNAP_CHUNK) % SNAP_DIR]->rows[i % SNAP_CHUNK];
+    }
+    template<typename F> void for_each_product(F f) const {
+        for (size_t i = 0; i < productCount; ++i) f(product(i));
+    }
+    template<typename F> void for_each_sale(F f) const {
+        for (const LedgerNode* n = ledger.get(); n != nullptr; n = n->next.get()) f(n->sale);
+    }
+    vector<Product> products() const {
+        vector<Product> v; v.reserve(productCount);
+        for_each_product([&](const Product& p) { v.push_back(p); });
+        return v;
+    }
+    // pointers into this version, newest first; valid while it is pinned
+    vector<const SaleRecord*> sales() const {
+        vector<const SaleRecord*> v; v.reserve(saleCount);
+        for_each_sale([&](const SaleRecord& s) { v.push_back(&s); });
+        return v;
+    }
+};
+
+class SnapshotStore {
+public:
+    static const int MAX_READERS = 64;
+
+private:
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{0}; // 0 while nothing is pinned
+        atomic<bool> taken{false};
+    };
+    // blocks a version was the last to use, freed along with it
+    struct Garbage {
+        vector<ProductChunk*> chunks;
+        vector<ProductDir*> dirs;
+        void free() {
+            for (ProductChunk* c : chunks) delete c;
+            for (ProductDir* d : dirs) delete d;
+            chunks.clear(); dirs.clear();
+        }
+    };
+    struct Retired {
+        const EngineVersion* v;
+        uint64_t epoch; // swapped out in this epoch
+        Garbage garbage;
+    };
+    ReaderSlot readers[MAX_READERS];
+    alignas(64) atomic<uint64_t> epoch{1};
+    alignas(64) atomic<const EngineVersion*> current{nullptr};
+
+    // engine-thread state: the next version, built in place
+    FeedSubscriber changes;
+    vector<ProductDir*> dirs;
+    size_t productCount = 0;
+    unordered_map<string, size_t> slotOf; // barcode : product index
+    shared_ptr<LedgerNode> ledger;
+    size_t saleCount = 0;
+    bool dirty = true;
+    uint64_t building = 1;  // version number of the next publish
+    Garbage replaced;       // frozen blocks dropped since the last publish
+    vector<Retired> retired;
+    vector<ChangeEvent> batch;
+
+    // copy-on-write from the top: a frozen directory or chunk is copied before
+    // anything below it is touched; blocks built for this version change in place
+    Product& row(size_t i) {
+        ProductDir*& d = dirs[i / (SNAP_CHUNK * SNAP_DIR)];
+        if (d->gen != building) {
+            replaced.dirs.push_back(d);
+            d = new ProductDir(*d);
+            d->gen = building;
+        }
+        ProductChunk*& c = d->chunks[(i / SNAP_CHUNK) % SNAP_DIR];
+        if (c == nullptr) { c = new ProductChunk; c->gen = building; }
+        else if (c->gen != building) {
+            replaced.chunks.push_back(c);
+            c = new ProductChunk(*c);
+            c->gen = building;
+        }
+        return c->rows[i % SNAP_CHUNK];
+    }
+    void put_product(const Product& p) {
+        auto it = slotOf.find(p.barcode);
+        if (it != slotOf.end()) { row(it->second) = p; return; }
+        if (productCount % (SNAP_CHUNK * SNAP_DIR) == 0) { dirs.push_back(new ProductDir); dirs.back()->gen = building; }
+        slotOf.emplace(p.barcode, productCount);
+        row(productCount++) = p;
+    }
+    // drops every block: frozen ones wait for their readers, the rest go now
+    void drop_products() {
+        for (ProductDir* d : dirs) {
+            for (ProductChunk* c : d->chunks) {
+                if (c == nullptr) continue;
+                if (c->gen != building) replaced.chunks.push_back(c);
+                else delete c; // new since the last publish, so no reader can see it
+            }
+            if (d->gen != building) replaced.dirs.push_back(d);
+            else delete d;
+        }
+        dirs.clear(); slotOf.clear(); productCount = 0;
+    }
+    void rescan_products(const Inventory& inv) {
+        drop_products();
+        for (auto &p : inv.all_products()) put_product(p);
+    }
+    // brings the products up to date with the change feed; a lap, a cut key or
+    // a Resync means rereading the whole catalog
+    void apply_changes(const Inventory& inv) {
+        bool rescan = false;
+        for (;;) {
+            bool lapped = false;
+            size_t n = changes.poll(batch.data(), batch.size(), &lapped);
+            rescan = rescan || lapped;
+            if (n == 0) break;
+            dirty = true;
+            for (size_t i = 0; i < n && !rescan; ++i) {
+                const ChangeEvent& e = batch[i];
+                if (e.type == ChangeType::Resync) rescan = true;
+                else if (e.type != ChangeType::StockChanged && e.type != ChangeType::ProductAdded) continue;
+                else if (e.key_truncated()) rescan = true;
+                else if (const Product* p = inv.peek(string(e.key_view()))) put_product(*p);
+            }
+        }
+        if (rescan) { rescan_products(inv); dirty = true; }
+    }
+    void reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for (auto &r : readers) {
+            uint64_t e = r.epoch.load();
+            if (e != 0) oldest = min(oldest, e);
+        }
+        size_t freed = 0;
+        while (freed < retired.size() && retired[freed].epoch < oldest) {
+            delete retired[freed].v;
+            retired[freed].garbage.free();
+            freed++;
+        }
+        retired.erase(retired.begin(), retired.begin() + freed);
+    }
+
+public:
+    // feed must be the one the engine's inventory publishes to
+    SnapshotStore(const ChangeFeed& feed, const Inventory& inv) : changes(feed), batch(1024) {
+        rescan_products(inv);
+    }
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+    // every reader must be gone by now
+    ~SnapshotStore() {
+        delete current.load();
+        for (auto &r : retired) { delete r.v; r.garbage.free(); }
+        building++; // everything left is frozen, so drop_products hands it all over
+        drop_products();
+        replaced.free();
+    }
+
+    // ---- engine thread ----
+    void on_sale(const SaleRecord& s) {
+        ledger = make_shared<LedgerNode>(s, ledger);
+        saleCount++;
+        dirty = true;
+    }
+    // copies the entries newer than the voided one; older ones stay shared
+    void on_void(const string& saleId) {
+        vector<const LedgerNode*> newer;
+        const LedgerNode* n = ledger.get();
+        while (n != nullptr && n->sale.saleId != saleId) { newer.push_back(n); n = n->next.get(); }
+        if (n == nullptr) return;
+        shared_ptr<LedgerNode> rest = n->next;
+        for (size_t i = newer.size(); i-- > 0;) rest = make_shared<LedgerNode>(newer[i]->sale, move(rest));
+        ledger = move(rest);
+        saleCount--;
+        dirty = true;
+    }
+    // replaces the ledger (recovery, close of day); newestFirst as SalesList::ledger()
+    void load_ledger(const vector<const SaleRecord*>& newestFirst) {
+        ledger.reset();
+        for (size_t i = newestFirst.size(); i-- > 0;) ledger = make_shared<LedgerNode>(*newestFirst[i], move(ledger));
+        saleCount = newestFirst.size();
+        dirty = true;
+    }
+    // swaps in a new version if anything changed since the last one
+    bool publish(const Inventory& inv) {
+        apply_changes(inv);
+        if (!dirty) return false;
+        EngineVersion* v = new EngineVersion;
+        v->version = building++;
+        v->feedSeq = changes.position();
+        v->productCount = productCount;
+        v->dirs.assign(dirs.begin(), dirs.end());
+        v->ledger = ledger;
+        v->saleCount = saleCount;
+        const EngineVersion* old = current.exchange(v);
+        // blocks replaced while v was built were last seen by old
+        if (old) retired.push_back(Retired{old, epoch.fetch_add(1), move(replaced)});
+        else replaced.free();
+        replaced = Garbage();
+        reclaim();
+        dirty = false;
+        return true;
+    }
+    size_t retired_versions() const { return retired.size(); } // waiting for readers
+
+    // engine thread. The version being built and the ledger; blocks and versions
+    // waiting for readers to move on, and unused rows of a chunk, are overhead.
+    // Ledger entries older versions no longer share are not counted.
+    MemoryUsage memory_usage() const {
+        MemoryUsage m("snapshots");
+        m.elements = productCount + saleCount;
+        m.add(0, heap_block(dirs.capacity() * sizeof(ProductDir*)));
+        account_nodes(m, dirs.size(), 0, sizeof(ProductDir));
+        size_t rowBase = 0;
+        for (const ProductDir* d : dirs) {
+            for (const ProductChunk* c : d->chunks) {
+                if (c != nullptr) {
+                    size_t used = min(SNAP_CHUNK, productCount > rowBase ? productCount - rowBase : 0);
+                    account_nodes(m, 1, used * sizeof(Product), sizeof(ProductChunk));
+                    for (size_t i = 0; i < used; ++i) account_product(m, c->rows[i]);
+                }
+                rowBase += SNAP_CHUNK;
+            }
+        }
+        account_hash(m, slotOf);
+        for (auto &kv : slotOf) account_string(m, kv.first);
+        // make_shared puts the control block (two counts, a vtable) next to the node
+        for (const LedgerNode* n = ledger.get(); n != nullptr; n = n->next.get()) {
+            account_nodes(m, 1, sizeof(SaleRecord), sizeof(LedgerNode) + 16);
+            account_sale(m, n->sale);
+        }
+        size_t frozen = replaced.chunks.size(), frozenDirs = replaced.dirs.size();
+        for (auto &r : retired) { frozen += r.garbage.chunks.size(); frozenDirs += r.garbage.dirs.size(); }
+        account_nodes(m, frozen, 0, sizeof(ProductChunk));
+        account_nodes(m, frozenDirs, 0, sizeof(ProductDir));
+        account_nodes(m, retired.size() + (current.load() ? 1 : 0), 0, sizeof(EngineVersion));
+        m.add(0, heap_block(batch.capacity() * sizeof(ChangeEvent)));
+        return m;
+    }
+
+    // ---- readers ----
+    // a slot per reader thread; waits while all MAX_READERS are taken
+    int register_reader() {
+        for (;;) {
+            for (int i = 0; i < MAX_READERS; ++i) {
+                bool expected = false;
+                if (readers[i].taken.compare_exchange_strong(expected, true)) return i;
+            }
+            this_thread::yield();
+        }
+    }
+    void unregister_reader(int slot) {
+        readers[slot].epoch.store(0);
+        readers[slot].taken.store(false);
+    }
+    const EngineVersion* enter(int slot) {
+        readers[slot].epoch.store(epoch.load());
+        return current.load();
+    }
+    void exit(int slot) { readers[slot].epoch.store(0, memory_order_release); }
+};
+
+// A pinned version; unpins when it goes away.
+class SnapshotPin {
+private:
+    SnapshotStore* store;
+    int slot;
+    const EngineVersion* v;
+public:
+    SnapshotPin(SnapshotStore& s, int sl) : store(&s), slot(sl), v(s.enter(sl)) {}
+    SnapshotPin(SnapshotPin&& o) : store(o.store), slot(o.slot), v(o.v) { o.store = nullptr; }
+    SnapshotPin(const SnapshotPin&) = delete;
+    SnapshotPin& operator=(const SnapshotPin&) = delete;
+    ~SnapshotPin() { if (store) store->exit(slot); }
+
+    const EngineVersion& operator*() const { return *v; }
+    const EngineVersion* operator->() const { return v; }
+};
+
+// One per reader thread, holding one pin at a time.
+class SnapshotReader {
+private:
+    SnapshotStore& store;
+    int slot;
+public:
+    explicit SnapshotReader(SnapshotStore& s) : store(s), slot(s.register_reader()) {}
+    ~SnapshotReader() { store.unregister_reader(slot); }
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    SnapshotPin pin() { return SnapshotPin(store, slot); }
+};
+
+// ---- reports over a pinned version ----
+inline SalesReport snapshot_sales_report(const EngineVersion& v) {
+    unordered_map<string,string> categoryOf;
+    v.for_each_product([&](const Product& p) { categoryOf[p.barcode] = p.category; });
+    return ReportEngine(categoryOf).run(v.sales());
+}
+
+// cheapest first; equal prices keep their catalog order
+inline vector<Product> snapshot_sorted_by_price(const EngineVersion& v) {
+    vector<Product> sorted = v.products();
+    stable_sort(sorted.begin(), sorted.end(), [](const Product& a, const Product& b) { return a.price < b.price; });
+    return sorted;
+}
@@ -22,6 +22,8 @@ class MyStack {
                 pop();
             }
         }
+        // one allocation of this size per element
+        static size_t node_bytes() { return sizeof(Node); }
         bool isEmpty() const {
             if (topNode == nullptr){
                 return true;
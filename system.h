@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include "queue.h"
+#include "stack.h"
 #include "priority_queue.h"
 #include <unordered_map>
 #include <limits>
@@ -12,40 +13,40 @@
 #include "bst.h"
 #include "sales.h"
 #include "customer.h"
+#include "report.h"
+#include "archive.h"
+#include "basket.h"
+#include "history.h"
+#include "sketches.h"
+#include "results.h"
+#include "wal.h"
+#include "catalog.h"
+#include "snapshot.h"
+#include "wave.h"
+#include "scheduler.h"
+#include "audit.h"
+#include "scan.h"
+#include <fstream>
+#include <deque>
 using namespace std;
 
 struct Cashier {
     string id;
-    MyQueue<Customer*> q;
-    MyQueue<SpecialCustomer*> specialNeedsQueue;
+    // a visit that ends elsewhere leaves its entry behind; checkout skips it
+    MyQueue<VisitRef> q;
+    MyQueue<VisitRef> specialNeedsQueue;
     MyStack<SaleRecord*> undoStack;
+    LiveDashboard dash;
     Cashier() = default;
     Cashier(const string& i){
         id = i;
     }
 };
 
-struct OnlineOrder {
-    OnlineCustomer* customer;
-    OnlineOrder() { 
-        customer = nullptr;
-        placed_time = 0; 
-        priority = 0;
-    }
-    time_t placed_time;
-    int priority; // lower = higher priority
-    OnlineOrder(OnlineCustomer* c, int p){
-        customer = c;
-        placed_time = time(nullptr);
-        priority = p;
-    }
-};
-
-struct OnlineOrderCompare {
-    bool operator()(const OnlineOrder& a, const OnlineOrder& b) const {
-        if (a.priority != b.priority) return a.priority > b.priority;
-        return a.placed_time > b.placed_time;
-    }
+// who waits at one lane, in serving order
+struct LaneView {
+    string laneId;
+    vector<CustomerNo> waiting;
 };
 
 class SupermarketSystem {
@@ -54,13 +55,45 @@ private:
     ProductBST bst;
     ProductBSTByCategory bstbycategory;
     SalesList sales;
+    BasketGraph basket;
+    CustomerIndex history;
+    LiveDashboard onlineDash;
     vector<unique_ptr<Cashier>> cashiers;
     unique_ptr<Cashier> specialNeedsCashier;
-    unordered_map<string, unique_ptr<Customer>> customers;
-    MyPriorityQueue<OnlineOrder, OnlineOrderCompare> onlineQueue;
+    CustomerRegistry customers;
+    OnlineScheduler onlineQueue;
+    StockBook stockBook;
 
 
     int nextSale = 1;
+    unique_ptr<WriteAheadLog> wal; // null unless open_wal() was called
+    string walDir;
+    unique_ptr<ChangeFeed> feed;   // null unless enable_change_feed() was called
+    unique_ptr<SnapshotStore> snaps; // null unless enable_snapshots() was called
+    unique_ptr<SnapshotReader> consoleReader;
+    unique_ptr<WorkerPool> wavePool;  // built by the first fulfil_online_waves
+
+    SaleRecord* record_sale(CustomerNo c, Cashier* lane, double tot, Status& logged);
+    bool next_online_order(int64_t now, ScheduledOrder& o);
+    SaleRecord* add_sale_record(CustomerNo c, Cashier* lane, const vector<pair<string,int>>& items, double tot);
+    bool take_wave(size_t n, Wave& w, size_t& skipped);
+    void commit_wave(Wave& w, WaveStats& st);
+    bool next_in_queue(MyQueue<VisitRef>& q, CustomerNo& c);
+    void checkout_customer(CustomerNo c, Cashier* lane, const string& coupon, CheckoutResult& r);
+    bool void_sale(SaleRecord* s, Cashier* lane, Status& logged);
+    void index_sale(const SaleRecord* s, Cashier* lane);
+    void log_stock(const string& barcode, int delta, const string& holder);
+    void open_audit_period();
+    void maybe_checkpoint() { if (wal && wal->checkpoint_due()) checkpoint(); }
+    void publish(ChangeType t, const string& key, int delta = 0, long long amount = 0) {
+        if (feed) feed->publish(t, key, delta, 0, amount);
+    }
+    // engine thread only: publishes what changed, then pins it for the console
+    SnapshotPin pin_current() {
+        if (!consoleReader) consoleReader = make_unique<SnapshotReader>(*snaps);
+        snaps->publish(inventory);
+        return consoleReader->pin();
+    }
 
 public:
     SupermarketSystem(int cashierCount = 3) {
@@ -74,396 +107,1026 @@ public:
     void seed_data();
     void rebuild_bst();
 
-    bool add_walkin_customer(const string& id, const string& name);
-    bool add_online_customer(const string& id, const string& name, const string& addr, const string& pay, int priority = 5);
-    Customer* get_customer(const string& id);
-    void list_customers() const;
+    // Engine API: explicit parameters in, status + data out, no console I/O.
+    Status add_product(const Product& p);
+    Status add_walkin_customer(const string& id, const string& name);
+    Status add_special_customer(const string& id, const string& name);
+    Status add_online_customer(const string& id, const string& name, const string& addr, const string& pay, int priority = 5);
+    CustomerNo find_customer(const string& id) const { return customers.find(id); }
+    const CustomerRegistry& customer_registry() const { return customers; }
+    const CustomerHistory* get_customer_history(const string& id) const { return history.find_history(id); }
+    LoyaltyTier get_loyalty_tier(const string& id) const { return history.tier(id); }
+    int effective_online_priority(CustomerNo c) const;
 
-    bool customer_add_to_cart(const string& custId, const string& barcode, int qty);
-    pair<bool,string> customer_undo(const string& custId);
+    CartResult customer_add_to_cart(const string& custId, const string& barcode, int qty);
+    // A scanner stream (scan.h) into the customer's cart: reads are checked
+    // and packed a batch at a time, and each code read in a batch is one cart
+    // add for all its reads. Runs to the end of the stream.
+    ScanIngest scan_into_cart(const string& custId, ScanReader& in, size_t batch = 4096);
+    CartResult customer_remove_from_cart(const string& custId, const string& barcode, int qty);
+    CartUndoResult customer_undo(const string& custId);
 
-    void show_customer_cart(const string& custId);
+    // Visits: a visit opens with begin_session, or with the first cart add,
+    // and ends at checkout or end_session. Its cart lines, undo history and
+    // their text sit in one arena that goes back to the pool when it ends.
+    // end_session abandons the cart: the goods return to the shelf and any
+    // place in a queue lapses. forget also drops the customer from the
+    // registry and their purchase history (walk-ins who will not be back).
+    Status begin_session(const string& custId);
+    SessionEndResult end_session(const string& custId, bool forget = false);
+    Status remove_customer(const string& custId) { return end_session(custId, true).status; }
+
+    EnqueueResult enqueue_walkin_to_cashier(const string& custId);
+    EnqueueResult enqueue_specialneeds_to_cashier(CustomerNo c);
+    // deliverBy: end of the delivery slot promised (unix time); 0 = the next
+    // slot open for booking (SchedulerOptions)
+    EnqueueResult place_online_order(const string& custId, time_t deliverBy = 0);
+    size_t cashier_queue_length(int cashierIndex) const;
+    size_t special_queue_length() const { return specialNeedsCashier->specialNeedsQueue.size(); }
+    size_t online_queue_length() const { return onlineQueue.size(); }
+    // aging, urgency window and delivery slots of the online queue (scheduler.h)
+    void set_online_scheduling(const SchedulerOptions& o) { onlineQueue.set_options(o); }
+    const SchedulerStats& online_schedule_stats() const { return onlineQueue.stats(); }
+
+    CheckoutResult process_checkout_at_cashier(int cashierIndex, const string& coupon = "");
+    CheckoutResult process_checkout_at_specialneedscashier(const string& coupon = "");
+    CheckoutResult process_next_online_order(const string& coupon = "");
+    // Wave picking (wave.h): online orders in waves of waveSize by priority,
+    // each wave's pick list built on worker threads while the engine thread
+    // takes the next wave and commits the last one's sales as one batch.
+    // onWave sees each wave once it is committed. No coupons; bills undo at
+    // cashier 1 like any online order.
+    WaveStats fulfil_online_waves(size_t waveSize, size_t maxWaves = SIZE_MAX, unsigned threads = 0,
+                                  const function<void(const Wave&)>& onWave = nullptr);
+    BillUndoResult cashier_undo_last_bill(int cashierIndex);
+    BillUndoResult cashier_undo_last_specialneedscashier_bill();
+
+    // Read views (the console and server.h); pointers stay valid until the
+    // next call that changes the engine.
+    vector<Product> products_sorted_by_price();
+    vector<Product> products_sorted_by_category();
+    vector<CustomerNo> customer_list() const; // by number; removed numbers are reused
+    vector<LaneView> queue_status() const; // cashiers, SPECIAL, then ONLINE
+    SalesReport sales_report() const;
+    vector<const SaleRecord*> sales_ledger() const { return sales.ledger(); }
+    int cashier_count() const { return (int)cashiers.size(); }
+    // Stock reconciliation (audit.h): every SKU moved since the catalog was
+    // loaded must balance against its shelf stock, the open carts and the
+    // ledger. Read-only; threads = 0: one per core.
+    StockAudit audit_stock(unsigned threads = 0) const;
+    vector<CartHold> open_cart_holds() const;
+    // Heap held by each structure: bytes, elements and the overhead among
+    // those bytes (memory.h). Walks everything; meant for the console and for
+    // capacity planning, not the hot path.
+    MemoryReport memory_report() const;
 
-    void enqueue_walkin_to_cashier(const string& custId);
-    void enqueue_specialneeds_to_cashier(SpecialCustomer* sc);
-    void place_online_order(const string& custId);
-
-    void process_checkout_at_cashier(int cashierIndex);
-    void process_checkout_at_specialneedscashier();
-    void process_next_online_order();
-    void cashier_undo_last_bill(int cashierIndex);
-    void cashier_undo_last_specialneedscashier_bill();
-    
-
-    void print_inventory() const;
-    void print_products_sorted_price();
-    void print_products_sorted_category();
-    void print_sales_report();
+    // Console views
+    void list_customers() const;
+    void print_customer_history(const string& id) const;
+    void show_customer_cart(const string& custId);
+    // Listings take a window of rows, so a page formats only the rows it
+    // shows, and a sink (output.h); by default all of it goes to the console.
+    size_t product_count(); // rows in the product listings
+    void print_inventory(RowWindow w = RowWindow(), const OutputSink& sink = console_sink());
+    void print_products_sorted_price(RowWindow w = RowWindow(), const OutputSink& sink = console_sink());
+    void print_products_sorted_category(RowWindow w = RowWindow(), const OutputSink& sink = console_sink());
+    void print_sales_report(const OutputSink& sink = console_sink());
+    LiveDashboard live_dashboard() const;
+    void print_live_dashboard() const;
+    void print_stock_audit() const;
+    void print_bought_together(const string& barcode, size_t k = 5) const;
+    void rebuild_basket_stats();
     void print_cashiers_status() const;
 
+    string close_day(const string& dir);
+    void print_archive_report(const string& path);
+    bool export_archive(const string& archivePath, const string& outPath, bool json);
+
+    // Durability: call open_wal right after construction. An existing log in
+    // dir is recovered first (replacing the seeded catalog); from then on every
+    // stock move, sale and voided bill is logged, with periodic snapshots.
+    // A log that fails to write stops taking commits: checkouts and bill
+    // undos answer LogFailed until a checkpoint succeeds. One whose own commit
+    // failed went through in memory, but is not on disk.
+    bool open_wal(const string& dir, const WalOptions& opt = WalOptions(), RecoveryStats* stats = nullptr, string* err = nullptr);
+    bool checkpoint();
+    bool log_failed() const { return wal && wal->failed_io(); }
+
+    // Catalog files (CSV or binary .smc, see catalog.h). replace=true drops the
+    // current catalog first; meant for startup, before any carts exist.
+    bool import_catalog(const string& path, CatalogLoadStats& st, bool replace = true, string* err = nullptr);
+    bool export_catalog(const string& path) const { return write_catalog(path, inventory.all_products()); }
+    // starts over from a catalog shared with other stores (chain.h); like
+    // import_catalog with replace=true
+    void use_shared_catalog(shared_ptr<const SharedCatalog> c);
+    // Stock that enters or leaves the shelf outside a cart or sale (deliveries,
+    // transfers between stores). OutOfStock if delta would take it below zero.
+    Status adjust_stock(const string& barcode, int delta);
+
+    // Change feed (changefeed.h): stock moves, new products, sales and voided
+    // bills as numbered events. Enable it right after construction, before
+    // any subscriber thread starts.
+    ChangeFeed& enable_change_feed(size_t capacity = 1 << 16) {
+        if (!feed) feed = make_unique<ChangeFeed>(capacity);
+        inventory.set_feed(feed.get());
+        return *feed;
+    }
+    ChangeFeed* change_feed() const { return feed.get(); }
+
+    // Snapshots (snapshot.h): immutable versions of the catalog and the ledger
+    // that reports on other threads pin without ever holding up a sale. Turns
+    // the change feed on. A new version goes out at every sale and voided bill
+    // and whenever the engine thread calls publish_snapshot (the server does
+    // after each round of requests).
+    SnapshotStore& enable_snapshots() {
+        if (!snaps) {
+            snaps = make_unique<SnapshotStore>(enable_change_feed(), inventory);
+            snaps->load_ledger(sales.ledger());
+            snaps->publish(inventory);
+        }
+        return *snaps;
+    }
+    SnapshotStore* snapshots() const { return snaps.get(); }
+    void publish_snapshot() { if (snaps) snaps->publish(inventory); }
+
     Inventory& get_inventory() { return inventory; }
 
     void interactive_console();
 };
 
 // Implementations (kept in header for simplicity)
-inline void SupermarketSystem::seed_data() {
-    //diary products
-    inventory.add_product(Product("0001","Milk 1L",45.0,50,"2025-12-01","Dairy"));
-    inventory.add_product(Product("0008","Cheese 200g",125.0,35,"2026-02-01","Dairy"));
-    inventory.add_product(Product("0012","Butter 250g",170.5,30,"2026-04-01","Dairy"));
-    inventory.add_product(Product("0009","Yogurt 150g",45.5,80,"2026-03-01","Dairy"));
-    inventory.add_product(Product("0014","Cream 200ml",70.99,40,"2026-05-01","Dairy"));
-    inventory.add_product(Product("0028","Ice Cream 500ml",172.5,25,"2026-06-01","Dairy"));
-    //meet products
-    inventory.add_product(Product("0006","Chicken Breast 1kg",185.0,25,"2025-12-15","Meat"));
-    inventory.add_product(Product("0015","Ground Beef 500g",250.0,20,"2025-12-10","Meat"));
-    inventory.add_product(Product("0016","tuna 1kg",285.0,15,"2025-12-20","Meat"));
-    inventory.add_product(Product("0024","Salmon Fillet 500g",490.0,10,"2025-12-18","Meat"));
-    inventory.add_product(Product("0025","Turkey Slices 300g",380.0,18,"2025-12-22","Meat"));
-    inventory.add_product(Product("0026","Sausages 500g",230.0,22,"2025-12-25","Meat"));
-    inventory.add_product(Product("0027","Lamb Chops 500g",280.0,8,"2025-12-30","Meat"));
-    //school products
-    inventory.add_product(Product("0017","Notebook A4 120pg",60.9,100,"2027-12-31","School"));
-    inventory.add_product(Product("0018","Pen Blue Ink",10.0,200,"2027-12-31","School"));
-    inventory.add_product(Product("0019","Eraser",5.0,150,"2027-12-31","School"));
-    inventory.add_product(Product("0020","Ruler 30cm",25.0,80,"2027-12-31","School"));
-    inventory.add_product(Product("0021","Backpack",250.0,40,"2027-12-31","School"));
-    inventory.add_product(Product("0022","Calculator",1500.0,60,"2027-12-31","School"));
-    inventory.add_product(Product("0023","Highlighter Set",30.5,70,"2027-12-31","School"));
-    //produce products
-    inventory.add_product(Product("0004","Apple 1kg",85.0,20,"2025-11-30","Produce"));
-    inventory.add_product(Product("0012","Lettuce",15.0,50,"2025-11-28","Produce"));
-    inventory.add_product(Product("0019","Carrots 1kg",15.0,60,"2025-12-05","Produce"));
-    inventory.add_product(Product("0020","Potatoes 2kg",25.0,70,"2025-12-10","Produce"));
-    inventory.add_product(Product("0029","Grapes 500g",28.0,40,"2025-11-29","Produce"));
-    inventory.add_product(Product("0030","Strawberries 250g",32.0,30,"2025-11-27","Produce"));
-    inventory.add_product(Product("0031","Cucumbers",12.0,55,"2025-12-03","Produce"));
-    inventory.add_product(Product("0032","Bell Peppers 1kg",40.0,45,"2025-12-07","Produce"));
-    //cleaning products
-    inventory.add_product(Product("0033","Dish Soap 500ml",85.5,80,"2027-12-31","Cleaning"));
-    inventory.add_product(Product("0034","Laundry Detergent 1L",50.0,60,"2027-12-31","Cleaning"));
-    inventory.add_product(Product("0035","All-Purpose Cleaner 750ml",35.0,70,"2027-12-31","Cleaning"));
-    inventory.add_product(Product("0036","Sponges 5pc",18.0,90,"2027-12-31","Cleaning"));
-    inventory.add_product(Product("0037","Paper Towels 2rolls",22.0,50,"2027-12-31","Cleaning"));
-    inventory.add_product(Product("0038","Trash Bags 30pc",40.0,40,"2027-12-31","Cleaning"));
-    //beverages products
-    inventory.add_product(Product("0039","Coffee 250g",250.0,30,"2026-12-31","Beverages"));
-    inventory.add_product(Product("0040","Tea Bags 100pc",30.0,50,"2026-12-31","Beverages"));
-    inventory.add_product(Product("0041","Soda 330ml",15.0,70,"2025-12-31","Beverages"));
-    inventory.add_product(Product("0042","Bottled Water 500ml",8.0,100,"2025-12-31","Beverages"));
-    inventory.add_product(Product("0043","Energy Drink 250ml",20.0,40,"2025-12-31","Beverages"));
-    //snack products
-    inventory.add_product(Product("0044","Chips 200g",25.0,60,"2026-06-30","Snacks"));
-    inventory.add_product(Product("0045","Chocolate Bar 100g",30.0,80,"2026-05-31","Snacks"));
-    inventory.add_product(Product("0046","Cookies 150g",20.0,70,"2026-07-15","Snacks"));
-    inventory.add_product(Product("0047","Nuts chocolate Mix 250g",40.0,50,"2026-08-31","Snacks"));
-    inventory.add_product(Product("0048","Granola Bars 6pc",50.0,90,"2026-09-30","Snacks"));
-    inventory.add_product(Product("0049","Popcorn 100g",15.0,100,"2026-04-30","Snacks"));
-    inventory.add_product(Product("0050","Dried Fruit 200g",75.0,40,"2026-10-31","Snacks"));
-    inventory.add_product(Product("0051","Pretzels 150g",18.0,75,"2026-11-30","Snacks"));
-    //self care products
-    inventory.add_product(Product("0052","Shampoo 500ml",200.5,60,"2027-12-31","Self Care"));
-    inventory.add_product(Product("0053","Conditioner 400ml",120.0,55,"2027-12-31","Self Care"));
-    inventory.add_product(Product("0054","Body Wash 500ml",80.0,70,"2027-12-31","Self Care"));
-    inventory.add_product(Product("0055","Toothpaste 150g",45.0,80,"2027-12-31","Self Care"));
-    inventory.add_product(Product("0056","Deodorant 200ml",80.0,50,"2027-12-31","Self Care"));
-    //household products
-    inventory.add_product(Product("0057","Toilet Paper 12rolls",50.0,40,"2027-12-31","Household"));
-    inventory.add_product(Product("0058","Facial Tissues 4packs",30.0,70,"2027-12-31","Household"));
-    inventory.add_product(Product("0059","Hand Soap 300ml",30.0,90,"2027-12-31","Household"));
-    inventory.add_product(Product("0060","Air Freshener 250ml",40.0,50,"2027-12-31","Household"));
-    inventory.add_product(Product("0061","Light Bulbs 2pc",35.0,60,"2027-12-31","Household"));
-    inventory.add_product(Product("0062","Batteries AA 4pc",40.0,80,"2027-12-31","Household"));
-    inventory.add_product(Product("0063","Extension Cord 3m",7.0,30,"2027-12-31","Household"));
-    //food staples products
-    inventory.add_product(Product("0064","Pasta 500g",40.5,70,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0065","Canned Beans 400g",26.0,80,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0066","Canned Tuna 200g",50.0,60,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0067","Olive Oil 1L",80.0,40,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0068","Flour 1kg",25.0,50,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0069","Sugar 1kg",20.0,60,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0070","Salt 500g",10.0,90,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0071","Baking Powder 200g",18.0,70,"2027-12-31","Food Staples"));
-    inventory.add_product(Product("0072","Yeast 100g",15.0,80,"2027-12-31","Food Staples"));
-    //toys products
-    inventory.add_product(Product("0073","Action Figure",400.0,30,"2028-12-31","Toys"));
-    inventory.add_product(Product("0074","Doll",380.0,25,"2028-12-31","Toys"));
-    inventory.add_product(Product("0075","Puzzle 500pc",250.0,40,"2028-12-31","Toys"));
-    inventory.add_product(Product("0076","Board Game",150.0,20,"2028-12-31","Toys"));
-    inventory.add_product(Product("0077","Remote Control Car",250.0,15,"2028-12-31","Toys"));
-    inventory.add_product(Product("0101","LEGO Building Blocks Set",300.0,18,"2028-12-31","Toys"));
-    inventory.add_product(Product("0102","Stuffed Animal",120.0,50,"2028-12-31","Toys"));
-    //electronics products
-    inventory.add_product(Product("0078","Headphones",600.0,20,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0079","Portable Charger 65W",400.0,25,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0080","USB Flash Drive 128GB",600.0,30,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0081","Wireless Mouse",380.0,40,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0082","Keyboard",180.0,35,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0083","Webcam",400.0,15,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0084","Bluetooth Speaker",350.0,20,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0085","Smartwatch",1500.0,10,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0086","Fitness Tracker",500.0,15,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0087","E-reader",380.0,8,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0088","Tablet",8700.0,12,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0089","Iphone 13 pro max",39900.0,20,"2028-12-31","Electronics"));
-    inventory.add_product(Product("0090","Laptop",69999.0,10,"2028-12-31","Electronics"));
-    //sports products
-    inventory.add_product(Product("0091","Football",380.0,25,"2027-12-31","Sports"));
-    inventory.add_product(Product("0092","Basketball",220.0,30,"2027-12-31","Sports"));
-    inventory.add_product(Product("0093","Tennis Racket",500.0,15,"2027-12-31","Sports"));
-    inventory.add_product(Product("0094","Yoga Mat",180.0,40,"2027-12-31","Sports"));
-    inventory.add_product(Product("0095","Dumbbell Set",720.0,10,"2027-12-31","Sports"));
-    inventory.add_product(Product("0096","Jump Rope",80.0,50,"2027-12-31","Sports"));
-    inventory.add_product(Product("0097","Cycling Helmet",450.0,20,"2027-12-31","Sports"));
-    //bakery products
-    inventory.add_product(Product("0098","Bagels 6pc",30.0,40,"2025-10-05","Bakery"));
-    inventory.add_product(Product("0099","Muffins",40.0,35,"2025-10-03","Bakery"));
-    inventory.add_product(Product("0100","Croissants 3pc",35.0,30,"2025-10-04","Bakery"));
-    inventory.add_product(Product("0002","Bread",2.0,100,"2025-10-01","Bakery"));
-    //other products
-    inventory.add_product(Product("0003","Eggs 12pc",8.5,30,"2026-01-01","Eggs"));
-    inventory.add_product(Product("0005","Rice 1kg",40.0,40,"2027-01-01","Grains"));
-    inventory.add_product(Product("0007","Orange Juice 1L",60.0,60,"2025-12-20","Beverages"));
-    inventory.add_product(Product("0010","Banana 1kg",45.0,45,"2025-11-25","Produce"));
-    inventory.add_product(Product("0011","Cereal 500g",65.5,55,"2026-06-01","Breakfast"));
-    inventory.add_product(Product("0013","Tomato Sauce 500g",16.0,70,"2027-05-01","Condiments"));
 
-    rebuild_bst();
+// The built-in catalog is compile-time data (default_catalog.h); no product is
+// built until something looks it up, and the sorted views use precomputed orders.
+inline void SupermarketSystem::seed_data() {
+    inventory.use_default_catalog();
 }
 
 inline void SupermarketSystem::rebuild_bst() { 
+    METRIC_SCOPE(Metric::RebuildBst);
     bst.build(inventory.all_products());
     bstbycategory.build(inventory.all_products());
 }
 
-inline bool SupermarketSystem::add_walkin_customer(const string& id, const string& name) {
-    if (customers.count(id)) return false;
-    customers[id] = make_unique<Customer>(id, name);
-    return true;
+inline Status SupermarketSystem::add_product(const Product& p) {
+    if (p.barcode.empty() || p.category.empty() || p.price < 0.0 || p.stock < 0) return Status::InvalidProduct;
+    if (!inventory.add_product(p)) return Status::ProductExists;
+    if (wal) { wal->log_product(p); maybe_checkpoint(); }
+    return Status::Ok;
 }
 
-inline bool SupermarketSystem::add_online_customer(const string& id, const string& name, const string& addr, const string& pay, int priority) {
-    if (customers.count(id)) return false;
-    customers[id] = make_unique<OnlineCustomer>(id, name, addr, pay, priority);
-    return true;
+inline Status SupermarketSystem::add_walkin_customer(const string& id, const string& name) {
+    return customers.add(CustomerKind::WalkIn, id, name) == NO_CUSTOMER ? Status::CustomerExists : Status::Ok;
+}
+
+inline Status SupermarketSystem::add_special_customer(const string& id, const string& name) {
+    return customers.add(CustomerKind::Special, id, name) == NO_CUSTOMER ? Status::CustomerExists : Status::Ok;
 }
 
-inline Customer* SupermarketSystem::get_customer(const string& id) {
-    auto it = customers.find(id);
-    if (it == customers.end()) return nullptr;
-    return it->second.get();
+inline Status SupermarketSystem::add_online_customer(const string& id, const string& name, const string& addr, const string& pay, int priority) {
+    CustomerNo c = customers.add(CustomerKind::Online, id, name);
+    if (c == NO_CUSTOMER) return Status::CustomerExists;
+    OnlineProfile& op = customers.online_profile(c);
+    op.address = addr; op.paymentMethod = pay; op.priority = priority;
+    return Status::Ok;
+}
+
+inline vector<CustomerNo> SupermarketSystem::customer_list() const {
+    vector<CustomerNo> v;
+    v.reserve(customers.size());
+    for (CustomerNo c = 0; c < customers.end(); ++c) if (customers.live(c)) v.push_back(c);
+    return v;
 }
 
 inline void SupermarketSystem::list_customers() const {
     cout << "Customers list:\n";
-    for (auto it=customers.begin(); it != customers.end(); ++it) {
-        const Customer* c = it->second.get();
-        cout << c->get_id() << " | " << c->get_name() << " | Type: " << c->get_type() << '\n';
+    for (CustomerNo c : customer_list()) {
+        cout << customers.id(c) << " | " << customers.name(c) << " | Type: " << kind_name(customers.kind(c)) << '\n';
     }
 }
 
-inline bool SupermarketSystem::customer_add_to_cart(const string& custId, const string& barcode, int qty) {
-    Customer* c = get_customer(custId);
-    if (c==nullptr) { cout << "Customer not found\n"; return false; }
+// loyal customers jump ahead: Gold orders gain one priority step, Platinum two
+inline int SupermarketSystem::effective_online_priority(CustomerNo c) const {
+    int bonus = 0;
+    LoyaltyTier t = history.tier(string(customers.id(c)));
+    if (t == LoyaltyTier::Gold) bonus = 1;
+    else if (t == LoyaltyTier::Platinum) bonus = 2;
+    return max(1, customers.online_profile(c).priority - bonus);
+}
+
+inline void SupermarketSystem::print_customer_history(const string& id) const {
+    CustomerNo c = customers.find(id);
+    if (c == NO_CUSTOMER) { cout << "Customer not found\n"; return; }
+    const CustomerHistory* h = history.find_history(id);
+    cout << "History for " << customers.name(c) << " | Tier: " << tier_name(history.tier(id)) << '\n';
+    if (h == nullptr) { cout << "No purchases yet\n"; return; }
+    cout << "Lifetime spend: LE " << h->lifetimeSpend / 100.0 << " | Visits: " << h->visits
+         << " | Last visit: " << h->lastVisit << " | Favourite category: " << h->favouriteCategory << '\n';
+    for (const SaleRecord* s : h->sales) {
+        cout << s->saleId << " | LE " << s->total << " | " << s->time << '\n';
+        for (auto &item : s->items) cout << "   - " << item.first << " x" << item.second << '\n';
+    }
+}
+
+inline CartResult SupermarketSystem::customer_add_to_cart(const string& custId, const string& barcode, int qty) {
+    METRIC_SCOPE(Metric::CartAdd);
+    CartResult r;
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { r.status = Status::CustomerNotFound; return r; }
+    if (qty <= 0) { r.status = Status::InvalidQuantity; return r; }
     Product* p = inventory.find(barcode);
-    if (p==nullptr) { cout << "Product not found\n"; return false; }
-    if (p->stock < qty) { cout << "Not enough stock. Available: " << p->stock << '\n'; return false; }
-    p->stock -= qty;
-    c->cart.add_item(*p, qty);
-    cout << "Added " << qty << " x " << p->name << " to " << c->get_name() << " cart.\n";
-    return true;
+    if (p==nullptr) { r.status = Status::ProductNotFound; return r; }
+    r.productName = p->name;
+    r.customerName = string(customers.name(c));
+    if (p->stock < qty) { r.status = Status::OutOfStock; r.available = p->stock; return r; }
+    stockBook.cart_move(*p);
+    inventory.move_stock(*p, -qty);
+    log_stock(barcode, -qty, custId);
+    customers.cart(c).add_item(*p, qty);
+    r.qty = qty;
+    r.available = p->stock;
+    return r;
 }
 
-inline pair<bool,string> SupermarketSystem::customer_undo(const string& custId) {
-    Customer* c = get_customer(custId);
-    if (c==nullptr) return {false,"Customer not found"};
-    auto res = c->cart.undo(inventory);
-    return res;
+inline ScanIngest SupermarketSystem::scan_into_cart(const string& custId, ScanReader& in, size_t batch) {
+    auto t0 = chrono::steady_clock::now();
+    ScanIngest r;
+    if (customers.find(custId) == NO_CUSTOMER) { r.status = Status::CustomerNotFound; return r; }
+    ScanBatch b;
+    ScanCoalescer lines;
+    while (true) {
+        METRIC_SCOPE(Metric::ScanBatch);
+        if (!in.next(b, batch)) break;
+        r.reads += b.reads; r.valid += b.keys.size(); r.badCheck += b.badCheck; r.malformed += b.malformed;
+        for (auto &l : lines.merge(b.keys)) {
+            string bc = scan_barcode(l.first);
+            CartResult c = customer_add_to_cart(custId, bc, l.second);
+            // a UPC-A read packs as its EAN-13; the catalog may hold the 12 digits
+            if (c.status == Status::ProductNotFound && bc.size() == 13 && bc[0] == '0')
+                c = customer_add_to_cart(custId, bc.substr(1), l.second);
+            if (c.status == Status::Ok) { r.units += l.second; r.adds++; }
+            else if (c.status == Status::OutOfStock) r.outOfStock += l.second;
+            else r.unknown += l.second;
+        }
+    }
+    r.elapsedNs = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    return r;
 }
 
-inline void SupermarketSystem::show_customer_cart(const string& custId){
-    Customer* c = get_customer(custId);
-    if (c==nullptr) { cout << "Customer not found\n"; return; }
-    cout << "Cart for customer " << c->get_name() << ":\n";
-    c->cart.print_cart();
+inline CartResult SupermarketSystem::customer_remove_from_cart(const string& custId, const string& barcode, int qty) {
+    CartResult r;
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { r.status = Status::CustomerNotFound; return r; }
+    if (qty <= 0) { r.status = Status::InvalidQuantity; return r; }
+    r.customerName = string(customers.name(c));
+    if (customers.cart_empty(c)) { r.status = Status::NotInCart; return r; }
+    int removed = customers.cart(c).remove_item(barcode, qty);
+    if (removed == 0) { r.status = Status::NotInCart; return r; }
+    r.qty = removed;
+    Product* p = inventory.find(barcode);
+    if (p) {
+        stockBook.cart_move(*p);
+        inventory.move_stock(*p, removed);
+        r.productName = p->name; r.available = p->stock;
+    }
+    log_stock(barcode, removed, custId);
+    return r;
 }
 
-inline void SupermarketSystem::enqueue_specialneeds_to_cashier(SpecialCustomer* sc) {
-    specialNeedsCashier->specialNeedsQueue.enqueue(sc);
-    cout << "Enqueued special needs customer " << sc->get_name() << " to " << specialNeedsCashier->id << '\n';
+inline CartUndoResult SupermarketSystem::customer_undo(const string& custId) {
+    METRIC_SCOPE(Metric::CartUndo);
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { CartUndoResult r; r.status = Status::CustomerNotFound; return r; }
+    if (customers.find_cart(c) == nullptr) { CartUndoResult r; r.status = Status::NothingToUndo; return r; }
+    ShoppingCart& cart = customers.cart(c);
+    // an undo the shelf cannot cover is refused and moves nothing
+    const Product* p = inventory.find(cart.last_action_barcode());
+    int before = p ? p->stock : 0;
+    if (p) stockBook.open_row(*p);
+    CartUndoResult r = cart.undo(inventory);
+    if (p && p->stock != before) {
+        stockBook.cart_move(*p);
+        log_stock(p->barcode, p->stock - before, custId);
+    }
+    return r;
 }
 
-inline void SupermarketSystem::enqueue_walkin_to_cashier(const string& custId) {
-    Customer* c = get_customer(custId);
-    if (c==nullptr) { cout << "Customer not found\n"; return; }
+inline Status SupermarketSystem::begin_session(const string& custId) {
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) return Status::CustomerNotFound;
+    customers.cart(c);
+    return Status::Ok;
+}
 
-    SpecialCustomer* sc = dynamic_cast<SpecialCustomer*>(c);
-    if (sc != nullptr) {
-        specialNeedsCashier->specialNeedsQueue.enqueue(sc);
-        cout << "Enqueued special needs customer " << c->get_name() << " to " << specialNeedsCashier->id << '\n';
-        return;
+inline SessionEndResult SupermarketSystem::end_session(const string& custId, bool forget) {
+    SessionEndResult r;
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { r.status = Status::CustomerNotFound; return r; }
+    r.customerName = string(customers.name(c));
+    if (const ShoppingCart* cart = customers.find_cart(c)) {
+        for (const CartItem* l = cart->lines(); l != nullptr; l = l->next) {
+            string bc(l->barcode);
+            if (Product* p = inventory.find(bc)) {
+                stockBook.cart_move(*p);
+                inventory.move_stock(*p, l->qty);
+            }
+            log_stock(bc, l->qty, custId);
+            r.lines++;
+            r.units += l->qty;
+        }
+    }
+    // its places in line go now; any that slip past lapse with the visit
+    auto mine = [&](VisitRef v) { return v.customer == c; };
+    for (auto &cs : cashiers) cs->q.remove_if(mine);
+    specialNeedsCashier->specialNeedsQueue.remove_if(mine);
+    onlineQueue.remove_if([&](const ScheduledOrder& o) { return o.customer.customer == c; });
+    customers.end_visit(c);
+    if (forget) {
+        customers.remove(c);
+        history.forget(custId);
+        r.forgotten = true;
     }
+    return r;
+}
+
+inline void SupermarketSystem::show_customer_cart(const string& custId){
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { cout << "Customer not found\n"; return; }
+    cout << "Cart for customer " << customers.name(c) << ":\n";
+    if (const ShoppingCart* cart = customers.find_cart(c)) cart->print_cart();
+    else cout << "No visit in progress\n";
+}
+
+inline EnqueueResult SupermarketSystem::enqueue_specialneeds_to_cashier(CustomerNo c) {
+    EnqueueResult r;
+    specialNeedsCashier->specialNeedsQueue.enqueue(customers.visit(c));
+    r.customerName = string(customers.name(c));
+    r.laneId = specialNeedsCashier->id;
+    r.special = true;
+    return r;
+}
+
+inline EnqueueResult SupermarketSystem::enqueue_walkin_to_cashier(const string& custId) {
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { EnqueueResult r; r.status = Status::CustomerNotFound; return r; }
+    if (customers.kind(c) == CustomerKind::Special) return enqueue_specialneeds_to_cashier(c);
 
     size_t idx = 0; size_t minSz = numeric_limits<size_t>::max();
     for (size_t i=0;i<cashiers.size();++i) {
         if (cashiers[i]->q.size() < minSz) { minSz = cashiers[i]->q.size(); idx = i; }
     }
-    cashiers[idx]->q.enqueue(c);
-    cout << "Enqueued " << c->get_name() << " to " << cashiers[idx]->id << '\n';
+    cashiers[idx]->q.enqueue(customers.visit(c));
+    EnqueueResult r;
+    r.customerName = string(customers.name(c));
+    r.laneId = cashiers[idx]->id;
+    return r;
 }
 
-inline void SupermarketSystem::place_online_order(const string& custId) {
-    Customer* c = get_customer(custId);
-    if (c==nullptr) { cout << "Customer not found\n"; return; }
-    OnlineCustomer* oc = dynamic_cast<OnlineCustomer*>(c);
-    if (oc == nullptr) { cout << "Not an online customer\n"; return; }
-    onlineQueue.push(OnlineOrder(oc, oc->get_priority()));
-    cout << "Placed online order for " << oc->get_name() << " (priority " << oc->get_priority() << ")\n";
+inline EnqueueResult SupermarketSystem::place_online_order(const string& custId, time_t deliverBy) {
+    METRIC_SCOPE(Metric::OnlineOrder);
+    EnqueueResult r;
+    CustomerNo c = customers.find(custId);
+    if (c == NO_CUSTOMER) { r.status = Status::CustomerNotFound; return r; }
+    if (customers.kind(c) != CustomerKind::Online) { r.status = Status::NotOnlineCustomer; return r; }
+    r.priority = effective_online_priority(c);
+    ScheduledOrder o;
+    o.customer = customers.visit(c);
+    o.priority = r.priority;
+    o.placed = (int64_t)time(nullptr);
+    o.deadline = deliverBy ? (int64_t)deliverBy : onlineQueue.default_deadline(o.placed);
+    onlineQueue.push(o);
+    r.promisedBy = o.deadline;
+    r.customerName = string(customers.name(c));
+    r.laneId = "ONLINE";
+    return r;
 }
 
-inline void SupermarketSystem::process_checkout_at_cashier(int cashierIndex) {
-    if (cashierIndex < 0 || cashierIndex >= (int)cashiers.size()) { cout << "Invalid cashier\n"; return; }
-    Cashier* cs = cashiers[cashierIndex].get();
-    if (cs->q.isEmpty()) { cout << "No customers in queue\n"; return; }
-    Customer* c = cs->q.front(); cs->q.dequeue();
-    if (c->cart.empty()) { cout << "Customer has empty cart\n"; return; }
-    string coupon;
-    cout << "Apply coupon code (or press Enter to skip): ";
-    getline(cin, coupon);
-    if (!coupon.empty()) {
-        if(c->cart.apply_coupon(coupon)){
-            cout << "Coupon applied successfully! New total: LE " << c->cart.total() << '\n';
-        }else{
-            cout << "Invalid coupon code. No discount applied.\n";
-        }
+inline size_t SupermarketSystem::cashier_queue_length(int cashierIndex) const {
+    if (cashierIndex < 0 || cashierIndex >= (int)cashiers.size()) return 0;
+    return cashiers[cashierIndex]->q.size();
+}
+
+inline vector<LaneView> SupermarketSystem::queue_status() const {
+    vector<LaneView> v;
+    for (auto &cs : cashiers) {
+        LaneView l; l.laneId = cs->id;
+        cs->q.for_each([&](VisitRef v) { if (customers.is_current(v)) l.waiting.push_back(v.customer); });
+        v.push_back(move(l));
     }
-    double tot = c->cart.total();
-    if(tot >= 1000.0){
-        cout << "Applying special discount of 5% for bills over LE 1000\n";
-        tot = tot * 0.95;
-        cout << "New total after special discount: LE " << tot << '\n';
+    LaneView sp; sp.laneId = specialNeedsCashier->id;
+    specialNeedsCashier->specialNeedsQueue.for_each([&](VisitRef v) { if (customers.is_current(v)) sp.waiting.push_back(v.customer); });
+    v.push_back(move(sp));
+    LaneView on; on.laneId = "ONLINE";
+    onlineQueue.for_each([&](const ScheduledOrder& o) { if (customers.is_current(o.customer)) on.waiting.push_back(o.customer.customer); });
+    v.push_back(move(on));
+    return v;
+}
+
+// lane == nullptr means an online order
+// logged: LogFailed if the sale did not reach the log
+inline SaleRecord* SupermarketSystem::record_sale(CustomerNo c, Cashier* lane, double tot, Status& logged) {
+    SaleRecord* s = add_sale_record(c, lane, customers.cart(c).line_items(), tot);
+    logged = Status::Ok;
+    if (wal) {
+        if (!wal->commit(wal->log_sale(*s))) logged = Status::LogFailed;
+        maybe_checkpoint();
     }
-    vector<pair<string,int>> items; // extracting not implemented here
+    if (snaps) snaps->publish(inventory);
+    return s;
+}
+
+// ledger, indexes, feed and snapshot entry of a new sale; logging it and
+// publishing the snapshot are up to the caller
+inline SaleRecord* SupermarketSystem::add_sale_record(CustomerNo c, Cashier* lane, const vector<pair<string,int>>& items, double tot) {
     string sid = "S" + to_string(nextSale++);
-    SaleRecord* s = new SaleRecord(sid, c->get_id(), false, items, tot);
-    c->cart.print_cart();
+    SaleRecord* s = new SaleRecord(sid, string(customers.id(c)), lane == nullptr, items, tot, lane ? lane->id : "ONLINE");
     sales.add_sale(s);
-    cs->undoStack.push(s);
-    cout << "Checked out walk-in: " << c->get_name() << " | SaleID: " << sid << " | Total: LE " << tot << '\n';
+    stockBook.sale(*s, inventory);
+    index_sale(s, lane);
+    if (feed) publish(ChangeType::SaleCommitted, sid, sale_units(*s), to_piasters(tot));
+    if (snaps) snaps->on_sale(*s);
+    return s;
 }
 
-inline void SupermarketSystem::process_checkout_at_specialneedscashier() {
-    Cashier* cs = specialNeedsCashier.get();
-    if (cs->specialNeedsQueue.isEmpty()) { cout << "No special needs customers in queue\n"; return; }
-    SpecialCustomer* c = cs->specialNeedsQueue.front(); cs->specialNeedsQueue.dequeue();
-    if (c->cart.empty()) { cout << "Customer has empty cart\n"; return; }
-    string coupon;
-    cout << "Apply coupon code (or press Enter to skip): ";
-    getline(cin, coupon);
+// feeds a committed sale to the side indexes (bought-together, history, dashboards)
+inline void SupermarketSystem::index_sale(const SaleRecord* s, Cashier* lane) {
+    basket.record(s->items);
+    history.on_sale(*s, inventory);
+    (lane ? lane->dash : onlineDash).on_sale(*s);
+}
+
+// stock moved by a customer's cart; a no-op without a log
+inline void SupermarketSystem::log_stock(const string& barcode, int delta, const string& holder) {
+    if (!wal) return;
+    wal->log_stock(barcode, delta, holder);
+    maybe_checkpoint();
+}
+
+// the stock book starts over from the shelf as it is, plus whatever open carts hold
+inline void SupermarketSystem::open_audit_period() {
+    stockBook.open_period((uint64_t)nextSale);
+    for (const CartHold& h : open_cart_holds())
+        if (Product* p = inventory.find(h.barcode)) stockBook.carry_hold(*p, h.qty);
+}
+
+inline vector<CartHold> SupermarketSystem::open_cart_holds() const {
+    vector<CartHold> v;
+    for (CustomerNo c = 0; c < customers.end(); ++c) {
+        if (!customers.live(c)) continue;
+        const ShoppingCart* cart = customers.find_cart(c);
+        if (cart == nullptr) continue;
+        for (const CartItem* l = cart->lines(); l != nullptr; l = l->next)
+            v.push_back(CartHold{string(customers.id(c)), string(l->barcode), l->qty});
+    }
+    return v;
+}
+
+inline MemoryReport SupermarketSystem::memory_report() const {
+    MemoryReport r;
+    r.parts.push_back(inventory.memory_usage());
+    if (const SharedCatalog* c = inventory.shared_catalog()) r.parts.push_back(c->memory_usage());
+    r.parts.push_back(bst.memory_usage());
+    r.parts.push_back(bstbycategory.memory_usage());
+    r.parts.push_back(sales.memory_usage());
+    r.parts.push_back(customers.memory_usage());
+    r.parts.push_back(customers.carts_memory_usage());
+    MemoryUsage lanes("cashier queues"), undo("undo stacks"), dash = onlineDash.memory_usage();
+    auto lane = [&](const Cashier& cs) {
+        size_t q = cs.q.size() + cs.specialNeedsQueue.size(), u = cs.undoStack.size();
+        lanes.elements += q;
+        account_nodes(lanes, q, sizeof(VisitRef), MyQueue<VisitRef>::node_bytes());
+        undo.elements += u;
+        account_nodes(undo, u, sizeof(SaleRecord*), MyStack<SaleRecord*>::node_bytes());
+        dash.merge(cs.dash.memory_usage());
+    };
+    for (auto &cs : cashiers) lane(*cs);
+    lane(*specialNeedsCashier);
+    r.parts.push_back(lanes);
+    r.parts.push_back(onlineQueue.memory_usage());
+    r.parts.push_back(undo);
+    r.parts.push_back(basket.memory_usage());
+    r.parts.push_back(history.memory_usage());
+    r.parts.push_back(dash);
+    r.parts.push_back(stockBook.memory_usage());
+    if (wal) r.parts.push_back(wal->memory_usage());
+    if (feed) r.parts.push_back(feed->memory_usage());
+    if (snaps) r.parts.push_back(snaps->memory_usage());
+    return r;
+}
+
+inline StockAudit SupermarketSystem::audit_stock(unsigned threads) const {
+    METRIC_SCOPE(Metric::StockAudit);
+    return StockAuditor(threads).run(stockBook, inventory, sales.ledger(), open_cart_holds());
+}
+
+// restores stock, takes the sale out of every index and deletes it;
+// logged as for record_sale
+inline bool SupermarketSystem::void_sale(SaleRecord* s, Cashier* lane, Status& logged) {
+    for (auto &it : s->items) {
+        Product* p = inventory.find(it.first);
+        if (p == nullptr) continue;
+        stockBook.void_line(*p, it.second, *s);
+        inventory.move_stock(*p, it.second);
+    }
+    basket.record(s->items, -1);
+    history.on_undo(*s, inventory);
+    (s->online ? onlineDash : lane->dash).on_undo(*s);
+    if (feed) publish(ChangeType::SaleVoided, s->saleId, sale_units(*s), to_piasters(s->total));
+    logged = wal && !wal->commit(wal->log_void(*s)) ? Status::LogFailed : Status::Ok;
+    if (snaps) { snaps->on_void(s->saleId); snaps->publish(inventory); }
+    bool removed = sales.remove_by_id(s->saleId);
+    maybe_checkpoint(); // only once the ledger no longer holds the voided sale
+    return removed;
+}
+
+// prices the cart (coupon, special-needs rate, bulk 5%) and commits the sale;
+// lane == nullptr means an online order, whose bill can be undone at cashier 1
+inline void SupermarketSystem::checkout_customer(CustomerNo c, Cashier* lane, const string& coupon, CheckoutResult& r) {
+    ShoppingCart& cart = customers.cart(c);
+    double specialRate = customers.discount_rate(c);
+    r.customerId = string(customers.id(c));
+    r.customerName = string(customers.name(c));
+    r.lines = cart.receipt_lines();
+    r.subtotal = cart.subtotal();
     if (!coupon.empty()) {
-        if(c->cart.apply_coupon(coupon)){
-            cout << "Coupon applied successfully! New total: LE " << c->cart.total() << '\n';
-        }else{
-            cout << "Invalid coupon code. No discount applied.\n";
-        }
+        r.couponStatus = cart.apply_coupon(coupon);
+        r.couponApplied = r.couponStatus == Status::Ok;
     }
-    double tot = c->cart.total();
-    double specialDiscount = tot * (c->get_discount_rate());
-    tot = tot - specialDiscount;
-    cout << "Applied special customer discount (10%): LE " << specialDiscount << '\n';
-    
-    if(tot >= 1000.0){
-        cout << "Applying special discount of 5% for bills over LE 1000\n";
-        tot = tot * 0.95;
-        cout << "New total after special discount: LE " << tot << '\n';
-    }
-    vector<pair<string,int>> items; // extracting not implemented here
-    string sid = "S" + to_string(nextSale++);
-    SaleRecord* s = new SaleRecord(sid, c->get_id(), false, items, tot);
-    c->cart.print_cart();
-    sales.add_sale(s);
-    cs->undoStack.push(s);
-    cout << "Checked out special needs customer: " << c->get_name() << " | SaleID: " << sid << " | Total: LE " << tot << '\n';
+    double tot = cart.total();
+    r.afterCoupon = tot;
+    tot = bill_after_discounts(tot, specialRate, &r.specialDiscount, &r.bulkDiscount);
+    r.total = tot;
+    SaleRecord* s = record_sale(c, lane, tot, r.status);
+    r.saleId = s->saleId;
+    r.laneId = s->cashierId;
+    r.online = s->online;
+    if (lane != nullptr) lane->undoStack.push(s);
+    else if (!cashiers.empty()) cashiers[0]->undoStack.push(s);
+    customers.end_visit(c); // the sale has the lines; cart and coupon go back to the pool
+}
+
+// pops the queue up to its first visit that is still open
+inline bool SupermarketSystem::next_in_queue(MyQueue<VisitRef>& q, CustomerNo& c) {
+    while (!q.isEmpty()) {
+        VisitRef v = q.front(); q.dequeue();
+        if (customers.is_current(v)) { c = v.customer; return true; }
+    }
+    return false;
+}
+
+inline CheckoutResult SupermarketSystem::process_checkout_at_cashier(int cashierIndex, const string& coupon) {
+    METRIC_SCOPE(Metric::CheckoutCashier);
+    CheckoutResult r;
+    if (cashierIndex < 0 || cashierIndex >= (int)cashiers.size()) { r.status = Status::InvalidCashier; return r; }
+    if (log_failed()) { r.status = Status::LogFailed; return r; } // the customer keeps their place
+    Cashier* cs = cashiers[cashierIndex].get();
+    CustomerNo c;
+    if (!next_in_queue(cs->q, c)) { r.status = Status::QueueEmpty; return r; }
+    if (customers.cart_empty(c)) { r.status = Status::EmptyCart; r.customerName = string(customers.name(c)); return r; }
+    checkout_customer(c, cs, coupon, r);
+    return r;
+}
+
+inline CheckoutResult SupermarketSystem::process_checkout_at_specialneedscashier(const string& coupon) {
+    METRIC_SCOPE(Metric::CheckoutSpecial);
+    CheckoutResult r;
+    if (log_failed()) { r.status = Status::LogFailed; return r; }
+    Cashier* cs = specialNeedsCashier.get();
+    CustomerNo c;
+    if (!next_in_queue(cs->specialNeedsQueue, c)) { r.status = Status::QueueEmpty; return r; }
+    if (customers.cart_empty(c)) { r.status = Status::EmptyCart; r.customerName = string(customers.name(c)); return r; }
+    checkout_customer(c, cs, coupon, r);
+    return r;
 }
 
-inline void SupermarketSystem::cashier_undo_last_bill(int cashierIndex) {
-    if (cashierIndex < 0 || cashierIndex >= (int)cashiers.size()) { cout << "Invalid cashier\n"; return; }
+inline BillUndoResult SupermarketSystem::cashier_undo_last_bill(int cashierIndex) {
+    BillUndoResult r;
+    if (cashierIndex < 0 || cashierIndex >= (int)cashiers.size()) { r.status = Status::InvalidCashier; return r; }
     Cashier* cs = cashiers[cashierIndex].get();
-    if (cs->undoStack.isEmpty()) { cout << "No bills to undo\n"; return; }
+    if (cs->undoStack.isEmpty()) { r.status = Status::NothingToUndo; return r; }
+    if (log_failed()) { r.status = Status::LogFailed; return r; }
     SaleRecord* s = cs->undoStack.top(); cs->undoStack.pop();
-    string sid = s->saleId; // copy id before removal (avoid use-after-free)
-    for (auto &it : s->items) inventory.update_stock(it.first, it.second);
-    bool removed = sales.remove_by_id(sid);
-    if (removed==false) cout << "Warning: sale not found in sales list for removal. (shouldn't happen)\n";
-    cout << "Undid sale " << sid << " and restored stock\n";
+    r.saleId = s->saleId; // copy id before removal (avoid use-after-free)
+    r.inLedger = void_sale(s, cs, r.status);
+    return r;
 }
 
-inline void SupermarketSystem::cashier_undo_last_specialneedscashier_bill() {
+inline BillUndoResult SupermarketSystem::cashier_undo_last_specialneedscashier_bill() {
+    BillUndoResult r;
     Cashier* cs = specialNeedsCashier.get();
-    if (cs->undoStack.isEmpty()) { cout << "No bills to undo\n"; return; }
+    if (cs->undoStack.isEmpty()) { r.status = Status::NothingToUndo; return r; }
+    if (log_failed()) { r.status = Status::LogFailed; return r; }
     SaleRecord* s = cs->undoStack.top(); cs->undoStack.pop();
-    string sid = s->saleId; // copy id before removal (avoid use-after-free)
-    for (auto &it : s->items) inventory.update_stock(it.first, it.second);
-    bool removed = sales.remove_by_id(sid);
-    if (removed==false) cout << "Warning: sale not found in sales list for removal. (shouldn't happen)\n";
-    cout << "Undid sale " << sid << " and restored stock\n";
-}
-
-inline void SupermarketSystem::process_next_online_order() {
-    if (onlineQueue.isEmpty()) { cout << "No online orders\n"; return; }
-    OnlineOrder ord = onlineQueue.top(); onlineQueue.pop();
-    OnlineCustomer* oc = ord.customer;
-    if (oc->cart.empty()) { cout << "Online customer has empty cart\n"; return; }
-    string coupon;
-    cout << "Apply coupon code (or press Enter to skip): ";
-    getline(cin, coupon);
-    if (!coupon.empty()) {
-        if(oc->cart.apply_coupon(coupon)){
-            cout << "Coupon applied successfully! New total: LE " << oc->cart.total() << '\n';
-        }else{
-            cout << "Invalid coupon code. No discount applied.\n";
+    r.saleId = s->saleId; // copy id before removal (avoid use-after-free)
+    r.inLedger = void_sale(s, cs, r.status);
+    return r;
+}
+
+inline CheckoutResult SupermarketSystem::process_next_online_order(const string& coupon) {
+    METRIC_SCOPE(Metric::CheckoutOnline);
+    CheckoutResult r;
+    if (log_failed()) { r.status = Status::LogFailed; return r; }
+    ScheduledOrder o;
+    if (!next_online_order((int64_t)time(nullptr), o)) { r.status = Status::QueueEmpty; return r; }
+    CustomerNo c = o.customer.customer;
+    if (customers.cart_empty(c)) { r.status = Status::EmptyCart; r.customerName = string(customers.name(c)); return r; }
+    checkout_customer(c, nullptr, coupon, r);
+    return r;
+}
+
+// the scheduler's next order whose visit is still open; the rest are dropped
+inline bool SupermarketSystem::next_online_order(int64_t now, ScheduledOrder& o) {
+    while (!onlineQueue.isEmpty()) {
+        bool open = customers.is_current(onlineQueue.peek(now).customer);
+        onlineQueue.pop(now, o, open);
+        if (open) return true;
+    }
+    return false;
+}
+
+// engine thread: copies the next n live orders with something in the cart
+inline bool SupermarketSystem::take_wave(size_t n, Wave& w, size_t& skipped) {
+    int64_t now = (int64_t)time(nullptr);
+    ScheduledOrder next;
+    while (w.orders.size() < n && next_online_order(now, next)) {
+        VisitRef v = next.customer;
+        const ShoppingCart* cart = customers.find_cart(v.customer);
+        if (cart == nullptr || cart->empty()) { skipped++; continue; }
+        WaveOrder o;
+        o.visit = v;
+        o.customerId = string(customers.id(v.customer));
+        o.lines = cart->receipt_lines();
+        o.specialRate = customers.discount_rate(v.customer);
+        w.orders.push_back(move(o));
+    }
+    return !w.orders.empty();
+}
+
+// engine thread: one sale per order, then one log commit and one snapshot for the wave
+inline void SupermarketSystem::commit_wave(Wave& w, WaveStats& st) {
+    METRIC_SCOPE(Metric::WaveCommit);
+    uint64_t lsn = 0;
+    vector<pair<string,int>> items;
+    for (WaveOrder& o : w.orders) {
+        if (!customers.is_current(o.visit)) { st.skipped++; continue; }
+        items.clear();
+        for (auto &l : o.lines) items.push_back({l.barcode, l.qty});
+        SaleRecord* s = add_sale_record(o.visit.customer, nullptr, items, o.total);
+        if (wal) lsn = wal->log_sale(*s);
+        if (!cashiers.empty()) cashiers[0]->undoStack.push(s);
+        customers.end_visit(o.visit.customer);
+        st.saleIds.push_back(s->saleId);
+        st.orders++;
+    }
+    if (wal && lsn) {
+        if (!wal->commit(lsn)) st.logFailed = true;
+        maybe_checkpoint();
+    }
+    if (snaps) snaps->publish(inventory);
+    st.waves++;
+    st.pickLines += w.picks.size();
+    for (auto &p : w.picks) st.units += (size_t)p.qty;
+    st.buildNs += w.buildNs;
+    st.maxBuildNs = max(st.maxBuildNs, w.buildNs);
+}
+
+// Up to pool size + 1 waves are in flight: taken and building on the pool
+// while the oldest is committed. Carts cannot change meanwhile, since all of
+// it happens inside this call on the engine thread.
+inline WaveStats SupermarketSystem::fulfil_online_waves(size_t waveSize, size_t maxWaves, unsigned threads,
+                                                        const function<void(const Wave&)>& onWave) {
+    WaveStats st;
+    if (waveSize == 0) return st;
+    if (!wavePool || (threads != 0 && wavePool->size() != threads)) wavePool = make_unique<WorkerPool>(threads);
+    size_t depth = wavePool->size() + 1;
+    deque<pair<unique_ptr<Wave>, future<void>>> inFlight;
+    size_t taken = 0;
+    bool drained = false;
+    while (true) {
+        while (!drained && inFlight.size() < depth && taken < maxWaves) {
+            if (log_failed()) { st.logFailed = true; drained = true; break; } // the rest stay queued
+            unique_ptr<Wave> w = make_unique<Wave>();
+            if (!take_wave(waveSize, *w, st.skipped)) { drained = true; break; }
+            Wave* raw = w.get();
+            future<void> built = wavePool->submit([raw] { build_wave(*raw); });
+            inFlight.push_back({move(w), move(built)});
+            taken++;
         }
+        if (inFlight.empty()) break;
+        inFlight.front().second.get();
+        commit_wave(*inFlight.front().first, st);
+        if (onWave) onWave(*inFlight.front().first);
+        inFlight.pop_front();
     }
-    double tot = oc->cart.total();
-    if(tot >= 1000.0){
-        cout << "Applying special discount of 5% for bills over LE 1000\n";
-        tot = tot * 0.95;
-        cout << "New total after special discount: LE " << tot << '\n';
+    return st;
+}
+
+inline const LineTemplate RECEIPT_LINE("{0} | {1} | {2} | qty: {3} | unit: LE{4}\n");
+
+// what the console prints for a completed checkout
+inline void write_receipt(OutBuffer& out, const CheckoutResult& r) {
+    if (r.couponApplied) out.text("Coupon applied successfully! New total: LE ").money(Money{r.afterCoupon}).ch('\n');
+    else if (r.couponStatus != Status::Ok) out.text(status_message(r.couponStatus)).text(" No discount applied.\n");
+    if (r.specialDiscount > 0.0)
+        out.text("Applied special customer discount (10%): LE ").money(Money{r.specialDiscount}).ch('\n');
+    if (r.bulkDiscount) {
+        out.text("Applying special discount of 5% for bills over LE 1000\n");
+        out.text("New total after special discount: LE ").money(Money{r.total}).ch('\n');
     }
-    vector<pair<string,int>> items; // extracting not implemented here
-    string sid = "S" + to_string(nextSale++);
-    SaleRecord* s = new SaleRecord(sid, oc->get_id(), true, items, tot);
-    sales.add_sale(s);
-    oc->cart.print_cart();
-    if (!cashiers.empty()) cashiers[0]->undoStack.push(s);
-    cout << "Processed online order: " << oc->get_name() << " | SaleID: " << sid << " | Total: LE " << tot << '\n';
+    out.text("Cart contents:\n");
+    for (auto &l : r.lines) RECEIPT_LINE.render(out, {l.barcode, l.name, l.category, l.qty, Money{l.unitPrice}});
+    out.text("Total before discount: LE ").money(Money{r.afterCoupon}).ch('\n');
+    if (r.online) out.text("Processed online order: ");
+    else if (r.specialDiscount > 0.0) out.text("Checked out special needs customer: ");
+    else out.text("Checked out walk-in: ");
+    out.text(r.customerName).text(" | SaleID: ").text(r.saleId).text(" | Total: LE ").money(Money{r.total}).ch('\n');
+}
+
+inline size_t SupermarketSystem::product_count() {
+    return snaps ? pin_current()->productCount : inventory.size();
+}
+
+// with snapshots on, the console reads a pinned version like any other reader
+inline void SupermarketSystem::print_inventory(RowWindow w, const OutputSink& sink) {
+    OutBuffer out(sink);
+    if (!snaps) { inventory.write_all(out, w); return; }
+    SnapshotPin v = pin_current();
+    out.text("Inventory:\n");
+    for (size_t i = w.first; i < v->productCount && w.shows(i); ++i) write_product(out, v->product(i));
+}
+
+// the built-in catalog comes pre-sorted; anything else goes through the BSTs
+inline vector<Product> SupermarketSystem::products_sorted_by_price() {
+    vector<Product> sorted;
+    if (inventory.only_default_catalog()) {
+        for (uint16_t row : DEFAULT_CATALOG_INDEX.byPrice) sorted.push_back(inventory.default_product(row));
+    } else {
+        rebuild_bst();
+        sorted = bst.sorted_by_price();
+    }
+    return sorted;
+}
+
+inline vector<Product> SupermarketSystem::products_sorted_by_category() {
+    vector<Product> sorted;
+    if (inventory.only_default_catalog()) {
+        for (uint16_t row : DEFAULT_CATALOG_INDEX.byCategory) sorted.push_back(inventory.default_product(row));
+    } else {
+        rebuild_bst();
+        sorted = bstbycategory.sorted_by_category();
+    }
+    return sorted;
+}
+
+inline const LineTemplate PRICE_ROW("{0} | {1} | LE {2} | stock: {3} | {4}\n");
+inline const LineTemplate CATEGORY_ROW("{4} | {0} | {1} | LE {2} | stock: {3}\n");
+
+// the built-in catalog's order is precomputed, so only the rows shown are built
+inline void write_sorted(OutBuffer& out, const LineTemplate& row, const Inventory& inv, const uint16_t* order,
+                         const vector<Product>& sorted, RowWindow w) {
+    auto write = [&](const Product& p) { row.render(out, {p.barcode, p.name, Money{p.price}, p.stock, p.category}); };
+    size_t n = order ? DEFAULT_CATALOG_SIZE : sorted.size();
+    for (size_t i = w.first; i < n && w.shows(i); ++i) {
+        if (order) write(inv.default_product(order[i]));
+        else write(sorted[i]);
+    }
+}
+
+inline void SupermarketSystem::print_products_sorted_price(RowWindow w, const OutputSink& sink) {
+    const uint16_t* order = nullptr;
+    vector<Product> sorted;
+    if (snaps) sorted = snapshot_sorted_by_price(*pin_current());
+    else if (inventory.only_default_catalog()) order = DEFAULT_CATALOG_INDEX.byPrice;
+    else sorted = products_sorted_by_price();
+    OutBuffer out(sink);
+    out.text("Products sorted by price:\n");
+    write_sorted(out, PRICE_ROW, inventory, order, sorted, w);
+}
+
+inline void SupermarketSystem::print_products_sorted_category(RowWindow w, const OutputSink& sink) {
+    const uint16_t* order = nullptr;
+    vector<Product> sorted;
+    if (inventory.only_default_catalog()) order = DEFAULT_CATALOG_INDEX.byCategory;
+    else sorted = products_sorted_by_category();
+    OutBuffer out(sink);
+    out.text("Products sorted by category:\n");
+    write_sorted(out, CATEGORY_ROW, inventory, order, sorted, w);
+}
+
+inline SalesReport SupermarketSystem::sales_report() const {
+    unordered_map<string,string> categoryOf;
+    for (auto &p : inventory.all_products()) categoryOf[p.barcode] = p.category;
+    return ReportEngine(categoryOf).run(sales.ledger());
+}
+
+inline void SupermarketSystem::print_sales_report(const OutputSink& sink) {
+    static const LineTemplate ranked("{0}. {1} x{2}\n"), units("   {0} x{1}\n"), amount("   {0} | LE {1}\n"),
+        rankedAmount("{0}. {1} | LE {2}\n");
+    OutBuffer out(sink);
+    out.text("=== SALES REPORT ===\n");
+    SalesReport r;
+    if (snaps) {
+        SnapshotPin v = pin_current();
+        write_sale_records(out, v->sales());
+        r = snapshot_sales_report(*v);
+    } else {
+        write_sale_records(out, sales.ledger());
+        r = sales_report();
+    }
+    out.text("Sales: ").num(r.saleCount).text(" | Revenue: LE ").money(Piasters{r.revenue}).ch('\n');
+    out.text("Top sold products:\n");
+    for (size_t i=0;i<r.byProduct.size() && i<10;++i) ranked.render(out, {i+1, r.byProduct[i].first, r.byProduct[i].second});
+    out.text("Units by category:\n");
+    for (auto &c : r.byCategory) units.render(out, {c.first, c.second});
+    out.text("Revenue by cashier:\n");
+    for (auto &c : r.byCashier) amount.render(out, {c.first, Piasters{c.second}});
+    out.text("Top customers:\n");
+    for (size_t i=0;i<r.byCustomer.size() && i<10;++i) rankedAmount.render(out, {i+1, r.byCustomer[i].first, Piasters{r.byCustomer[i].second}});
+}
+
+inline void SupermarketSystem::print_bought_together(const string& barcode, size_t k) const {
+    auto top = basket.top_k(barcode, k);
+    if (top.empty()) { cout << "No co-purchases recorded for " << barcode << '\n'; return; }
+    cout << "Customers who bought " << barcode << " also bought:\n";
+    for (size_t i=0;i<top.size();++i) {
+        const Product* p = inventory.peek(top[i].first);
+        cout << i+1 << ". " << top[i].first << " | " << (p ? p->name : string("<unknown>")) << " | in " << top[i].second << " baskets\n";
+    }
+}
+
+// all lanes merged into one view
+inline LiveDashboard SupermarketSystem::live_dashboard() const {
+    LiveDashboard d;
+    for (auto &cs : cashiers) d.merge(cs->dash);
+    d.merge(specialNeedsCashier->dash);
+    d.merge(onlineDash);
+    return d;
+}
+
+inline void SupermarketSystem::print_live_dashboard() const {
+    LiveDashboard d = live_dashboard();
+    cout << "=== LIVE DASHBOARD (approximate: distinct counts +/-3%, values +/-1%) ===\n";
+    cout << "Unique SKUs sold: ~" << llround(d.skus.estimate()) << '\n';
+    cout << "Baskets: " << d.basketValue.count() << " | median: LE " << d.basketValue.quantile(0.5)
+         << " | p95: LE " << d.basketValue.quantile(0.95) << '\n';
+    cout << "Unique customers per hour:\n";
+    for (auto &kv : d.customersByHour) cout << "   " << kv.first << ":00 | ~" << llround(kv.second.estimate()) << '\n';
+    const SchedulerStats& s = onlineQueue.stats();
+    cout << "Online orders fulfilled: " << s.served << " | on time: " << s.on_time_percent() << "% | mean wait: "
+         << s.mean_wait() / 60.0 << " min | max wait: " << s.maxWait / 60.0 << " min\n";
+}
+
+inline void SupermarketSystem::print_stock_audit() const {
+    StockAudit a = audit_stock();
+    cout << "=== STOCK AUDIT ===\n";
+    cout << "SKUs checked: " << a.skus << " | period sales: " << a.sales << " | open cart lines: " << a.holds
+         << " | " << a.elapsedNs / 1e6 << " ms\n";
+    if (a.clean()) { cout << "Stock, carts and sales reconcile\n"; return; }
+    cout << a.discrepancies.size() << " SKUs do not reconcile:\n";
+    for (const StockDiscrepancy& d : a.discrepancies) {
+        cout << d.barcode << (d.untracked ? " | untracked" : "") << " | opening " << d.opening << " adjusted " << d.adjusted
+             << " sold " << d.sold << " voided " << d.voided << " | shelf " << d.stock << " in carts " << d.held
+             << " | drift " << d.drift();
+        if (d.ledger_mismatch()) cout << " | ledger has " << d.ledgerUnits << " units";
+        cout << '\n';
+        cout << "   cart moves: " << d.cartMoves << " | adjustments: " << d.adjustments << " | voids: " << d.voids;
+        if (!d.lastVoid.empty()) cout << " (last " << d.lastVoid << ")";
+        cout << '\n';
+        if (!d.saleIds.empty()) {
+            cout << "   sales:";
+            for (auto &id : d.saleIds) cout << ' ' << id;
+            cout << '\n';
+        }
+        if (!d.holders.empty()) {
+            cout << "   held by:";
+            for (auto &id : d.holders) cout << ' ' << id;
+            cout << '\n';
+        }
+    }
+}
+
+// recount every pair from the current ledger (e.g. after a bulk load)
+inline void SupermarketSystem::rebuild_basket_stats() { basket.rebuild(sales.ledger()); }
+
+// Rolls the day's sales into dir/sales_<date>.sma and starts a fresh ledger.
+// Returns the archive path, or "" if it could not be written.
+inline string SupermarketSystem::close_day(const string& dir) {
+    string base = (dir.empty() ? string(".") : dir) + "/sales_" + now_string().substr(0, 10);
+    string path = base + ".sma";
+    for (int n = 2; ifstream(path).good(); ++n) path = base + "_" + to_string(n) + ".sma";
+    if (!write_sales_archive(path, sales.ledger())) return "";
+    // bills of a closed day can no longer be undone at the till
+    for (auto &cs : cashiers) while (!cs->undoStack.isEmpty()) cs->undoStack.pop();
+    while (!specialNeedsCashier->undoStack.isEmpty()) specialNeedsCashier->undoStack.pop();
+    history.forget_sales();
+    sales.clear();
+    open_audit_period();
+    publish(ChangeType::Resync, "close_day");
+    if (snaps) { snaps->load_ledger({}); snaps->publish(inventory); }
+    if (wal) checkpoint(); // the archived sales must not come back on recovery
+    return path;
+}
+
+inline bool SupermarketSystem::import_catalog(const string& path, CatalogLoadStats& st, bool replace, string* err) {
+    Inventory loaded;
+    if (!load_catalog(path, loaded, st, err)) return false;
+    if (replace) {
+        inventory = move(loaded);
+        inventory.set_feed(feed.get());
+        open_audit_period();
+        publish(ChangeType::Resync, "catalog");
+    }
+    else for (auto &p : loaded.all_products()) inventory.add_product(p);
+    rebuild_bst();
+    publish_snapshot();
+    if (wal) checkpoint(); // one snapshot instead of a log record per product
+    return true;
 }
 
-inline void SupermarketSystem::print_inventory() const { inventory.print_all(); }
+inline void SupermarketSystem::use_shared_catalog(shared_ptr<const SharedCatalog> c) {
+    inventory.use_shared_catalog(move(c));
+    open_audit_period();
+    publish(ChangeType::Resync, "catalog");
+    publish_snapshot();
+    if (wal) checkpoint();
+}
 
-inline void SupermarketSystem::print_products_sorted_price() {
-    const_cast<SupermarketSystem*>(this)->rebuild_bst();
-    auto sorted = bst.sorted_by_price();
-    cout << "Products sorted by price:\n";
-    for (auto &p : sorted) cout << p.barcode << " | " << p.name << " | LE " << p.price << " | stock: " << p.stock << " | "<< p.category <<'\n';
+inline Status SupermarketSystem::adjust_stock(const string& barcode, int delta) {
+    if (delta == 0) return Status::InvalidQuantity;
+    Product* p = inventory.find(barcode);
+    if (p == nullptr) return Status::ProductNotFound;
+    if (p->stock + delta < 0) return Status::OutOfStock;
+    stockBook.adjust(*p, delta);
+    inventory.move_stock(*p, delta);
+    log_stock(barcode, delta, "");
+    return Status::Ok;
 }
 
-inline void SupermarketSystem::print_products_sorted_category() {
-    const_cast<SupermarketSystem*>(this)->rebuild_bst();
-    auto sorted = bstbycategory.sorted_by_category();
-    cout << "Products sorted by category:\n";
-    for (auto &p : sorted) cout << p.category << " | " << p.barcode << " | " << p.name << " | LE " << p.price << " | stock: " << p.stock << '\n';
+inline bool SupermarketSystem::open_wal(const string& dir, const WalOptions& opt, RecoveryStats* stats, string* err) {
+    walDir = dir.empty() ? string(".") : dir;
+    RecoveryStats st;
+    if (ifstream(walDir + "/snapshot.bin").good() || ifstream(walDir + "/wal.log").good()) {
+        inventory.clear();
+        if (!recover_wal_state(walDir, inventory, sales, nextSale, st, err)) return false;
+        vector<const SaleRecord*> ledger = sales.ledger();
+        // purchase history is rebuilt from the recovered ledger alone, nothing from before it survives
+        history.rebuild(ledger, inventory);
+        for (size_t i = ledger.size(); i-- > 0;) {
+            const SaleRecord* s = ledger[i];
+            Cashier* lane = specialNeedsCashier.get();
+            for (auto &cs : cashiers) if (cs->id == s->cashierId) lane = cs.get();
+            basket.record(s->items);
+            (s->online ? onlineDash : lane->dash).on_sale(*s);
+        }
+        rebuild_bst();
+        open_audit_period();
+        publish(ChangeType::Resync, "recovery");
+        if (snaps) { snaps->load_ledger(sales.ledger()); snaps->publish(inventory); }
+    }
+    if (stats) *stats = st;
+    // the recovered state becomes the new base: snapshot it, then start an empty log
+    if (!write_wal_snapshot(walDir + "/snapshot.bin", st.lastLsn, nextSale, inventory, CartHolds(), sales.ledger())) {
+        if (err) *err = "cannot write " + walDir + "/snapshot.bin";
+        return false;
+    }
+    wal = make_unique<WriteAheadLog>();
+    if (!wal->open(walDir + "/wal.log", st.lastLsn, CartHolds(), opt)) {
+        wal.reset();
+        if (err) *err = "cannot open " + walDir + "/wal.log";
+        return false;
+    }
+    return true;
 }
 
-inline void SupermarketSystem::print_sales_report() {
-    cout << "=== SALES REPORT ===\n";
-    sales.print_sales();
+// Snapshot of inventory, open cart holds and the ledger; the log restarts empty.
+// Bounds how much log a recovery has to replay.
+inline bool SupermarketSystem::checkpoint() {
+    if (!wal) return false;
+    wal->sync();
+    if (!write_wal_snapshot(walDir + "/snapshot.bin", wal->last_lsn(), nextSale, inventory, wal->cart_holds(), sales.ledger()))
+        return false;
+    return wal->truncate();
+}
+
+inline void SupermarketSystem::print_archive_report(const string& path) {
+    SalesArchive a; string err;
+    if (!a.open(path, &err)) { cout << "Cannot read archive: " << err << '\n'; return; }
+    cout << "=== ARCHIVE REPORT: " << path << " ===\n";
+    cout << "Sales: " << a.size() << " | Revenue: LE " << a.revenue() / 100.0 << '\n';
     cout << "Top sold products:\n";
-    auto top = sales.tally_products();
+    auto top = a.tally_products();
     for (size_t i=0;i<top.size() && i<10;++i) cout << i+1 << ". " << top[i].first << " x" << top[i].second << '\n';
 }
 
+inline bool SupermarketSystem::export_archive(const string& archivePath, const string& outPath, bool json) {
+    SalesArchive a;
+    if (!a.open(archivePath)) return false;
+    ofstream out(outPath, ios::binary | ios::trunc);
+    if (!out) return false;
+    if (json) a.export_json(out); else a.export_csv(out);
+    return (bool)out;
+}
+
 // Minimal interactive console: simplified to avoid complex input interop across header-split code
 inline void SupermarketSystem::interactive_console() {
     auto read_line = [](const string& prompt)->string{
@@ -486,6 +1149,38 @@ inline void SupermarketSystem::interactive_console() {
         try { return stoi(s); } catch (...) { return defaultVal; }
     };
 
+    auto read_coupon = [&]()->string{ return trim(read_line("Apply coupon code (or press Enter to skip): ")); };
+
+    auto print_enqueue = [](const EnqueueResult& r){
+        if (r.status != Status::Ok) cout << status_message(r.status) << '\n';
+        else if (r.laneId == "ONLINE") {
+            tm due = local_time((time_t)r.promisedBy);
+            char buf[32];
+            strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &due);
+            cout << "Placed online order for " << r.customerName << " (priority " << r.priority << ", delivery by " << buf << ")\n";
+        }
+        else if (r.special) cout << "Enqueued special needs customer " << r.customerName << " to " << r.laneId << '\n';
+        else cout << "Enqueued " << r.customerName << " to " << r.laneId << '\n';
+    };
+
+    auto print_checkout = [](const CheckoutResult& r){
+        if (r.status == Status::QueueEmpty) { cout << "No customers in queue\n"; return; }
+        if (r.status != Status::Ok && r.saleId.empty()) { cout << status_message(r.status) << '\n'; return; }
+        {
+            OutBuffer out(console_sink());
+            write_receipt(out, r);
+        }
+        if (r.status != Status::Ok) cout << "Warning: " << status_message(r.status) << '\n';
+    };
+
+    auto print_bill_undo = [](const BillUndoResult& r){
+        if (r.status == Status::NothingToUndo) { cout << "No bills to undo\n"; return; }
+        if (r.status != Status::Ok && r.saleId.empty()) { cout << status_message(r.status) << '\n'; return; }
+        if (r.status != Status::Ok) cout << "Warning: " << status_message(r.status) << '\n';
+        if (!r.inLedger) cout << "Warning: sale not found in sales list for removal. (shouldn't happen)\n";
+        cout << "Undid sale " << r.saleId << " and restored stock\n";
+    };
+
     while (true) {
         cout << "\n=== Supermarket Menu ===\n";
         cout << "1.  View Products\n";
@@ -504,6 +1199,16 @@ inline void SupermarketSystem::interactive_console() {
         cout << "14. Print sales report\n";
         cout << "15. Show customer cart\n";
         cout << "16. Exit\n";
+        cout << "17. Archive & export\n";
+        cout << "18. Customers who bought X also bought\n";
+        cout << "19. Customer purchase history\n";
+        cout << "20. Live dashboard\n";
+        cout << "21. Operation metrics\n";
+        cout << "22. End customer visit (abandon cart)\n";
+        cout << "23. Fulfil online orders in waves\n";
+        cout << "24. Stock audit\n";
+        cout << "25. Memory report\n";
+        cout << "26. Scan a barcode stream into a cart\n";
 
         int ch = read_int("Choose: ", -1);
         if (ch == -1) { cout << "Invalid input, try again.\n"; continue; }
@@ -515,12 +1220,45 @@ inline void SupermarketSystem::interactive_console() {
                 cout << "1. Print inventory\n";
                 cout << "2. Print products sorted by price\n";
                 cout << "3. Print products sorted by category\n";
+                cout << "4. Browse a listing page by page\n";
+                cout << "5. Write a listing to a file\n";
                 cout << "99. Back to main menu\n";
                 int subch = read_int("Choose: ", -1);
                 if (subch == -1) { cout << "Invalid input, try again.\n"; continue; }
-                if (subch == 1) print_inventory();
-                else if (subch == 2) print_products_sorted_price();
-                else if (subch == 3) print_products_sorted_category();
+                auto listing = [&](int which, RowWindow w, const OutputSink& sink) {
+                    if (which == 2) print_products_sorted_price(w, sink);
+                    else if (which == 3) print_products_sorted_category(w, sink);
+                    else print_inventory(w, sink);
+                };
+                if (subch >= 1 && subch <= 3) listing(subch, RowWindow(), console_sink());
+                else if (subch == 4) {
+                    int which = read_int("Listing (1 inventory, 2 by price, 3 by category): ", 1);
+                    const size_t perPage = 20;
+                    size_t pages = max<size_t>(1, (product_count() + perPage - 1) / perPage), page = 0;
+                    while (true) {
+                        listing(which, RowWindow{page * perPage, perPage}, console_sink());
+                        cout << "Page " << page + 1 << "/" << pages << " (Enter: next, p: previous, number: go to page, q: back)\n";
+                        string in = trim(read_line("> "));
+                        if (in == "q") break;
+                        if (in == "p") { if (page > 0) page--; }
+                        else if (in.empty()) { if (page + 1 < pages) page++; else break; }
+                        else {
+                            int n = 0;
+                            try { n = stoi(in); } catch (...) { n = 0; }
+                            if (n >= 1 && (size_t)n <= pages) page = (size_t)n - 1;
+                            else cout << "No such page\n";
+                        }
+                    }
+                }
+                else if (subch == 5) {
+                    int which = read_int("Listing (1 inventory, 2 by price, 3 by category): ", 1);
+                    string path = trim(read_line("File: "));
+                    FILE* f = path.empty() ? nullptr : fopen(path.c_str(), "wb");
+                    if (!f) { cout << "Cannot open " << path << '\n'; continue; }
+                    listing(which, RowWindow(), file_sink(f));
+                    bool ok = fclose(f) == 0;
+                    cout << (ok ? "Wrote " : "Failed writing ") << path << '\n';
+                }
                 else if (subch == 99) break;
                 else cout << "Unknown option\n";
             }
@@ -539,7 +1277,8 @@ inline void SupermarketSystem::interactive_console() {
             try { stock = stoi(stock_s); } catch(...) { cout << "Invalid stock, using 0.\n"; }
             if (price < 0.0) { cout << "Price cannot be negative. Aborting add.\n"; continue; }
             if (stock < 0) { cout << "Stock cannot be negative. Aborting add.\n"; continue; }
-            if (inventory.add_product(Product(bc,name,price,stock,exp,cat))) cout << "Product added\n"; else cout << "Product exists\n";
+            Status st = add_product(Product(bc,name,price,stock,exp,cat));
+            if (st == Status::Ok) cout << "Product added\n"; else cout << status_message(st) << '\n';
             rebuild_bst();
         }
         else if (ch == 3) {
@@ -548,15 +1287,11 @@ inline void SupermarketSystem::interactive_console() {
 
             string type = read_line("is the Customer Type (Specialcustomer) (y/n) : ");
             if (type=="y" || type=="Y"){
-                if (customers.count(id)) {
-                    cout << "Customer exists\n"; 
-                    continue;
-                }
-                customers[id] = make_unique<SpecialCustomer>(id, name);
-                cout << "Special Customer added\n"; 
+                if (add_special_customer(id, name) == Status::Ok) cout << "Special Customer added\n";
+                else cout << "Customer exists\n";
             }
             else {
-                if (add_walkin_customer(id, name)) cout << "Walk-in added\n";
+                if (add_walkin_customer(id, name) == Status::Ok) cout << "Walk-in added\n";
                 else cout << "Customer exists\n";
             }
         }
@@ -566,7 +1301,7 @@ inline void SupermarketSystem::interactive_console() {
             string addr = read_line("Address: ");
             string pay = read_line("Payment method: ");
             int pr = -1; try { pr = stoi(read_line("Priority (1-10): ")); } catch(...) { pr = 5; }
-            if (add_online_customer(id,name,addr,pay,pr)) cout << "Online customer added\n"; else cout << "Customer exists\n";
+            if (add_online_customer(id,name,addr,pay,pr) == Status::Ok) cout << "Online customer added\n"; else cout << "Customer exists\n";
         }
         else if (ch == 5) {
             string cid = read_line("Customer ID: ");
@@ -575,7 +1310,10 @@ inline void SupermarketSystem::interactive_console() {
                 string bc = read_line("Product Barcode: ");
                 if (bc.empty()) { cout << "Invalid barcode\n"; break; }
                 int qty = -1; try { qty = stoi(read_line("Quantity: ")); } catch(...) { qty = 1; }
-                customer_add_to_cart(cid, bc, qty);
+                CartResult r = customer_add_to_cart(cid, bc, qty);
+                if (r.status == Status::Ok) cout << "Added " << r.qty << " x " << r.productName << " to " << r.customerName << " cart.\n";
+                else if (r.status == Status::OutOfStock) cout << "Not enough stock. Available: " << r.available << '\n';
+                else cout << status_message(r.status) << '\n';
                 string more = read_line("Add another item for this customer? (y/n): ");
                 if (more.empty() || (more[0] != 'y' && more[0] != 'Y')) break;
             }
@@ -584,17 +1322,18 @@ inline void SupermarketSystem::interactive_console() {
             string cid = read_line("Customer ID: ");
             string bc = read_line("Product Barcode: ");
             int qty = -1; try { qty = stoi(read_line("Quantity: ")); } catch(...) { qty = 1; }
-            Customer* c = get_customer(cid);
-            if (!c) { cout << "Customer not found\n"; continue; }
-            int removed = c->cart.remove_item(bc, qty);
-            if (removed > 0) { inventory.update_stock(bc, removed); cout << "Removed " << removed << " x " << bc << " from " << c->get_name() << " cart.\n"; }
-            else cout << "No such item in cart\n";
+            CartResult r = customer_remove_from_cart(cid, bc, qty);
+            if (r.status == Status::Ok) cout << "Removed " << r.qty << " x " << bc << " from " << r.customerName << " cart.\n";
+            else cout << status_message(r.status) << '\n';
         }
         else if (ch == 7) {
-            string cid = read_line("Customer ID: "); auto res = customer_undo(cid); cout << res.second << '\n';
+            string cid = read_line("Customer ID: "); CartUndoResult r = customer_undo(cid);
+            if (r.status != Status::Ok) cout << status_message(r.status) << '\n';
+            else if (r.wasAdd) cout << "Undid add: restored " << r.qty << " items to inventory\n";
+            else cout << "Undid remove: returned " << r.qty << " items to cart\n";
         }
-        else if (ch == 8) { string cid = read_line("Customer ID: "); enqueue_walkin_to_cashier(cid); }
-        else if (ch == 9) { string cid = read_line("Customer ID: "); place_online_order(cid); }
+        else if (ch == 8) { string cid = read_line("Customer ID: "); print_enqueue(enqueue_walkin_to_cashier(cid)); }
+        else if (ch == 9) { string cid = read_line("Customer ID: "); print_enqueue(place_online_order(cid)); }
         else if (ch == 10) {
             while (true) {
                 cout << "\n=== Process Checkout ===\n";
@@ -604,37 +1343,111 @@ inline void SupermarketSystem::interactive_console() {
                 cout << "99. Back to main menu\n";
                 int subch = read_int("Choose: ", -1);
                 if (subch == -1) { cout << "Invalid input, try again.\n"; continue; }
-                if (subch == 1) { int idx = -1; try { idx = stoi(read_line("Cashier index: ")); } catch(...) { idx = 0; } process_checkout_at_cashier(idx); }
-                else if (subch == 2) process_checkout_at_specialneedscashier();
-                else if (subch == 3) process_next_online_order();
+                if (subch == 1) {
+                    int idx = -1; try { idx = stoi(read_line("Cashier index: ")); } catch(...) { idx = 0; }
+                    string coupon = cashier_queue_length(idx) ? read_coupon() : "";
+                    print_checkout(process_checkout_at_cashier(idx, coupon));
+                }
+                else if (subch == 2) print_checkout(process_checkout_at_specialneedscashier(special_queue_length() ? read_coupon() : ""));
+                else if (subch == 3) print_checkout(process_next_online_order(online_queue_length() ? read_coupon() : ""));
                 else if (subch == 99) break;
                 else cout << "Unknown option\n";
             }
         }
-        else if (ch == 11) { int idx = -1; try { idx = stoi(read_line("Cashier index: ")); } catch(...) { idx = 0; } cashier_undo_last_bill(idx); }
-        else if (ch == 12) cashier_undo_last_specialneedscashier_bill();
+        else if (ch == 11) { int idx = -1; try { idx = stoi(read_line("Cashier index: ")); } catch(...) { idx = 0; } print_bill_undo(cashier_undo_last_bill(idx)); }
+        else if (ch == 12) print_bill_undo(cashier_undo_last_specialneedscashier_bill());
         else if (ch == 13) list_customers();
         else if (ch == 14) print_sales_report();
         else if (ch == 15) { string cid = read_line("Customer ID: "); show_customer_cart(cid); }
         else if (ch == 16) { cout << "THANK YOU FOR USING OUR SYSTEM\n"; break; }
+        else if (ch == 18) { string bc = trim(read_line("Product Barcode: ")); print_bought_together(bc); }
+        else if (ch == 19) { string cid = read_line("Customer ID: "); print_customer_history(cid); }
+        else if (ch == 20) print_live_dashboard();
+        else if (ch == 21) {
+            print_metrics_table(cout);
+            string path = trim(read_line("Write JSON dump to file (Enter to skip): "));
+            if (!path.empty()) {
+                ofstream out(path);
+                write_metrics_json(out);
+                cout << (out ? "Metrics written to " + path : string("Could not write ") + path) << '\n';
+            }
+        }
+        else if (ch == 22) {
+            string cid = read_line("Customer ID: ");
+            string fg = read_line("Forget the customer too? (y/n): ");
+            SessionEndResult r = end_session(cid, !fg.empty() && (fg[0] == 'y' || fg[0] == 'Y'));
+            if (r.status != Status::Ok) cout << status_message(r.status) << '\n';
+            else cout << "Visit of " << r.customerName << " ended: " << r.units << " items on " << r.lines
+                      << " lines back on the shelf" << (r.forgotten ? ", customer removed" : "") << '\n';
+        }
+        else if (ch == 23) {
+            int size = read_int("Orders per wave (Enter for 8): ", 8);
+            if (size <= 0) { cout << "Wave size must be positive.\n"; continue; }
+            size_t waveNo = 0;
+            WaveStats st = fulfil_online_waves((size_t)size, SIZE_MAX, 0, [&](const Wave& w) {
+                cout << "Wave " << ++waveNo << ": " << w.orders.size() << " orders, " << w.picks.size() << " pick lines\n";
+                for (auto &p : w.picks) {
+                    cout << "   " << p.category << " | " << p.barcode << " | " << p.name << " | qty: " << p.qty << " | totes:";
+                    for (auto &t : p.totes) cout << ' ' << t.first + 1 << 'x' << t.second;
+                    cout << '\n';
+                }
+            });
+            if (st.waves == 0 && !st.logFailed) cout << "No online orders waiting\n";
+            else if (st.waves) cout << "Fulfilled " << st.orders << " orders in " << st.waves << " waves, " << st.units << " units"
+                      << (st.skipped ? " (" + to_string(st.skipped) + " empty carts skipped)" : string()) << '\n';
+            if (st.logFailed) cout << "Warning: " << status_message(Status::LogFailed) << '\n';
+        }
+        else if (ch == 24) print_stock_audit();
+        else if (ch == 25) {
+            MemoryReport m = memory_report();
+            print_memory_table(cout, m);
+            string path = trim(read_line("Write JSON dump to file (Enter to skip): "));
+            if (!path.empty()) {
+                ofstream out(path);
+                write_memory_json(out, m);
+                cout << (out ? "Memory report written to " + path : string("Could not write ") + path) << '\n';
+            }
+        }
+        else if (ch == 26) {
+            string cid = trim(read_line("Customer ID: "));
+            string path = trim(read_line("Scan file (one barcode per line): "));
+            bool framed = trim(read_line("Length-prefixed records? (y/N): ")) == "y";
+            FILE* f = path.empty() ? nullptr : fopen(path.c_str(), "rb");
+            if (!f) { cout << "Cannot open " << path << '\n'; continue; }
+            ScanReader in(f, framed ? ScanFraming::LengthPrefixed : ScanFraming::Lines);
+            ScanIngest r = scan_into_cart(cid, in);
+            fclose(f);
+            if (r.status != Status::Ok) { cout << status_message(r.status) << '\n'; continue; }
+            cout << "Reads: " << r.reads << " | valid: " << r.valid << " | bad check digit: " << r.badCheck
+                 << " | malformed: " << r.malformed << '\n';
+            cout << "Added " << r.units << " units in " << r.adds << " cart operations | not in catalog: " << r.unknown
+                 << " | out of stock: " << r.outOfStock << " | " << r.elapsedNs / 1000 << " us\n";
+        }
+        else if (ch == 17) {
+            while (true) {
+                cout << "\n=== Archive & Export ===\n";
+                cout << "1. Close day (archive today's sales)\n";
+                cout << "2. Report from archive file\n";
+                cout << "3. Export archive to CSV\n";
+                cout << "4. Export archive to JSON\n";
+                cout << "99. Back to main menu\n";
+                int subch = read_int("Choose: ", -1);
+                if (subch == -1) { cout << "Invalid input, try again.\n"; continue; }
+                if (subch == 1) {
+                    string path = close_day(trim(read_line("Archive directory (Enter for current): ")));
+                    if (path.empty()) cout << "Could not write archive\n"; else cout << "Day closed, sales archived to " << path << '\n';
+                }
+                else if (subch == 2) print_archive_report(trim(read_line("Archive file: ")));
+                else if (subch == 3 || subch == 4) {
+                    string src = trim(read_line("Archive file: "));
+                    string dst = trim(read_line("Output file: "));
+                    if (export_archive(src, dst, subch == 4)) cout << "Exported to " << dst << '\n';
+                    else cout << "Export failed\n";
+                }
+                else if (subch == 99) break;
+                else cout << "Unknown option\n";
+            }
+        }
         else cout << "Unknown option\n";
     }
 }
-
-// Implement Customer checkout methods now that SupermarketSystem is defined
-inline void Customer::checkout(SupermarketSystem& sys, int cashierIndex) {
-    (void)cashierIndex;
-    sys.enqueue_walkin_to_cashier(get_id());
-}
-inline void OnlineCustomer::checkout(SupermarketSystem& sys, int cashierIndex) {
-    (void)cashierIndex;
-    sys.place_online_order(get_id());
-}
-inline void SpecialCustomer::checkout(SupermarketSystem& sys, int cashierIndex) {
-    (void)cashierIndex;
-    sys.enqueue_specialneeds_to_cashier(this);
-}
-
-inline void Customer::print_info() const { cout << "Customer: " << id << " | " << name << " | Type: " << get_type() << '\n'; }
-inline void OnlineCustomer::print_info() const { cout << "OnlineCustomer: " << id << " | " << name << " | addr: " << address << " | pay: " << paymentMethod << " | priority: " << priority << '\n'; }
-inline void SpecialCustomer::print_info() const { cout << "SpecialCustomer: " << id << " | " << name << '\n'; }
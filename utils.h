@@ -2,12 +2,50 @@
 #pragma once
 #include <string>
 #include <ctime>
+#include <cstddef>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 using namespace std;
 
 
+// localtime() shares one buffer; the stores of a chain stamp sales on several threads
+inline tm local_time(time_t t) {
+    tm out;
+#ifdef _WIN32
+    localtime_s(&out, &t);
+#else
+    localtime_r(&t, &out);
+#endif
+    return out;
+}
+
 inline string now_string() {
-    time_t t = time(nullptr);
+    tm now = local_time(time(nullptr));
     char buf[64];
-    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&t));
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &now);
     return string(buf);
 }
+
+// peak resident memory of this process so far, in bytes (0 if unknown)
+inline size_t peak_memory_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)ru.ru_maxrss;        // bytes on macOS
+#else
+    return (size_t)ru.ru_maxrss * 1024; // kilobytes on Linux
+#endif
+#endif
+}
@@ -0,0 +1,579 @@
+// wal.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include "inventory.h"
+#include "sales.h"
+#include "mmap_file.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+// Write-ahead log of every state change that matters after a crash: catalog
+// additions, stock movements, committed sales and voided bills. Together with
+// the last checkpoint snapshot it rebuilds Inventory and SalesList exactly.
+//
+// Log file: a sequence of frames
+//     uint32 bodyLen | uint32 crc32(body) | body = uint64 lsn, uint8 type, payload
+// A torn or corrupt tail (crash mid-write) ends replay at the last good frame.
+// Snapshot file: "SMSN", uint32 version, body, uint32 crc32 of everything before.
+// Records with lsn <= the snapshot's lsn are already in the snapshot and skipped.
+const char WAL_SNAPSHOT_MAGIC[4] = {'S','M','S','N'};
+const uint32_t WAL_SNAPSHOT_VERSION = 1;
+
+enum WalRecordType : uint8_t {
+    WAL_PRODUCT = 1, // barcode, name, price, stock, expiry, category
+    WAL_STOCK = 2,   // barcode, delta, holder (customer whose cart moved it, "" = none)
+    WAL_SALE = 3,    // sale id, customer, cashier, online, total, time, items
+    WAL_VOID = 4     // sale id, items put back on the shelf
+};
+
+inline uint32_t crc32_update(uint32_t crc, const char* p, size_t n) {
+    static uint32_t table[256];
+    static bool ready = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ (uint8_t)p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// little append-only encoder; integers are stored in host byte order like the archive
+struct WalBuffer {
+    vector<char> bytes;
+
+    size_t size() const { return bytes.size(); }
+    bool empty() const { return bytes.empty(); }
+    void clear() { bytes.clear(); }
+    void put_raw(const void* p, size_t n) { bytes.insert(bytes.end(), (const char*)p, (const char*)p + n); }
+    void put_u8(uint8_t v) { bytes.push_back((char)v); }
+    void put_u32(uint32_t v) { put_raw(&v, sizeof(v)); }
+    void put_i32(int32_t v) { put_raw(&v, sizeof(v)); }
+    void put_u64(uint64_t v) { put_raw(&v, sizeof(v)); }
+    void put_f64(double v) { put_raw(&v, sizeof(v)); }
+    void put_str(string_view s) { put_u32((uint32_t)s.size()); put_raw(s.data(), s.size()); }
+    void patch_u32(size_t at, uint32_t v) { memcpy(bytes.data() + at, &v, sizeof(v)); }
+};
+
+// bounds-checked decoder; once a read overruns, ok stays false
+struct WalCursor {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    WalCursor(const char* b, size_t n) : p(b), end(b + n) {}
+    bool take(void* out, size_t n) {
+        if (!ok || (size_t)(end - p) < n) { ok = false; return false; }
+        memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    uint8_t u8() { uint8_t v = 0; take(&v, 1); return v; }
+    uint32_t u32() { uint32_t v = 0; take(&v, 4); return v; }
+    int32_t i32() { int32_t v = 0; take(&v, 4); return v; }
+    uint64_t u64() { uint64_t v = 0; take(&v, 8); return v; }
+    double f64() { double v = 0; take(&v, 8); return v; }
+    string str() {
+        uint32_t n = u32();
+        if (!ok || (size_t)(end - p) < n) { ok = false; return string(); }
+        string s(p, n);
+        p += n;
+        return s;
+    }
+};
+
+inline void wal_put_product(WalBuffer& b, const Product& p) {
+    b.put_str(p.barcode); b.put_str(p.name); b.put_f64(p.price);
+    b.put_i32(p.stock); b.put_str(p.expiry); b.put_str(p.category);
+}
+
+inline Product wal_get_product(WalCursor& c) {
+    Product p;
+    p.barcode = c.str(); p.name = c.str(); p.price = c.f64();
+    p.stock = c.i32(); p.expiry = c.str(); p.category = c.str();
+    return p;
+}
+
+inline void wal_put_items(WalBuffer& b, const vector<pair<string,int>>& items) {
+    b.put_u32((uint32_t)items.size());
+    for (auto &it : items) { b.put_str(it.first); b.put_i32(it.second); }
+}
+
+inline vector<pair<string,int>> wal_get_items(WalCursor& c) {
+    vector<pair<string,int>> items;
+    uint32_t n = c.u32();
+    for (uint32_t i = 0; i < n && c.ok; ++i) {
+        string bc = c.str();
+        int q = c.i32();
+        items.emplace_back(move(bc), q);
+    }
+    return items;
+}
+
+inline void wal_put_sale(WalBuffer& b, const SaleRecord& s) {
+    b.put_str(s.saleId); b.put_str(s.customerId); b.put_str(s.cashierId);
+    b.put_u8(s.online ? 1 : 0); b.put_f64(s.total); b.put_str(s.time);
+    wal_put_items(b, s.items);
+}
+
+inline SaleRecord* wal_get_sale(WalCursor& c) {
+    string sid = c.str(), cid = c.str(), cash = c.str();
+    bool online = c.u8() != 0;
+    double total = c.f64();
+    string when = c.str();
+    vector<pair<string,int>> items = wal_get_items(c);
+    if (!c.ok) return nullptr;
+    SaleRecord* s = new SaleRecord(sid, cid, online, items, total, cash);
+    s->time = when;
+    return s;
+}
+
+// Units that sit in customers' carts: already off the shelf count, not sold
+// yet. A crash loses every cart, so recovery puts these back on the shelf.
+struct CartHolds {
+    unordered_map<string, unordered_map<string,int>> byCustomer;
+
+    // a stock delta made by a cart: negative = taken from the shelf
+    void move(const string& cust, const string& barcode, int delta) {
+        auto &held = byCustomer[cust];
+        int h = held[barcode] - delta;
+        if (h > 0) held[barcode] = h; else held.erase(barcode);
+        if (held.empty()) byCustomer.erase(cust);
+    }
+    // sold units leave through the sale, not back to the shelf
+    void release(const string& cust, const vector<pair<string,int>>& items) {
+        for (auto &it : items) move(cust, it.first, it.second);
+    }
+};
+
+// append-only file descriptor with an explicit durability barrier
+class WalFile {
+private:
+    int fd = -1;
+
+public:
+    WalFile() = default;
+    WalFile(const WalFile&) = delete;
+    WalFile& operator=(const WalFile&) = delete;
+    ~WalFile() { close(); }
+
+    bool open(const string& path, bool truncate) {
+        close();
+#ifdef _WIN32
+        int flags = _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0);
+        fd = _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+        fd = ::open(path.c_str(), flags, 0644);
+#endif
+        return fd >= 0;
+    }
+    void close() {
+#ifdef _WIN32
+        if (fd >= 0) _close(fd);
+#else
+        if (fd >= 0) ::close(fd);
+#endif
+        fd = -1;
+    }
+    bool is_open() const { return fd >= 0; }
+
+    bool write_all(const char* p, size_t n) {
+        while (n > 0) {
+#ifdef _WIN32
+            int w = _write(fd, p, (unsigned)min(n, (size_t)1 << 30));
+#else
+            ssize_t w = ::write(fd, p, n);
+#endif
+            if (w <= 0) return false;
+            p += w;
+            n -= (size_t)w;
+        }
+        return true;
+    }
+    bool sync() {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#elif defined(__APPLE__)
+        return fsync(fd) == 0;
+#else
+        return fdatasync(fd) == 0;
+#endif
+    }
+    bool truncate() {
+#ifdef _WIN32
+        return _chsize_s(fd, 0) == 0;
+#else
+        return ftruncate(fd, 0) == 0;
+#endif
+    }
+};
+
+struct WalOptions {
+    size_t groupBytes = 64 * 1024; // flush as soon as this much is waiting
+    int groupMicros = 2000;        // ... or when the oldest waiting record is this old
+    bool durable = true;           // fsync every group (off: leave it to the OS cache)
+    bool syncCommit = false;       // checkouts/voids wait until their group is on disk
+    uint64_t checkpointEvery = 200000; // records between automatic snapshots (0 = never)
+};
+
+// Group commit: the engine thread only encodes records into `pending`; a
+// flusher thread swaps the buffer out and writes + fsyncs a whole group at a
+// time, so one fsync covers every record that arrived inside the window.
+// A group that fails to write or sync is not durable, and the log fails for
+// good: nothing more is written after what may be a torn frame, so recovery
+// keeps every group that made it. A checkpoint starts it over.
+class WriteAheadLog {
+private:
+    WalOptions opt;
+    WalFile file;
+    mutex m;
+    condition_variable wake;    // flusher: work to do
+    condition_variable flushed; // sync(): a group reached the disk
+    WalBuffer pending, writing;
+    thread flusher;
+    bool stopping = false;
+    bool syncWanted = false;
+    bool failed = false;
+    uint64_t lastLsn = 0;    // last record appended
+    uint64_t durableLsn = 0; // last record known to be on disk
+    uint64_t sinceCheckpoint = 0;
+    uint64_t groups = 0;
+    CartHolds holds;
+
+    size_t begin_record(WalRecordType t) {
+        size_t at = pending.size();
+        pending.put_u32(0);
+        pending.put_u32(0);
+        pending.put_u64(++lastLsn);
+        pending.put_u8(t);
+        return at;
+    }
+    void end_record(size_t at, bool wasEmpty) {
+        size_t body = at + 8;
+        uint32_t len = (uint32_t)(pending.size() - body);
+        pending.patch_u32(at, len);
+        pending.patch_u32(at + 4, crc32_update(0, pending.bytes.data() + body, len));
+        sinceCheckpoint++;
+        if (wasEmpty || pending.size() >= opt.groupBytes) wake.notify_one();
+    }
+
+    void flush_loop() {
+        unique_lock<mutex> g(m);
+        for (;;) {
+            wake.wait(g, [&] { return stopping || syncWanted || !pending.empty(); });
+            if (!stopping && !syncWanted)
+                wake.wait_for(g, chrono::microseconds(opt.groupMicros),
+                              [&] { return stopping || syncWanted || pending.size() >= opt.groupBytes; });
+            syncWanted = false;
+            if (failed) pending.clear(); // past a failed group nothing can be made durable
+            if (!pending.empty()) {
+                swap(pending, writing);
+                uint64_t upto = lastLsn;
+                g.unlock();
+                bool ok = file.write_all(writing.bytes.data(), writing.size()) && (!opt.durable || file.sync());
+                writing.clear();
+                g.lock();
+                if (ok) durableLsn = upto;
+                else failed = true;
+                groups++;
+            }
+            flushed.notify_all();
+            if (stopping && pending.empty()) return;
+        }
+    }
+
+public:
+    WriteAheadLog() = default;
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    ~WriteAheadLog() { close(); }
+
+    // starts an empty log whose first record will be baseLsn + 1
+    bool open(const string& path, uint64_t baseLsn, const CartHolds& heldInCarts, const WalOptions& o) {
+        close();
+        opt = o;
+        if (!file.open(path, true)) return false;
+        lastLsn = durableLsn = baseLsn;
+        sinceCheckpoint = 0;
+        failed = stopping = syncWanted = false;
+        holds = heldInCarts;
+        flusher = thread(&WriteAheadLog::flush_loop, this);
+        return true;
+    }
+
+    void close() {
+        if (!flusher.joinable()) return;
+        {
+            lock_guard<mutex> g(m);
+            stopping = true;
+        }
+        wake.notify_one();
+        flusher.join();
+        file.close();
+    }
+
+    bool is_open() const { return file.is_open(); }
+
+    void log_product(const Product& p) {
+        lock_guard<mutex> g(m);
+        bool wasEmpty = pending.empty();
+        size_t at = begin_record(WAL_PRODUCT);
+        wal_put_product(pending, p);
+        end_record(at, wasEmpty);
+    }
+
+    void log_stock(const string& barcode, int delta, const string& holder = "") {
+        if (delta == 0) return;
+        lock_guard<mutex> g(m);
+        bool wasEmpty = pending.empty();
+        size_t at = begin_record(WAL_STOCK);
+        pending.put_str(barcode);
+        pending.put_i32(delta);
+        pending.put_str(holder);
+        end_record(at, wasEmpty);
+        if (!holder.empty()) holds.move(holder, barcode, delta);
+    }
+
+    uint64_t log_sale(const SaleRecord& s) {
+        lock_guard<mutex> g(m);
+        bool wasEmpty = pending.empty();
+        size_t at = begin_record(WAL_SALE);
+        wal_put_sale(pending, s);
+        end_record(at, wasEmpty);
+        holds.release(s.customerId, s.items);
+        return lastLsn;
+    }
+
+    uint64_t log_void(const SaleRecord& s) {
+        lock_guard<mutex> g(m);
+        bool wasEmpty = pending.empty();
+        size_t at = begin_record(WAL_VOID);
+        pending.put_str(s.saleId);
+        wal_put_items(pending, s.items);
+        end_record(at, wasEmpty);
+        return lastLsn;
+    }
+
+    // blocks until every record up to lsn (default: all so far) is on disk;
+    // false if they never will be
+    bool sync(uint64_t lsn = UINT64_MAX) {
+        unique_lock<mutex> g(m);
+        uint64_t target = min(lsn, lastLsn);
+        if (durableLsn < target && !failed) {
+            syncWanted = true;
+            wake.notify_one();
+            flushed.wait(g, [&] { return durableLsn >= target || failed || !flusher.joinable(); });
+        }
+        return durableLsn >= target;
+    }
+    // what a commit point does: wait for the group only when syncCommit is set.
+    // false once the log has failed (without syncCommit, as far as is known yet)
+    bool commit(uint64_t lsn) {
+        if (opt.syncCommit) return sync(lsn);
+        lock_guard<mutex> g(m);
+        return !failed;
+    }
+
+    // after a checkpoint the log's contents are all in the snapshot; that
+    // includes whatever a failed log lost, so an emptied log starts over
+    bool truncate() {
+        sync();
+        lock_guard<mutex> g(m);
+        sinceCheckpoint = 0;
+        if (!file.truncate()) return false;
+        if (failed) { pending.clear(); durableLsn = lastLsn; failed = false; }
+        return true;
+    }
+
+    bool checkpoint_due() const { return opt.checkpointEvery && sinceCheckpoint >= opt.checkpointEvery; }
+    uint64_t last_lsn() { lock_guard<mutex> g(m); return lastLsn; }
+    uint64_t group_count() { lock_guard<mutex> g(m); return groups; }
+    CartHolds cart_holds() { lock_guard<mutex> g(m); return holds; }
+    // the group buffers (pending and the one being written) and the cart holds
+    MemoryUsage memory_usage() {
+        lock_guard<mutex> g(m);
+        MemoryUsage u("write-ahead log");
+        u.add(pending.size(), heap_block(pending.bytes.capacity()));
+        u.add(writing.size(), heap_block(writing.bytes.capacity()));
+        account_hash(u, holds.byCustomer);
+        for (auto &c : holds.byCustomer) {
+            account_string(u, c.first);
+            account_hash(u, c.second);
+            u.elements += c.second.size();
+            for (auto &h : c.second) account_string(u, h.first);
+        }
+        return u;
+    }
+    bool failed_io() { lock_guard<mutex> g(m); return failed; }
+};
+
+// Writes path via a temp file + rename so a crash leaves either the old or the
+// new snapshot. Ledger is newest first, as SalesList::ledger() returns it.
+inline bool write_wal_snapshot(const string& path, uint64_t lsn, int nextSale, const Inventory& inv,
+                               const CartHolds& holds, const vector<const SaleRecord*>& ledger) {
+    WalBuffer b;
+    b.put_raw(WAL_SNAPSHOT_MAGIC, 4);
+    b.put_u32(WAL_SNAPSHOT_VERSION);
+    b.put_u64(lsn);
+    b.put_u32((uint32_t)nextSale);
+    vector<Product> products = inv.all_products();
+    b.put_u32((uint32_t)products.size());
+    for (auto &p : products) wal_put_product(b, p);
+    b.put_u32((uint32_t)holds.byCustomer.size());
+    for (auto &c : holds.byCustomer) {
+        b.put_str(c.first);
+        b.put_u32((uint32_t)c.second.size());
+        for (auto &h : c.second) { b.put_str(h.first); b.put_i32(h.second); }
+    }
+    b.put_u32((uint32_t)ledger.size());
+    for (size_t i = ledger.size(); i-- > 0;) wal_put_sale(b, *ledger[i]);
+    b.put_u32(crc32_update(0, b.bytes.data(), b.size()));
+
+    string tmp = path + ".tmp";
+    WalFile f;
+    if (!f.open(tmp, true) || !f.write_all(b.bytes.data(), b.size()) || !f.sync()) return false;
+    f.close();
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(tmp.c_str(), path.c_str()) != 0) return false;
+    string dir = path.substr(0, path.find_last_of('/') == string::npos ? 0 : path.find_last_of('/'));
+    int dfd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (dfd >= 0) { fsync(dfd); ::close(dfd); } // make the rename itself durable
+    return true;
+#endif
+}
+
+struct RecoveryStats {
+    bool fromSnapshot = false;
+    uint64_t snapshotLsn = 0;
+    uint64_t lastLsn = 0;
+    size_t recordsReplayed = 0;
+    size_t recordsSkipped = 0; // already covered by the snapshot
+    size_t tornBytes = 0;      // unreadable tail of the log, dropped
+    size_t sales = 0;
+    int unitsReturned = 0;     // stock that was sitting in carts at the crash
+    double millis = 0.0;
+};
+
+// Rebuilds inventory and sales (both must be empty) from dir/snapshot.bin and
+// dir/wal.log. Open carts did not survive, so their units go back on the shelf.
+// nextSale is raised past every recovered sale id.
+inline bool recover_wal_state(const string& dir, Inventory& inv, SalesList& sales, int& nextSale,
+                              RecoveryStats& st, string* err = nullptr) {
+    auto fail = [&](const string& msg) { if (err) *err = msg; return false; };
+    auto start = chrono::steady_clock::now();
+    CartHolds holds;
+    vector<SaleRecord*> order; // oldest first; voided entries become nullptr
+    unordered_map<string, size_t> slot;
+    auto add_sale = [&](SaleRecord* s) {
+        slot[s->saleId] = order.size();
+        order.push_back(s);
+        size_t digits = s->saleId.find_first_of("0123456789");
+        if (digits != string::npos) nextSale = max(nextSale, atoi(s->saleId.c_str() + digits) + 1);
+    };
+
+    MappedFile snap;
+    if (snap.open(dir + "/snapshot.bin")) {
+        const char* d = snap.data();
+        size_t n = snap.size();
+        if (n < 12 || memcmp(d, WAL_SNAPSHOT_MAGIC, 4) != 0) return fail("not a snapshot file");
+        uint32_t crc;
+        memcpy(&crc, d + n - 4, 4);
+        if (crc != crc32_update(0, d, n - 4)) return fail("snapshot checksum mismatch");
+        WalCursor c(d + 4, n - 8);
+        if (c.u32() != WAL_SNAPSHOT_VERSION) return fail("unsupported snapshot version");
+        st.fromSnapshot = true;
+        st.snapshotLsn = c.u64();
+        nextSale = max(nextSale, (int)c.u32());
+        uint32_t products = c.u32();
+        inv.reserve(products);
+        for (uint32_t i = 0; i < products && c.ok; ++i) inv.add_product(wal_get_product(c));
+        uint32_t custs = c.u32();
+        for (uint32_t i = 0; i < custs && c.ok; ++i) {
+            string cust = c.str();
+            uint32_t k = c.u32();
+            for (uint32_t j = 0; j < k && c.ok; ++j) {
+                string bc = c.str();
+                holds.move(cust, bc, -c.i32());
+            }
+        }
+        uint32_t count = c.u32();
+        order.reserve(count);
+        for (uint32_t i = 0; i < count && c.ok; ++i) {
+            SaleRecord* s = wal_get_sale(c);
+            if (s) add_sale(s);
+        }
+        if (!c.ok) {
+            for (SaleRecord* s : order) delete s;
+            return fail("snapshot is truncated");
+        }
+    }
+
+    MappedFile log;
+    string logPath = dir + "/wal.log";
+    if (log.open(logPath)) {
+        const char* p = log.data();
+        const char* end = p + log.size();
+        while ((size_t)(end - p) >= 8) {
+            uint32_t len, crc;
+            memcpy(&len, p, 4);
+            memcpy(&crc, p + 4, 4);
+            if (len < 9 || (size_t)(end - p - 8) < len || crc32_update(0, p + 8, len) != crc) break;
+            WalCursor c(p + 8, len);
+            p += 8 + len;
+            uint64_t lsn = c.u64();
+            uint8_t type = c.u8();
+            st.lastLsn = max(st.lastLsn, lsn);
+            if (lsn <= st.snapshotLsn) { st.recordsSkipped++; continue; }
+            st.recordsReplayed++;
+            if (type == WAL_PRODUCT) {
+                inv.add_product(wal_get_product(c));
+            } else if (type == WAL_STOCK) {
+                string bc = c.str();
+                int delta = c.i32();
+                string holder = c.str();
+                if (Product* pr = inv.find(bc)) pr->stock += delta;
+                if (!holder.empty()) holds.move(holder, bc, delta);
+            } else if (type == WAL_SALE) {
+                SaleRecord* s = wal_get_sale(c);
+                if (s) { holds.release(s->customerId, s->items); add_sale(s); }
+            } else if (type == WAL_VOID) {
+                string sid = c.str();
+                for (auto &it : wal_get_items(c))
+                    if (Product* pr = inv.find(it.first)) pr->stock += it.second;
+                auto sl = slot.find(sid);
+                if (sl != slot.end()) { delete order[sl->second]; order[sl->second] = nullptr; slot.erase(sl); }
+            }
+        }
+        st.tornBytes = (size_t)(end - p);
+    }
+    st.lastLsn = max(st.lastLsn, st.snapshotLsn);
+
+    for (auto &c : holds.byCustomer)
+        for (auto &h : c.second)
+            if (Product* pr = inv.find(h.first)) { pr->stock += h.second; st.unitsReturned += h.second; }
+    for (SaleRecord* s : order) if (s) { sales.add_sale(s); st.sales++; }
+    st.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return true;
+}
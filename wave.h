@@ -0,0 +1,161 @@
+// wave.h
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include "results.h"
+#include "customer.h"
+#include "metrics.h"
+using namespace std;
+
+// Wave picking for online orders. The engine thread takes the next N orders by
+// priority and copies their carts into a Wave; a worker builds the wave's pick
+// list and prices its orders; the engine thread then commits the wave's sales
+// as one batch. Building runs on a WorkerPool, so while one wave is being
+// built the engine thread is already taking the next and committing the last.
+//
+// Stock for an online cart left the shelf when it was added (a cart hold), so
+// a wave does not reserve again: the pick list is the one pass that turns the
+// holds of every order in the wave into units per SKU for the pickers.
+
+// fixed set of threads running jobs in submission order
+class WorkerPool {
+private:
+    vector<thread> workers;
+    vector<function<void()>> jobs; // FIFO from head
+    size_t head = 0;
+    mutex m;
+    condition_variable cv;
+    bool stopping = false;
+
+    void loop() {
+        for (;;) {
+            function<void()> job;
+            {
+                unique_lock<mutex> g(m);
+                cv.wait(g, [&] { return stopping || head < jobs.size(); });
+                if (head == jobs.size()) return;
+                job = move(jobs[head++]);
+                if (head == jobs.size()) { jobs.clear(); head = 0; }
+            }
+            job();
+        }
+    }
+
+public:
+    explicit WorkerPool(unsigned threads = 0) {
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) workers.emplace_back(&WorkerPool::loop, this);
+    }
+    ~WorkerPool() {
+        { lock_guard<mutex> g(m); stopping = true; }
+        cv.notify_all();
+        for (auto &t : workers) t.join();
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template<typename F>
+    future<void> submit(F f) {
+        auto task = make_shared<packaged_task<void()>>(move(f));
+        future<void> done = task->get_future();
+        { lock_guard<mutex> g(m); jobs.push_back([task] { (*task)(); }); }
+        cv.notify_one();
+        return done;
+    }
+};
+
+// one order of a wave, as its cart was when the wave was taken
+struct WaveOrder {
+    VisitRef visit;
+    string customerId;
+    vector<ReceiptLine> lines;
+    double specialRate = 0.0;
+    double subtotal = 0.0;
+    double total = 0.0;      // after the special-needs rate and the 5% bulk discount
+    bool bulkDiscount = false;
+};
+
+// one SKU to pick: units for the whole wave, then how they split into totes
+struct PickLine {
+    string category; // doubles as the aisle
+    string barcode;
+    string name;
+    int qty = 0;
+    vector<pair<uint32_t, int>> totes; // (order index in the wave, units)
+};
+
+struct Wave {
+    vector<WaveOrder> orders;
+    vector<PickLine> picks;  // by category, then barcode
+    uint64_t buildNs = 0;
+};
+
+// what fulfil_online_waves did
+struct WaveStats {
+    size_t waves = 0;
+    size_t orders = 0;      // committed as sales
+    size_t skipped = 0;     // empty carts, or visits that ended before commit
+    size_t pickLines = 0;
+    size_t units = 0;
+    uint64_t buildNs = 0;   // summed over waves
+    uint64_t maxBuildNs = 0;
+    vector<string> saleIds;
+    bool logFailed = false; // the log failed: later waves were not taken, and sales since may not be on disk
+};
+
+// Same rule as a checkout: special-needs rate, then 5% off bills of LE 1000 and over.
+inline double bill_after_discounts(double afterCoupon, double specialRate, double* specialDiscount, bool* bulk) {
+    double tot = afterCoupon;
+    if (specialRate > 0.0) {
+        *specialDiscount = tot * specialRate;
+        tot = tot - *specialDiscount;
+    }
+    *bulk = tot >= 1000.0;
+    if (*bulk) tot = tot * 0.95;
+    return tot;
+}
+
+// Worker side: merges every order's lines into the pick list and prices the
+// orders. Touches nothing but the wave.
+inline void build_wave(Wave& w) {
+    METRIC_SCOPE(Metric::WaveBuild);
+    auto t0 = chrono::steady_clock::now();
+    struct Ref { const ReceiptLine* line; uint32_t order; };
+    vector<Ref> refs;
+    for (uint32_t i = 0; i < w.orders.size(); ++i) {
+        WaveOrder& o = w.orders[i];
+        o.subtotal = 0.0;
+        for (auto &l : o.lines) { refs.push_back(Ref{&l, i}); o.subtotal += l.unitPrice * l.qty; }
+        double specialDiscount = 0.0;
+        o.total = bill_after_discounts(o.subtotal, o.specialRate, &specialDiscount, &o.bulkDiscount);
+    }
+    sort(refs.begin(), refs.end(), [](const Ref& a, const Ref& b) {
+        int c = a.line->category.compare(b.line->category);
+        if (c != 0) return c < 0;
+        c = a.line->barcode.compare(b.line->barcode);
+        return c != 0 ? c < 0 : a.order < b.order;
+    });
+    w.picks.clear();
+    for (const Ref& r : refs) {
+        if (w.picks.empty() || w.picks.back().barcode != r.line->barcode) {
+            PickLine p;
+            p.category = r.line->category; p.barcode = r.line->barcode; p.name = r.line->name;
+            w.picks.push_back(move(p));
+        }
+        PickLine& p = w.picks.back();
+        p.qty += r.line->qty;
+        if (!p.totes.empty() && p.totes.back().first == r.order) p.totes.back().second += r.line->qty;
+        else p.totes.push_back({r.order, r.line->qty});
+    }
+    w.buildNs = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+}